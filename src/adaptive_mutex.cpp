@@ -0,0 +1,302 @@
+/**
+ * @file adaptive_mutex.cpp
+ * @brief Tutorial code for a mutex that spins briefly before it sleeps.
+ * @brief 在睡眠之前先短暂自旋的互斥锁的教程代码。
+ */
+
+// The critical section in add_count (mutex.cpp) is a single increment, only a
+// few nanoseconds of work. When std::mutex finds the lock taken, it may put
+// the thread to sleep in the kernel, and waking it up again costs a couple of
+// context switches, microseconds each. For such short critical sections it is
+// cheaper to wait a little in user space ("spin"), since the lock will most
+// likely be free again very soon.
+// add_count（mutex.cpp）中的临界区只是一次增加，只有几纳秒的工作。当std::mutex
+// 发现锁已被占用时，它可能会让线程在内核中睡眠，而再次唤醒它需要几次上下文切换，
+// 每次都要几微秒。对于这么短的临界区，在用户空间稍微等一会儿（"自旋"）更便宜，
+// 因为锁很可能马上就会再次空闲。
+
+// Spinning forever is a bad idea though: if the lock holder has been
+// preempted, or the critical section is long, the spinner burns a core that
+// the holder might need to finish. AdaptiveMutex therefore spins only for a
+// bounded number of rounds, backing off exponentially between attempts, and
+// then parks the thread on a futex, the Linux system call that std::mutex
+// itself is built on. It also remembers how long spinning took recently and
+// spins about that long next time ("adaptive"), much like glibc's adaptive
+// mutexes.
+// 但永远自旋是个坏主意：如果锁的持有者被抢占了，或者临界区很长，自旋的线程就会
+// 浪费一个持有者可能需要用来完成工作的核心。因此AdaptiveMutex只自旋有限的轮数，
+// 在两次尝试之间指数退避，然后把线程挂起在futex上，futex是std::mutex本身也基于的
+// Linux系统调用。它还会记住最近自旋花了多长时间，下次大约自旋同样长的时间
+// （"自适应"），这和glibc的自适应互斥锁很像。
+
+// AdaptiveMutex has lock, unlock and try_lock, so it satisfies the
+// BasicLockable and Lockable requirements, and std::scoped_lock,
+// std::unique_lock and std::lock_guard work with it unchanged.
+// AdaptiveMutex具有lock、unlock和try_lock，所以它满足BasicLockable和Lockable要求，
+// std::scoped_lock、std::unique_lock和std::lock_guard无需改动就可以使用它。
+
+// Includes std::min.
+// 包含std::min。
+#include <algorithm>
+// Includes std::atomic.
+// 包含std::atomic。
+#include <atomic>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as uint32_t.
+// 包含uint32_t等定宽整数类型。
+#include <cstdint>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes the mutex library header.
+// 包含互斥锁库头文件。
+#include <mutex>
+// Includes the thread library header.
+// 包含线程库头文件。
+#include <thread>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+// Includes the Linux futex system call.
+// 包含Linux的futex系统调用。
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Tells the CPU that this is a spin-wait loop. On x86 the pause instruction
+// slows the loop down a little, saving power and leaving more of the core to
+// its sibling hyper-thread, and avoids a costly pipeline flush when the lock
+// word finally changes.
+// 告诉CPU这是一个自旋等待循环。在x86上，pause指令会让循环稍微慢一点，节省电力，
+// 把核心更多地留给它的兄弟超线程，并且在锁字最终改变时避免代价高昂的流水线清空。
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// FutexWait sleeps as long as *word still equals expected. The kernel checks
+// the value and puts the thread to sleep atomically, so a FutexWake that
+// happens after the caller last read *word can never be missed. It may also
+// return early for no reason, so callers check the word again in a loop.
+// Outside Linux we fall back to yielding the CPU, which is correct but not
+// as efficient.
+// 只要*word仍然等于expected，FutexWait就会睡眠。内核会原子地检查值并让线程睡眠，
+// 所以在调用者最后一次读取*word之后发生的FutexWake永远不会丢失。它也可能无缘无故
+// 提前返回，所以调用者要在循环中再次检查这个字。在Linux以外我们退而让出CPU，这是
+// 正确的，但效率没有那么高。
+void FutexWait(std::atomic<uint32_t> &word, uint32_t expected) {
+#if defined(__linux__)
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32-bit word");
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    if (word.load(std::memory_order_relaxed) == expected) {
+        std::this_thread::yield();
+    }
+#endif
+}
+
+// Wakes up at most one thread sleeping in FutexWait on word.
+// 最多唤醒一个在word上的FutexWait中睡眠的线程。
+void FutexWakeOne(std::atomic<uint32_t> &word) {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    (void) word;
+#endif
+}
+
+// The lock word follows Ulrich Drepper's "Futexes Are Tricky": 0 means
+// unlocked, 1 locked with no sleepers, and 2 locked with possible sleepers.
+// unlock only makes a system call when the word was 2, so a lock that is
+// never contended never enters the kernel.
+// 锁字遵循Ulrich Drepper的"Futexes Are Tricky"：0表示未锁定，1表示已锁定且没有
+// 睡眠者，2表示已锁定且可能有睡眠者。unlock只在锁字为2时才进行系统调用，所以一个
+// 从未被竞争的锁永远不会进入内核。
+class AdaptiveMutex {
+public:
+    AdaptiveMutex() = default;
+
+    // Like std::mutex, a mutex cannot be copied or moved, since threads may
+    // be waiting on its address.
+    // 与std::mutex一样，互斥锁不能被拷贝或移动，因为可能有线程正在它的地址上等待。
+    AdaptiveMutex(const AdaptiveMutex &) = delete;
+    AdaptiveMutex &operator=(const AdaptiveMutex &) = delete;
+
+    void lock() {
+        if (try_lock() || Spin()) {
+            return;
+        }
+        // Announce that we are about to sleep by setting the word to 2. If it
+        // was 0, the exchange took the lock for us instead.
+        // 把锁字设置为2，宣告我们将要睡眠。如果它原来是0，这次交换反而为我们拿到了锁。
+        while (state_.exchange(kLockedWithSleepers, std::memory_order_acquire) != kUnlocked) {
+            FutexWait(state_, kLockedWithSleepers);
+        }
+    }
+
+    bool try_lock() {
+        uint32_t expected = kUnlocked;
+        return state_.compare_exchange_strong(expected, kLocked, std::memory_order_acquire,
+                                              std::memory_order_relaxed);
+    }
+
+    void unlock() {
+        if (state_.exchange(kUnlocked, std::memory_order_release) == kLockedWithSleepers) {
+            FutexWakeOne(state_);
+        }
+    }
+
+private:
+    static constexpr uint32_t kUnlocked = 0;
+    static constexpr uint32_t kLocked = 1;
+    static constexpr uint32_t kLockedWithSleepers = 2;
+
+    // The most pause instructions a thread may spend spinning in one lock
+    // call, and the most it pauses between two attempts.
+    // 一个线程在一次lock调用中最多可以花在自旋上的pause指令数，以及两次尝试之间最多
+    // 暂停的次数。
+    static constexpr int kMaxSpinPauses = 4096;
+    static constexpr int kMaxBackoff = 64;
+
+    // Spins until the lock is taken or the budget runs out. The budget is
+    // twice the recent spin length, so a lock that is usually released quickly
+    // keeps spinning, and a lock that spinning rarely wins soon spins very
+    // little. Between attempts the thread only reads the word (it does not
+    // write it, which would steal the cache line from the holder) and backs
+    // off exponentially, so that many spinners do not all retry at once.
+    // 自旋直到拿到锁或预算用完。预算是最近自旋长度的两倍，所以一个通常很快被释放的锁
+    // 会继续自旋，而一个自旋很少成功的锁很快就只自旋很少的时间。在两次尝试之间，线程
+    // 只读取锁字（不写它，写会把缓存行从持有者那里抢走），并且指数退避，这样许多自旋的
+    // 线程不会同时重试。
+    bool Spin() {
+        int budget = std::min(2 * spin_estimate_.load(std::memory_order_relaxed) + 16, kMaxSpinPauses);
+        int spent = 0;
+        for (int backoff = 1; spent < budget; backoff = std::min(2 * backoff, kMaxBackoff)) {
+            for (int i = 0; i < backoff; i++) {
+                CpuRelax();
+            }
+            spent += backoff;
+            if (state_.load(std::memory_order_relaxed) == kUnlocked && try_lock()) {
+                UpdateEstimate(spent);
+                return true;
+            }
+        }
+        // Spinning lost, so count it as zero: if it keeps losing, the
+        // estimate decays and we park sooner next time.
+        // 自旋失败了，所以把它记为零：如果它一直失败，估计值就会衰减，下次我们会更早
+        // 挂起。
+        UpdateEstimate(0);
+        return false;
+    }
+
+    // Moves the estimate one eighth of the way towards the latest spin
+    // length. Racing updates may lose each other, which is fine for a hint.
+    // 把估计值朝最近一次的自旋长度移动八分之一。竞争的更新可能会相互覆盖，对于一个
+    // 提示值来说这没有关系。
+    void UpdateEstimate(int spent) {
+        int estimate = spin_estimate_.load(std::memory_order_relaxed);
+        spin_estimate_.store(estimate + (spent - estimate) / 8, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint32_t> state_{kUnlocked};
+    std::atomic<int> spin_estimate_{kMaxSpinPauses / 8};
+};
+
+// Defining a global count variable and an adaptive mutex to be used by both
+// threads, as in mutex.cpp.
+// 与mutex.cpp中一样，定义一个全局计数变量和一个自适应互斥锁，供两个线程使用。
+int count = 0;
+AdaptiveMutex m;
+
+// One thread increments count under std::scoped_lock and the other under
+// std::unique_lock, to show that both work with AdaptiveMutex.
+// 一个线程在std::scoped_lock下增加count，另一个在std::unique_lock下增加，以展示
+// 两者都可以与AdaptiveMutex一起工作。
+void add_count_scoped() {
+    std::scoped_lock lock(m);
+    count += 1;
+}
+
+void add_count_unique() {
+    std::unique_lock<AdaptiveMutex> lock(m);
+    count += 1;
+}
+
+// Runs num_threads threads that together enter the critical section total_ops
+// times. Each critical section adds work_per_op numbers to a shared sum.
+// Returns throughput in million critical sections per second.
+// 运行num_threads个线程，它们一共进入临界区total_ops次。每个临界区把work_per_op个数
+// 加到一个共享的和上。返回以每秒百万个临界区计的吞吐量。
+template<typename Mutex>
+double RunCriticalSections(int num_threads, int total_ops, int work_per_op) {
+    Mutex mutex;
+    uint64_t sum = 0;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&mutex, &sum, num_threads, total_ops, work_per_op] {
+            for (int i = 0; i < total_ops / num_threads; i++) {
+                std::scoped_lock lock(mutex);
+                for (int j = 0; j < work_per_op; j++) {
+                    sum += j;
+                }
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    if (sum != static_cast<uint64_t>(total_ops / num_threads) * num_threads * work_per_op * (work_per_op - 1) / 2) {
+        std::cout << "    Lost updates!\n";
+    }
+    return total_ops / std::chrono::duration<double, std::micro>(stop - start).count();
+}
+
+// Compares std::mutex with AdaptiveMutex for short and long critical sections.
+// Spinning only helps when the holder is running on another core and will
+// release the lock soon; with more threads than cores, or long critical
+// sections, the adaptive estimate shrinks and AdaptiveMutex behaves much like
+// std::mutex.
+// 比较std::mutex与AdaptiveMutex在短临界区和长临界区下的表现。只有当持有者正在另一个
+// 核心上运行并且很快会释放锁时，自旋才有帮助；当线程多于核心，或者临界区很长时，
+// 自适应的估计值会缩小，AdaptiveMutex的行为就和std::mutex差不多了。
+void RunBenchmark() {
+    std::cout << "Throughput in M critical sections/s (" << std::thread::hardware_concurrency()
+              << " hardware threads):\n";
+    for (int work_per_op: {1, 1000}) {
+        const int total_ops = work_per_op == 1 ? 1 << 21 : 1 << 15;
+        std::cout << "  " << (work_per_op == 1 ? "Short" : "Long") << " critical sections (" << work_per_op
+                  << " additions):\n";
+        for (int num_threads = 1; num_threads <= 64; num_threads *= 4) {
+            double std_mops = RunCriticalSections<std::mutex>(num_threads, total_ops, work_per_op);
+            double adaptive_mops = RunCriticalSections<AdaptiveMutex>(num_threads, total_ops, work_per_op);
+            std::cout << "    " << num_threads << " threads: std::mutex " << std_mops << ", AdaptiveMutex "
+                      << adaptive_mops << "\n";
+        }
+    }
+}
+
+// The main method runs two threads as in mutex.cpp, one locking through
+// std::scoped_lock and one through std::unique_lock, then runs the benchmark.
+// main方法与mutex.cpp中一样运行两个线程，一个通过std::scoped_lock加锁，一个通过
+// std::unique_lock加锁，然后运行基准测试。
+int main() {
+    std::thread t1(add_count_scoped);
+    std::thread t2(add_count_unique);
+    t1.join();
+    t2.join();
+
+    std::cout << "Printing count: " << count << std::endl;
+
+    RunBenchmark();
+
+    return 0;
+}
@@ -0,0 +1,283 @@
+/**
+ * @file big_reader_lock.cpp
+ * @brief Tutorial code for a reader-writer lock with one reader slot per
+ * thread.
+ * @brief 每个线程一个读者槽的读写锁的教程代码。
+ */
+
+// std::shared_lock in rwlock.cpp lets many readers hold a std::shared_mutex
+// at once, but each of them still increments and decrements one reader count
+// inside the mutex. That count lives on a single cache line, which every
+// reader writes, so with many readers on many cores the line moves from core
+// to core and read throughput stops growing, even though the readers never
+// wait for each other.
+// rwlock.cpp中的std::shared_lock允许许多读者同时持有一个std::shared_mutex，但它们
+// 每个人仍然要增加和减少互斥锁内部的同一个读者计数。这个计数位于一个缓存行上，
+// 每个读者都要写它，所以当许多核心上有许多读者时，这个缓存行在核心之间来回移动，
+// 读吞吐量不再增长，即使读者之间从不相互等待。
+
+// A "big reader" lock (the name comes from the Linux kernel's brlock) gives
+// every thread its own reader count, each on its own cache line. A reader
+// only writes its own count, so readers on different cores never touch the
+// same cache line. The price is paid by writers, which must check every
+// reader count before they may enter. That is a good trade for data that is
+// read very often and written rarely, such as configuration or routing
+// tables.
+// "大读者"锁（这个名字来自Linux内核的brlock）给每个线程一个自己的读者计数，每个计数
+// 都在自己的缓存行上。读者只写自己的计数，所以不同核心上的读者永远不会访问同一个
+// 缓存行。代价由写者承担，它们在进入之前必须检查每个读者计数。对于读得非常频繁而
+// 很少写的数据（例如配置或路由表），这是很划算的交换。
+
+// BigReaderLock has lock, unlock, lock_shared and unlock_shared (and their try_
+// versions), so std::shared_lock and std::unique_lock work with it exactly as
+// they do with std::shared_mutex.
+// BigReaderLock具有lock、unlock、lock_shared和unlock_shared（以及它们的try_版本），
+// 所以std::shared_lock和std::unique_lock可以像使用std::shared_mutex一样使用它。
+
+// Includes std::array.
+// 包含std::array。
+#include <array>
+// Includes std::atomic.
+// 包含std::atomic。
+#include <atomic>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as uint64_t.
+// 包含uint64_t等定宽整数类型。
+#include <cstdint>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes the mutex library header.
+// 包含互斥锁库头文件。
+#include <mutex>
+// Includes the shared mutex library header.
+// 包含共享互斥锁库头文件。
+#include <shared_mutex>
+// Includes the C++ string library.
+// 包含C++字符串库。
+#include <string>
+// Includes the thread library header.
+// 包含线程库头文件。
+#include <thread>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+
+// The size of a cache line on x86 and most ARM cores. C++17 has
+// std::hardware_destructive_interference_size for this, but not every
+// compiler provides it yet.
+// x86和大多数ARM核心上缓存行的大小。C++17为此提供了
+// std::hardware_destructive_interference_size，但并不是每个编译器都已经支持它。
+constexpr size_t kCacheLineSize = 64;
+
+// Every thread gets a small index the first time it asks (see
+// sharded_counter.cpp).
+// 每个线程在第一次请求时得到一个小的下标（参见sharded_counter.cpp）。
+size_t ThreadIndex() {
+    static std::atomic<size_t> next_index{0};
+    thread_local size_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+// kNumSlots must be a power of two. Threads beyond kNumSlots share slots,
+// which is still correct since a slot holds a count, not a flag. Slots could
+// also be per core (sched_getcpu on Linux), but then a reader that moves to
+// another core while holding the lock must remember which slot to decrement.
+// kNumSlots必须是2的幂。超过kNumSlots的线程会共享槽，这仍然是正确的，因为槽保存的是
+// 计数而不是标志。槽也可以是每个核心一个（Linux上的sched_getcpu），但那样的话，一个在
+// 持有锁时移动到另一个核心的读者必须记住该减少哪个槽。
+template<size_t kNumSlots = 64>
+class BigReaderLock {
+    static_assert(kNumSlots > 0 && (kNumSlots & (kNumSlots - 1)) == 0, "kNumSlots must be a power of two");
+
+public:
+    BigReaderLock() = default;
+    BigReaderLock(const BigReaderLock &) = delete;
+    BigReaderLock &operator=(const BigReaderLock &) = delete;
+
+    // A reader announces itself in its slot and then checks for a writer. A
+    // writer announces itself in writer_ and then checks every slot. Both
+    // sides use sequentially consistent operations, so at least one of them
+    // sees the other's announcement and they never both get in. That holds
+    // only if the loads that check for the other side are sequentially
+    // consistent too; an acquire load may be ordered before the store that
+    // precedes it. If a writer is present, the reader takes its announcement
+    // back and waits.
+    // 读者在自己的槽中宣告自己，然后检查是否有写者。写者在writer_中宣告自己，然后检查
+    // 每个槽。双方都使用顺序一致的操作，所以至少有一方会看到另一方的宣告，它们永远
+    // 不会同时进入。只有当检查另一方的读取也是顺序一致的时候，这一点才成立；acquire
+    // 读取可能被排到它前面的写入之前。如果有写者，读者撤回自己的宣告并等待。
+    void lock_shared() {
+        while (!try_lock_shared()) {
+            while (writer_.load(std::memory_order_relaxed)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool try_lock_shared() {
+        std::atomic<int64_t> &readers = MySlot().readers;
+        readers.fetch_add(1, std::memory_order_seq_cst);
+        if (!writer_.load(std::memory_order_seq_cst)) {
+            return true;
+        }
+        readers.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    void unlock_shared() { MySlot().readers.fetch_sub(1, std::memory_order_release); }
+
+    // Writers take turns through writer_mutex_. Once writer_ is set no new
+    // reader gets in, so a writer only waits for the readers already inside.
+    // 写者通过writer_mutex_轮流进入。一旦writer_被设置，就不会有新的读者进入，所以写者
+    // 只需要等待已经在里面的读者。
+    void lock() {
+        writer_mutex_.lock();
+        writer_.store(true, std::memory_order_seq_cst);
+        for (const Slot &slot: slots_) {
+            while (slot.readers.load(std::memory_order_seq_cst) != 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool try_lock() {
+        if (!writer_mutex_.try_lock()) {
+            return false;
+        }
+        writer_.store(true, std::memory_order_seq_cst);
+        for (const Slot &slot: slots_) {
+            if (slot.readers.load(std::memory_order_seq_cst) != 0) {
+                writer_.store(false, std::memory_order_release);
+                writer_mutex_.unlock();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void unlock() {
+        writer_.store(false, std::memory_order_release);
+        writer_mutex_.unlock();
+    }
+
+private:
+    // Each slot fills a whole cache line (see sharded_counter.cpp).
+    // 每个槽占满一整个缓存行（参见sharded_counter.cpp）。
+    struct alignas(kCacheLineSize) Slot {
+        std::atomic<int64_t> readers{0};
+    };
+
+    Slot &MySlot() { return slots_[ThreadIndex() & (kNumSlots - 1)]; }
+
+    std::array<Slot, kNumSlots> slots_;
+    alignas(kCacheLineSize) std::atomic<bool> writer_{false};
+    std::mutex writer_mutex_;
+};
+
+// The program of rwlock.cpp, with m now a BigReaderLock. read_value and
+// write_value are unchanged.
+// rwlock.cpp中的程序，只是m现在是一个BigReaderLock。read_value和write_value没有改变。
+int count = 0;
+BigReaderLock<> m;
+
+void read_value() {
+    std::shared_lock lk(m);
+    std::cout << "Reading value " + std::to_string(count) + "\n" << std::flush;
+}
+
+void write_value() {
+    std::unique_lock lk(m);
+    count += 3;
+}
+
+// Runs num_threads readers that together take the shared lock total_ops
+// times and read a small struct under it. Returns Mops/s.
+// 运行num_threads个读者，它们一共获取共享锁total_ops次，并在锁下读取一个小结构体。
+// 返回Mops/s。
+template<typename Lock>
+double RunReaders(int num_threads, int total_ops) {
+    struct Config {
+        int64_t a = 1;
+        int64_t b = 2;
+    };
+    Lock lock;
+    Config config;
+    std::atomic<int64_t> checksum{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&lock, &config, &checksum, num_threads, total_ops] {
+            int64_t sum = 0;
+            for (int i = 0; i < total_ops / num_threads; i++) {
+                std::shared_lock guard(lock);
+                sum += config.a + config.b;
+            }
+            checksum += sum;
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    if (checksum != static_cast<int64_t>(total_ops / num_threads) * num_threads * 3) {
+        std::cout << "    Wrong checksum!\n";
+    }
+    return total_ops / std::chrono::duration<double, std::micro>(stop - start).count();
+}
+
+// Returns the average cost of an uncontended exclusive lock and unlock in ns.
+// 返回一次无竞争的独占加锁和解锁的平均开销，单位为纳秒。
+template<typename Lock>
+double MeasureWriterNs() {
+    const int ops = 1 << 16;
+    Lock lock;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ops; i++) {
+        std::unique_lock guard(lock);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / ops;
+}
+
+// Compares read throughput from 1 to 64 reader threads, and the cost a writer
+// pays for scanning every slot. Reader scaling needs readers on many cores at
+// once; with a single core neither lock has a cache line to bounce.
+// 比较1到64个读者线程下的读吞吐量，以及写者为扫描每个槽而付出的开销。读者的扩展
+// 需要许多核心上同时有读者；只有一个核心时，两种锁都没有来回传递的缓存行。
+void RunBenchmark() {
+    const int total_ops = 1 << 21;
+    std::cout << "Read throughput in Mops/s (" << std::thread::hardware_concurrency() << " hardware threads):\n";
+    for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+        double shared_mops = RunReaders<std::shared_mutex>(num_threads, total_ops);
+        double big_reader_mops = RunReaders<BigReaderLock<>>(num_threads, total_ops);
+        std::cout << "  " << num_threads << " readers: std::shared_mutex " << shared_mops << ", BigReaderLock "
+                  << big_reader_mops << "\n";
+    }
+    std::cout << "Uncontended write lock and unlock in ns: std::shared_mutex " << MeasureWriterNs<std::shared_mutex>()
+              << ", BigReaderLock " << MeasureWriterNs<BigReaderLock<>>() << "\n";
+}
+
+// The main method is the one from rwlock.cpp, followed by the benchmark.
+// main方法就是rwlock.cpp中的那个，之后运行基准测试。
+int main() {
+    std::thread t1(read_value);
+    std::thread t2(write_value);
+    std::thread t3(read_value);
+    std::thread t4(read_value);
+    std::thread t5(write_value);
+    std::thread t6(read_value);
+
+    t1.join();
+    t2.join();
+    t3.join();
+    t4.join();
+    t5.join();
+    t6.join();
+
+    RunBenchmark();
+
+    return 0;
+}
@@ -0,0 +1,1178 @@
+/**
+ * @file bplus_tree.cpp
+ * @brief Tutorial code for a cache-conscious, concurrent in-memory B+ tree.
+ * @brief 缓存友好的并发内存B+树的教程代码。
+ */
+
+// std::set (sets.cpp) is a binary tree, so finding a key touches about
+// log2(n) nodes, and every one of them is a separate heap allocation that is
+// likely to be a cache miss. Iterating in order is no better: going from one
+// element to the next follows parent and child pointers around the heap.
+// std::set（sets.cpp）是一棵二叉树，所以查找一个键要访问大约log2(n)个
+// 节点，而每个节点都是一次单独的堆分配，很可能会导致缓存未命中。按顺序
+// 遍历也好不到哪里去：从一个元素走到下一个元素需要在堆中沿着父子指针跳转。
+
+// A B+ tree instead packs many keys into each node. We size the nodes to a
+// few cache lines (or a whole page), so one node visit answers many
+// comparisons at once and the tree is only a handful of levels deep. All the
+// values live in the leaves, and the leaves are linked left to right, so a
+// range scan such as int_set.erase(int_set.find(9), int_set.end()) is just a
+// walk along a linked list of arrays. You will build a B+ tree index in
+// the 15-445/645 projects, so this file is a good warm-up!
+// B+树则把许多键打包到每个节点中。我们把节点大小设置为几个缓存行（或者一整
+// 个页），这样一次节点访问就能完成许多次比较，树也只有几层深。所有的值都存
+// 在叶子节点中，并且叶子节点从左到右链接起来，所以像
+// int_set.erase(int_set.find(9), int_set.end())这样的范围扫描只是沿着一个
+// 由数组组成的链表前进。你将在15-445/645的项目中构建一个B+树索引，所以本文件
+// 是一个很好的热身！
+
+// The tree is also safe to use from many threads at once. It uses optimistic
+// lock coupling (OLC): every node has a version counter instead of a
+// reader-writer lock. Readers never write to shared memory. They remember a
+// node's version, read the node, and then check that the version did not
+// change. If it did, a writer got in the way and the reader restarts from the
+// root. Writers lock only the nodes that they modify. See "Optimistic Lock
+// Coupling: A Scalable and Efficient General-Purpose Synchronization Method"
+// by Leis et al. for the details.
+// 这棵树还可以同时被多个线程安全地使用。它使用乐观锁耦合（OLC）：每个节点都
+// 有一个版本计数器，而不是读写锁。读者从不写共享内存。它们记住节点的版本，
+// 读取节点，然后检查版本没有改变。如果改变了，说明有写者插了进来，读者就从
+// 根节点重新开始。写者只锁住它们要修改的节点。详细内容请参见Leis等人的论文
+// "Optimistic Lock Coupling: A Scalable and Efficient General-Purpose
+// Synchronization Method"。
+
+// OLC replaces classic lock coupling ("crabbing"), where every node has its
+// own std::shared_mutex and a thread going down the tree locks the child
+// before it unlocks the parent. Readers take shared locks, so they never wait
+// for each other, but each lock_shared and unlock_shared still writes the
+// node's reader count. Every lookup starts at the root, so every lookup
+// writes the root's cache line, and with many cores that one line is passed
+// from core to core on every single lookup (see big_reader_lock.cpp). The
+// tree can also be built with crabbing, and the benchmark compares the two.
+// OLC取代的是经典的锁耦合（"螃蟹式"加锁）：每个节点都有自己的std::shared_mutex，
+// 线程在沿树向下走时先锁住孩子再解锁父节点。读者获取共享锁，所以它们从不相互等待，
+// 但每次lock_shared和unlock_shared仍然要写节点的读者计数。每次查找都从根节点开始，
+// 所以每次查找都会写根节点的缓存行，在多核上这一个缓存行在每次查找时都会从一个核心
+// 传到另一个核心（参见big_reader_lock.cpp）。这棵树也可以使用螃蟹式加锁来构建，
+// 基准测试会比较两者。
+
+// Includes std::lower_bound.
+// 包含std::lower_bound。
+#include <algorithm>
+// Includes std::atomic.
+// 包含std::atomic。
+#include <atomic>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as uint64_t.
+// 包含uint64_t等定宽整数类型。
+#include <cstdint>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes the random number library, used by the benchmark.
+// 包含随机数库，供基准测试使用。
+#include <random>
+// Includes the set container library header, for comparison.
+// 包含集合容器库头文件，用于对比。
+#include <set>
+// Includes the shared mutex library header.
+// 包含共享互斥锁库头文件。
+#include <shared_mutex>
+// Includes std::invalid_argument.
+// 包含std::invalid_argument。
+#include <stdexcept>
+// Includes the thread library header.
+// 包含线程库头文件。
+#include <thread>
+// Includes std::conditional_t.
+// 包含std::conditional_t。
+#include <type_traits>
+// Includes std::pair.
+// 包含std::pair。
+#include <utility>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+
+// OptLock is the version latch used for optimistic lock coupling. The version
+// is incremented by 2 when a writer locks the node, and by 2 again when it
+// unlocks it, so bit 1 tells whether the node is currently locked and every
+// completed write produces a new version number.
+// OptLock是乐观锁耦合使用的版本锁。写者锁住节点时版本加2，解锁时再加2，所以
+// 第1位表示节点当前是否被锁住，而每次完成的写入都会产生一个新的版本号。
+//
+// The fences are the ones of SeqLock in seqlock.cpp. A reader's copies of the
+// node must not be reordered after the validating read of the version, and a
+// writer's stores to the node must not be reordered before the version
+// change that locks it.
+// 这些栅栏与seqlock.cpp中SeqLock的栅栏相同。读者对节点的复制不能被重排到验证版本号
+// 的读取之后，而写者对节点的写入不能被重排到锁住它的版本号改变之前。
+class OptLock {
+public:
+    // Returns the current version. Sets restart if a writer holds the lock.
+    // 返回当前版本。如果有写者持有锁，则设置restart。
+    uint64_t ReadLockOrRestart(bool &restart) const {
+        uint64_t version = version_.load();
+        if ((version & 2) != 0) {
+            restart = true;
+        }
+        return version;
+    }
+
+    // Sets restart if the node changed since version was read.
+    // 如果节点在读取version之后发生了变化，则设置restart。
+    void CheckOrRestart(uint64_t version, bool &restart) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (version != version_.load()) {
+            restart = true;
+        }
+    }
+
+    // Atomically turns a read of version into a write lock. This only
+    // succeeds if nobody wrote the node since version was read.
+    // 原子地把对version的读取变为写锁。只有在读取version之后没有人写过该节点时
+    // 才会成功。
+    void UpgradeToWriteLockOrRestart(uint64_t version, bool &restart) {
+        if (!version_.compare_exchange_strong(version, version + 2)) {
+            restart = true;
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void WriteUnlock() { version_.fetch_add(2); }
+
+private:
+    std::atomic<uint64_t> version_{0};
+};
+
+// RelaxedAtomic<T> reads and writes like a T, but every access is a relaxed
+// atomic load or store. Optimistic readers copy node fields while a writer may
+// be changing them; with relaxed atomics that is not a data race, and the
+// copy is thrown away when validation fails. On x86 and ARM a relaxed access
+// compiles to an ordinary load or store.
+// RelaxedAtomic<T>的读写方式和T一样，但每次访问都是一次relaxed原子读取或写入。乐观
+// 的读者会在写者可能正在修改节点字段的同时复制它们；使用relaxed原子操作，这就不是
+// 数据竞争，验证失败时复制的结果会被丢弃。在x86和ARM上，relaxed访问会被编译成普通的
+// 读取或写入。
+template<typename T>
+class RelaxedAtomic {
+    static_assert(std::atomic<T>::is_always_lock_free, "RelaxedAtomic needs a lock-free std::atomic<T>");
+
+public:
+    RelaxedAtomic() : value_(T()) {}
+
+    operator T() const { return value_.load(std::memory_order_relaxed); }
+
+    RelaxedAtomic &operator=(const T &value) {
+        value_.store(value, std::memory_order_relaxed);
+        return *this;
+    }
+
+    RelaxedAtomic &operator=(const RelaxedAtomic &other) { return *this = static_cast<T>(other); }
+
+private:
+    std::atomic<T> value_;
+};
+
+// The value type used by BPlusTreeSet. It carries no data.
+// BPlusTreeSet使用的值类型。它不携带任何数据。
+struct Empty {};
+
+// BPlusTree maps keys of type Key to values of type Value. Both are stored as
+// RelaxedAtomic, so they must be trivially copyable and small enough for a
+// lock-free std::atomic. NodeBytes is the target size of a node: 256 bytes is
+// four cache lines, and 4096 bytes is a typical page. With kOptimistic set to
+// false, every node has a std::shared_mutex instead of an OptLock and threads
+// use classic lock coupling.
+// BPlusTree将Key类型的键映射到Value类型的值。两者都以RelaxedAtomic的形式存储，所以
+// 它们必须是可平凡复制的，并且小到足以使用无锁的std::atomic。NodeBytes是节点的目标
+// 大小：256字节是四个缓存行，4096字节是一个典型的页。kOptimistic为false时，每个节点
+// 有一个std::shared_mutex而不是OptLock，线程使用经典的锁耦合。
+template<typename Key, typename Value, size_t NodeBytes = 256, bool kOptimistic = true>
+class BPlusTree {
+    using Latch = std::conditional_t<kOptimistic, OptLock, std::shared_mutex>;
+
+    // is_leaf_ never changes, and a node is only reachable after a validated
+    // read of the pointer to it, so it can be read without validation. Every
+    // other field that readers copy optimistically is a RelaxedAtomic.
+    // is_leaf_永远不会改变，而且只有在对指向节点的指针进行验证过的读取之后才能到达
+    // 该节点，所以读取它不需要验证。读者乐观复制的其他每个字段都是RelaxedAtomic。
+    struct NodeBase {
+        explicit NodeBase(bool is_leaf) : is_leaf_(is_leaf) {}
+        mutable Latch lock_;
+        const bool is_leaf_;
+        RelaxedAtomic<uint16_t> count_;
+    };
+
+    static constexpr size_t kHeaderBytes = sizeof(NodeBase) + sizeof(void *);
+    static constexpr size_t kLeafCapacity = (NodeBytes - kHeaderBytes) / (sizeof(Key) + sizeof(Value));
+    static constexpr size_t kInnerCapacity = (NodeBytes - kHeaderBytes) / (sizeof(Key) + sizeof(void *));
+    static_assert(kLeafCapacity >= 4 && kInnerCapacity >= 4, "NodeBytes is too small for these types");
+
+    // Returns the index of the first key in keys[0, count) that is not less
+    // than key.
+    // 返回keys[0, count)中第一个不小于key的键的下标。
+    static size_t LowerBound(const RelaxedAtomic<Key> *keys, size_t count, const Key &key) {
+        auto less = [](const RelaxedAtomic<Key> &lhs, const Key &rhs) { return static_cast<Key>(lhs) < rhs; };
+        return std::lower_bound(keys, keys + count, key, less) - keys;
+    }
+
+    // Leaves hold sorted keys and their values, plus a pointer to the leaf on
+    // their right.
+    // 叶子节点保存有序的键和对应的值，以及一个指向其右边叶子节点的指针。
+    struct Leaf : NodeBase {
+        Leaf() : NodeBase(true) {}
+
+        bool IsFull() const { return this->count_ == kLeafCapacity; }
+
+        // Returns false if the key already exists.
+        // 如果键已存在则返回false。
+        bool Insert(const Key &key, const Value &value) {
+            size_t pos = LowerBound(keys_, this->count_, key);
+            if (pos < this->count_ && !(key < static_cast<Key>(keys_[pos]))) {
+                return false;
+            }
+            std::move_backward(keys_ + pos, keys_ + this->count_, keys_ + this->count_ + 1);
+            std::move_backward(values_ + pos, values_ + this->count_, values_ + this->count_ + 1);
+            keys_[pos] = key;
+            values_[pos] = value;
+            this->count_ = this->count_ + 1;
+            return true;
+        }
+
+        bool Erase(const Key &key) {
+            size_t pos = LowerBound(keys_, this->count_, key);
+            if (pos == this->count_ || key < static_cast<Key>(keys_[pos])) {
+                return false;
+            }
+            std::move(keys_ + pos + 1, keys_ + this->count_, keys_ + pos);
+            std::move(values_ + pos + 1, values_ + this->count_, values_ + pos);
+            this->count_ = this->count_ - 1;
+            return true;
+        }
+
+        // Moves the upper half of this leaf into a new right sibling. The
+        // largest key left in this leaf becomes the separator in the parent.
+        // 把该叶子节点的上半部分移到一个新的右兄弟节点中。留在该叶子节点中的最大
+        // 键成为父节点中的分隔键。
+        Leaf *Split(Key &separator) {
+            Leaf *right = new Leaf();
+            size_t keep = this->count_ / 2;
+            right->count_ = this->count_ - keep;
+            std::copy(keys_ + keep, keys_ + this->count_, right->keys_);
+            std::copy(values_ + keep, values_ + this->count_, right->values_);
+            right->next_ = next_;
+            this->count_ = keep;
+            next_ = right;
+            separator = keys_[keep - 1];
+            return right;
+        }
+
+        RelaxedAtomic<Key> keys_[kLeafCapacity];
+        RelaxedAtomic<Value> values_[kLeafCapacity];
+        RelaxedAtomic<Leaf *> next_;
+    };
+
+    // Inner nodes hold count_ separator keys and count_ + 1 children. Every
+    // key in children_[i] is less than or equal to keys_[i].
+    // 内部节点保存count_个分隔键和count_ + 1个孩子。children_[i]中的每个键都
+    // 小于或等于keys_[i]。
+    struct Inner : NodeBase {
+        Inner() : NodeBase(false) {}
+
+        bool IsFull() const { return this->count_ == kInnerCapacity; }
+
+        NodeBase *FindChild(const Key &key) const { return children_[LowerBound(keys_, this->count_, key)]; }
+
+        // Inserts separator and the new node to its right after a child split.
+        // 在孩子分裂后插入分隔键以及其右边的新节点。
+        void InsertChild(const Key &separator, NodeBase *right) {
+            size_t pos = LowerBound(keys_, this->count_, separator);
+            std::move_backward(keys_ + pos, keys_ + this->count_, keys_ + this->count_ + 1);
+            std::move_backward(children_ + pos + 1, children_ + this->count_ + 1, children_ + this->count_ + 2);
+            keys_[pos] = separator;
+            children_[pos + 1] = right;
+            this->count_ = this->count_ + 1;
+        }
+
+        // The middle key moves up to the parent, and the keys and children to
+        // its right move to a new inner node.
+        // 中间的键上移到父节点，它右边的键和孩子移到一个新的内部节点中。
+        Inner *Split(Key &separator) {
+            Inner *right = new Inner();
+            size_t mid = this->count_ / 2;
+            separator = keys_[mid];
+            right->count_ = this->count_ - mid - 1;
+            std::copy(keys_ + mid + 1, keys_ + this->count_, right->keys_);
+            std::copy(children_ + mid + 1, children_ + this->count_ + 1, right->children_);
+            this->count_ = mid;
+            return right;
+        }
+
+        RelaxedAtomic<Key> keys_[kInnerCapacity];
+        RelaxedAtomic<NodeBase *> children_[kInnerCapacity + 1];
+    };
+
+public:
+    // A forward iterator over the leaves. Iterators are meant for single
+    // threaded use, use Scan when other threads may be modifying the tree.
+    // 遍历叶子节点的前向迭代器。迭代器只适用于单线程，当其他线程可能正在修改
+    // 树时，请使用Scan。
+    class Iterator {
+    public:
+        Iterator(Leaf *leaf, size_t pos) : leaf_(leaf), pos_(pos) { SkipEmpty(); }
+
+        std::pair<Key, Value> operator*() const { return {leaf_->keys_[pos_], leaf_->values_[pos_]}; }
+        Key key() const { return leaf_->keys_[pos_]; }
+        Value value() const { return leaf_->values_[pos_]; }
+
+        Iterator &operator++() {
+            pos_++;
+            SkipEmpty();
+            return *this;
+        }
+
+        bool operator==(const Iterator &other) const { return leaf_ == other.leaf_ && pos_ == other.pos_; }
+        bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+    private:
+        // Moves to the next leaf when we run off the end of this one. Leaves
+        // can be empty, since erase does not merge nodes.
+        // 当走到当前叶子节点末尾时移到下一个叶子节点。叶子节点可能是空的，因为
+        // erase不会合并节点。
+        void SkipEmpty() {
+            while (leaf_ != nullptr && pos_ >= leaf_->count_) {
+                leaf_ = leaf_->next_;
+                pos_ = 0;
+            }
+        }
+
+        Leaf *leaf_;
+        size_t pos_;
+    };
+
+    BPlusTree() : root_(new Leaf()) {}
+    ~BPlusTree() { FreeSubtree(root_.load()); }
+
+    BPlusTree(const BPlusTree &) = delete;
+    BPlusTree &operator=(const BPlusTree &) = delete;
+
+    // Inserts the pair. Returns false if the key was already present.
+    // 插入键值对。如果键已经存在则返回false。
+    bool insert(const Key &key, const Value &value = Value()) {
+        if constexpr (!kOptimistic) {
+            // Most inserts do not split a node, so first try with only the
+            // leaf locked exclusively.
+            // 大多数插入不会分裂节点，所以先尝试只以独占方式锁住叶子节点。
+            Leaf *leaf = LockLeaf(key, true);
+            if (!leaf->IsFull()) {
+                bool inserted = leaf->Insert(key, value);
+                leaf->lock_.unlock();
+                return inserted;
+            }
+            leaf->lock_.unlock();
+        }
+        while (true) {
+            bool inserted = false;
+            if constexpr (kOptimistic) {
+                if (TryInsert(key, value, inserted)) {
+                    return inserted;
+                }
+            } else {
+                if (TryInsertExclusive(key, value, inserted)) {
+                    return inserted;
+                }
+            }
+        }
+    }
+
+    size_t count(const Key &key) const {
+        Value value;
+        return Lookup(key, value) ? 1 : 0;
+    }
+
+    // Copies the value for key into value. Returns false if key is absent.
+    // 将key对应的值复制到value中。如果key不存在则返回false。
+    bool Lookup(const Key &key, Value &value) const {
+        if constexpr (!kOptimistic) {
+            Leaf *leaf = LockLeaf(key, false);
+            size_t pos = LowerBound(leaf->keys_, leaf->count_, key);
+            bool found = pos < leaf->count_ && !(key < static_cast<Key>(leaf->keys_[pos]));
+            if (found) {
+                value = leaf->values_[pos];
+            }
+            leaf->lock_.unlock_shared();
+            return found;
+        } else {
+            while (true) {
+                bool restart = false;
+                uint64_t version;
+                Leaf *leaf = TraverseToLeaf(key, version, restart);
+                if (restart) {
+                    continue;
+                }
+                size_t pos = LowerBound(leaf->keys_, leaf->count_, key);
+                bool found = pos < leaf->count_ && !(key < static_cast<Key>(leaf->keys_[pos]));
+                if (found) {
+                    value = leaf->values_[pos];
+                }
+                leaf->lock_.CheckOrRestart(version, restart);
+                if (!restart) {
+                    return found;
+                }
+            }
+        }
+    }
+
+    size_t erase(const Key &key) {
+        if constexpr (!kOptimistic) {
+            Leaf *leaf = LockLeaf(key, true);
+            bool erased = leaf->Erase(key);
+            leaf->lock_.unlock();
+            return erased ? 1 : 0;
+        } else {
+            while (true) {
+                bool restart = false;
+                uint64_t version;
+                Leaf *leaf = TraverseToLeaf(key, version, restart);
+                if (restart) {
+                    continue;
+                }
+                leaf->lock_.UpgradeToWriteLockOrRestart(version, restart);
+                if (restart) {
+                    continue;
+                }
+                bool erased = leaf->Erase(key);
+                leaf->lock_.WriteUnlock();
+                return erased ? 1 : 0;
+            }
+        }
+    }
+
+    // Erases every key in [first, last). Like the iterators themselves, this
+    // is meant for single threaded use.
+    // 删除[first, last)中的所有键。与迭代器本身一样，它只适用于单线程。
+    void erase(Iterator first, Iterator last) {
+        std::vector<Key> doomed;
+        for (Iterator it = first; it != last; ++it) {
+            doomed.push_back(it.key());
+        }
+        for (const Key &key: doomed) {
+            erase(key);
+        }
+    }
+
+    Iterator begin() const {
+        NodeBase *node = root_.load();
+        while (!node->is_leaf_) {
+            node = static_cast<Inner *>(node)->children_[0];
+        }
+        return Iterator(static_cast<Leaf *>(node), 0);
+    }
+
+    Iterator end() const { return Iterator(nullptr, 0); }
+
+    Iterator find(const Key &key) const {
+        Iterator it = lower_bound(key);
+        if (it != end() && !(key < it.key())) {
+            return it;
+        }
+        return end();
+    }
+
+    Iterator lower_bound(const Key &key) const {
+        if constexpr (!kOptimistic) {
+            Leaf *leaf = LockLeaf(key, false);
+            size_t pos = LowerBound(leaf->keys_, leaf->count_, key);
+            leaf->lock_.unlock_shared();
+            return Iterator(leaf, pos);
+        } else {
+            bool restart;
+            uint64_t version;
+            Leaf *leaf;
+            do {
+                restart = false;
+                leaf = TraverseToLeaf(key, version, restart);
+            } while (restart);
+            return Iterator(leaf, LowerBound(leaf->keys_, leaf->count_, key));
+        }
+    }
+
+    // Copies up to max_count pairs with keys >= start into out. This is safe
+    // while other threads modify the tree: each leaf is copied optimistically
+    // and re-read if a writer changed it. The result is weakly consistent, it
+    // may or may not reflect writes that happen during the scan.
+    // 将最多max_count个键 >= start的键值对复制到out中。在其他线程修改树时这也是
+    // 安全的：每个叶子节点都被乐观地复制，如果有写者修改了它就重新读取。结果是
+    // 弱一致的，它可能反映也可能不反映扫描期间发生的写入。
+    void Scan(const Key &start, size_t max_count, std::vector<std::pair<Key, Value>> &out) const {
+        out.clear();
+        if constexpr (!kOptimistic) {
+            // With crabbing, the next leaf is locked before this one is
+            // unlocked. Writers only lock downwards and never lock a sibling,
+            // so this cannot deadlock.
+            // 使用螃蟹式加锁时，先锁住下一个叶子节点再解锁当前叶子节点。写者只向下
+            // 加锁，从不锁兄弟节点，所以这不会死锁。
+            Leaf *leaf = LockLeaf(start, false);
+            while (true) {
+                for (size_t i = 0; i < leaf->count_ && out.size() < max_count; i++) {
+                    if (!(static_cast<Key>(leaf->keys_[i]) < start)) {
+                        out.emplace_back(leaf->keys_[i], leaf->values_[i]);
+                    }
+                }
+                Leaf *next = leaf->next_;
+                if (next == nullptr || out.size() == max_count) {
+                    leaf->lock_.unlock_shared();
+                    return;
+                }
+                next->lock_.lock_shared();
+                leaf->lock_.unlock_shared();
+                leaf = next;
+            }
+        } else {
+            bool restart = false;
+            uint64_t version;
+            Leaf *leaf = TraverseToLeaf(start, version, restart);
+            std::vector<std::pair<Key, Value>> chunk;
+            while (out.size() < max_count) {
+                if (restart) {
+                    // Resume right after the last key we already copied.
+                    // 从我们已经复制的最后一个键之后继续。
+                    restart = false;
+                    leaf = TraverseToLeaf(out.empty() ? start : out.back().first, version, restart);
+                    continue;
+                }
+                chunk.clear();
+                size_t n = leaf->count_;
+                for (size_t i = 0; i < n && i < kLeafCapacity; i++) {
+                    chunk.emplace_back(leaf->keys_[i], leaf->values_[i]);
+                }
+                Leaf *next = leaf->next_;
+                leaf->lock_.CheckOrRestart(version, restart);
+                if (restart) {
+                    continue;
+                }
+                for (const auto &pair: chunk) {
+                    bool after_last = out.empty() ? !(pair.first < start) : out.back().first < pair.first;
+                    if (after_last && out.size() < max_count) {
+                        out.push_back(pair);
+                    }
+                }
+                if (next == nullptr) {
+                    return;
+                }
+                leaf = next;
+                version = leaf->lock_.ReadLockOrRestart(restart);
+            }
+        }
+    }
+
+    // Replaces the contents of the tree with sorted, unique keys and their
+    // values. Building bottom up is much faster than inserting one key at a
+    // time, and it packs the leaves to fill_factor so that later inserts do
+    // not immediately split them. Throws std::invalid_argument if keys and
+    // values differ in size or fill_factor is not in (0, 1].
+    // 用有序且唯一的键及其对应的值替换树的内容。自底向上构建比一次插入一个键
+    // 快得多，并且它把叶子节点填充到fill_factor，这样后续的插入不会立即导致
+    // 它们分裂。如果keys和values的大小不同，或者fill_factor不在(0, 1]中，则抛出
+    // std::invalid_argument。
+    void BulkLoad(const std::vector<Key> &keys, const std::vector<Value> &values, double fill_factor = 0.9) {
+        if (keys.size() != values.size()) {
+            throw std::invalid_argument("BulkLoad needs one value per key");
+        }
+        if (!(fill_factor > 0 && fill_factor <= 1)) {
+            throw std::invalid_argument("The fill factor must be in (0, 1]");
+        }
+        FreeSubtree(root_.load());
+        size_t per_leaf = std::max<size_t>(1, static_cast<size_t>(kLeafCapacity * fill_factor));
+
+        // Build the leaf level, and remember the largest key of every node.
+        // 构建叶子层，并记住每个节点中的最大键。
+        std::vector<NodeBase *> level;
+        std::vector<Key> max_keys;
+        Leaf *prev = nullptr;
+        std::vector<size_t> bounds = Partition(keys.size(), per_leaf);
+        for (size_t i = 0; i + 1 < bounds.size(); i++) {
+            Leaf *leaf = new Leaf();
+            for (size_t j = bounds[i]; j < bounds[i + 1]; j++) {
+                leaf->keys_[leaf->count_] = keys[j];
+                leaf->values_[leaf->count_] = values[j];
+                leaf->count_ = leaf->count_ + 1;
+            }
+            if (prev != nullptr) {
+                prev->next_ = leaf;
+            }
+            prev = leaf;
+            level.push_back(leaf);
+            max_keys.push_back(keys[bounds[i + 1] - 1]);
+        }
+        if (level.empty()) {
+            root_.store(new Leaf());
+            return;
+        }
+
+        // Build inner levels until a single root is left.
+        // 构建内部层，直到只剩下一个根节点。
+        size_t per_inner = std::max<size_t>(2, static_cast<size_t>((kInnerCapacity + 1) * fill_factor));
+        while (level.size() > 1) {
+            std::vector<NodeBase *> parents;
+            std::vector<Key> parent_max_keys;
+            bounds = Partition(level.size(), per_inner);
+            for (size_t i = 0; i + 1 < bounds.size(); i++) {
+                Inner *inner = new Inner();
+                for (size_t j = bounds[i]; j < bounds[i + 1]; j++) {
+                    inner->children_[inner->count_] = level[j];
+                    if (j + 1 < bounds[i + 1]) {
+                        inner->keys_[inner->count_] = max_keys[j];
+                        inner->count_ = inner->count_ + 1;
+                    }
+                }
+                parents.push_back(inner);
+                parent_max_keys.push_back(max_keys[bounds[i + 1] - 1]);
+            }
+            level.swap(parents);
+            max_keys.swap(parent_max_keys);
+        }
+        root_.store(level[0]);
+    }
+
+    // Returns the number of levels in the tree.
+    // 返回树的层数。
+    size_t Height() const {
+        size_t height = 1;
+        for (NodeBase *node = root_.load(); !node->is_leaf_; node = static_cast<Inner *>(node)->children_[0]) {
+            height++;
+        }
+        return height;
+    }
+
+private:
+    // Splits n items into groups of at most per_group items with sizes that
+    // differ by at most one. Returns the group boundaries.
+    // 把n个元素分成若干组，每组最多per_group个元素，且各组大小最多相差一。
+    // 返回各组的边界。
+    static std::vector<size_t> Partition(size_t n, size_t per_group) {
+        std::vector<size_t> bounds = {0};
+        size_t groups = (n + per_group - 1) / per_group;
+        for (size_t i = 1; i <= groups; i++) {
+            bounds.push_back(n * i / groups);
+        }
+        return bounds;
+    }
+
+    // Walks from the root to the leaf that may contain key. On success, the
+    // returned leaf was read at version, and every node on the way was
+    // validated after its child's version was read, so the leaf really was
+    // the right one at that moment.
+    // 从根节点走到可能包含key的叶子节点。成功时，返回的叶子节点是在version时
+    // 读取的，并且路径上的每个节点都在读取其孩子的版本之后经过了验证，所以该
+    // 叶子节点在那一刻确实是正确的那个。
+    Leaf *TraverseToLeaf(const Key &key, uint64_t &version, bool &restart) const {
+        NodeBase *node = root_.load();
+        version = node->lock_.ReadLockOrRestart(restart);
+        if (restart || node != root_.load()) {
+            restart = true;
+            return nullptr;
+        }
+        Inner *parent = nullptr;
+        uint64_t parent_version = 0;
+        while (!node->is_leaf_) {
+            Inner *inner = static_cast<Inner *>(node);
+            if (parent != nullptr) {
+                parent->lock_.CheckOrRestart(parent_version, restart);
+                if (restart) {
+                    return nullptr;
+                }
+            }
+            parent = inner;
+            parent_version = version;
+            node = inner->FindChild(key);
+            // Validate before following the pointer, it may be garbage if a
+            // writer was halfway through changing this node.
+            // 在跟随指针之前先验证，如果有写者正在修改这个节点，该指针可能是无效的。
+            inner->lock_.CheckOrRestart(version, restart);
+            if (restart) {
+                return nullptr;
+            }
+            version = node->lock_.ReadLockOrRestart(restart);
+            if (restart) {
+                return nullptr;
+            }
+        }
+        if (parent != nullptr) {
+            parent->lock_.CheckOrRestart(parent_version, restart);
+            if (restart) {
+                return nullptr;
+            }
+        }
+        return static_cast<Leaf *>(node);
+    }
+
+    // Crabs from the root to the leaf that may contain key and returns that
+    // leaf locked, exclusively if exclusive is set and shared otherwise. Inner
+    // nodes are only locked in shared mode. Only used without kOptimistic.
+    // 从根节点以螃蟹式加锁走到可能包含key的叶子节点，并返回已锁住的该叶子节点：
+    // 如果设置了exclusive则是独占锁，否则是共享锁。内部节点只以共享方式加锁。只在
+    // 没有kOptimistic时使用。
+    Leaf *LockLeaf(const Key &key, bool exclusive) const {
+        // A new root is only installed while the old root is locked
+        // exclusively, so once the root is locked, root_ cannot change.
+        // 只有在旧根节点被独占锁住时才会装上新的根节点，所以一旦锁住了根节点，root_
+        // 就不会再改变。
+        NodeBase *node = root_.load();
+        LockNode(node, exclusive && node->is_leaf_);
+        while (node != root_.load()) {
+            UnlockNode(node, exclusive && node->is_leaf_);
+            node = root_.load();
+            LockNode(node, exclusive && node->is_leaf_);
+        }
+        while (!node->is_leaf_) {
+            NodeBase *child = static_cast<Inner *>(node)->FindChild(key);
+            LockNode(child, exclusive && child->is_leaf_);
+            node->lock_.unlock_shared();
+            node = child;
+        }
+        return static_cast<Leaf *>(node);
+    }
+
+    static void LockNode(NodeBase *node, bool exclusive) {
+        if (exclusive) {
+            node->lock_.lock();
+        } else {
+            node->lock_.lock_shared();
+        }
+    }
+
+    static void UnlockNode(NodeBase *node, bool exclusive) {
+        if (exclusive) {
+            node->lock_.unlock();
+        } else {
+            node->lock_.unlock_shared();
+        }
+    }
+
+    // Splits node, which is the child of parent (or the root if parent is
+    // nullptr). Both must already be write locked.
+    // 分裂node，它是parent的孩子（如果parent为nullptr则是根节点）。两者都必须
+    // 已经被写锁住。
+    void SplitNode(NodeBase *node, Inner *parent) {
+        Key separator;
+        NodeBase *right;
+        if (node->is_leaf_) {
+            right = static_cast<Leaf *>(node)->Split(separator);
+        } else {
+            right = static_cast<Inner *>(node)->Split(separator);
+        }
+        if (parent != nullptr) {
+            parent->InsertChild(separator, right);
+        } else {
+            Inner *new_root = new Inner();
+            new_root->count_ = 1;
+            new_root->keys_[0] = separator;
+            new_root->children_[0] = node;
+            new_root->children_[1] = right;
+            root_.store(new_root);
+        }
+    }
+
+    // One attempt at an insert. Returns false if it has to restart. Full
+    // nodes are split on the way down, so a split never has to propagate
+    // upwards and we never hold more than two locks.
+    // 一次插入尝试。如果需要重新开始则返回false。满的节点在向下的路上就会被
+    // 分裂，所以分裂永远不需要向上传播，我们也从不持有两个以上的锁。
+    bool TryInsert(const Key &key, const Value &value, bool &inserted) {
+        bool restart = false;
+        NodeBase *node = root_.load();
+        uint64_t version = node->lock_.ReadLockOrRestart(restart);
+        if (restart || node != root_.load()) {
+            return false;
+        }
+        Inner *parent = nullptr;
+        uint64_t parent_version = 0;
+        while (true) {
+            bool full = node->is_leaf_ ? static_cast<Leaf *>(node)->IsFull() : static_cast<Inner *>(node)->IsFull();
+            if (full) {
+                if (parent != nullptr) {
+                    parent->lock_.UpgradeToWriteLockOrRestart(parent_version, restart);
+                    if (restart) {
+                        return false;
+                    }
+                }
+                node->lock_.UpgradeToWriteLockOrRestart(version, restart);
+                if (restart || (parent == nullptr && node != root_.load())) {
+                    if (!restart) {
+                        node->lock_.WriteUnlock();
+                    }
+                    if (parent != nullptr) {
+                        parent->lock_.WriteUnlock();
+                    }
+                    return false;
+                }
+                SplitNode(node, parent);
+                node->lock_.WriteUnlock();
+                if (parent != nullptr) {
+                    parent->lock_.WriteUnlock();
+                }
+                return false;
+            }
+            if (node->is_leaf_) {
+                break;
+            }
+            Inner *inner = static_cast<Inner *>(node);
+            if (parent != nullptr) {
+                parent->lock_.CheckOrRestart(parent_version, restart);
+                if (restart) {
+                    return false;
+                }
+            }
+            parent = inner;
+            parent_version = version;
+            node = inner->FindChild(key);
+            inner->lock_.CheckOrRestart(version, restart);
+            if (restart) {
+                return false;
+            }
+            version = node->lock_.ReadLockOrRestart(restart);
+            if (restart) {
+                return false;
+            }
+        }
+
+        Leaf *leaf = static_cast<Leaf *>(node);
+        leaf->lock_.UpgradeToWriteLockOrRestart(version, restart);
+        if (restart) {
+            return false;
+        }
+        if (parent != nullptr) {
+            parent->lock_.CheckOrRestart(parent_version, restart);
+            if (restart) {
+                leaf->lock_.WriteUnlock();
+                return false;
+            }
+        }
+        inserted = leaf->Insert(key, value);
+        leaf->lock_.WriteUnlock();
+        return true;
+    }
+
+    // TryInsert for classic lock coupling. Every node on the way down is
+    // locked exclusively, and the parent is unlocked once the child is locked.
+    // As in TryInsert, full nodes are split on the way down, so we never hold
+    // more than two locks.
+    // 用于经典锁耦合的TryInsert。向下路径上的每个节点都被独占锁住，一旦锁住了孩子
+    // 就解锁父节点。与TryInsert一样，满的节点在向下的路上就会被分裂，所以我们从不
+    // 持有两个以上的锁。
+    bool TryInsertExclusive(const Key &key, const Value &value, bool &inserted) {
+        NodeBase *node = root_.load();
+        node->lock_.lock();
+        if (node != root_.load()) {
+            node->lock_.unlock();
+            return false;
+        }
+        Inner *parent = nullptr;
+        while (true) {
+            bool full = node->is_leaf_ ? static_cast<Leaf *>(node)->IsFull() : static_cast<Inner *>(node)->IsFull();
+            if (full) {
+                SplitNode(node, parent);
+                node->lock_.unlock();
+                if (parent != nullptr) {
+                    parent->lock_.unlock();
+                }
+                return false;
+            }
+            if (node->is_leaf_) {
+                break;
+            }
+            NodeBase *child = static_cast<Inner *>(node)->FindChild(key);
+            child->lock_.lock();
+            if (parent != nullptr) {
+                parent->lock_.unlock();
+            }
+            parent = static_cast<Inner *>(node);
+            node = child;
+        }
+        inserted = static_cast<Leaf *>(node)->Insert(key, value);
+        node->lock_.unlock();
+        if (parent != nullptr) {
+            parent->lock_.unlock();
+        }
+        return true;
+    }
+
+    static void FreeSubtree(NodeBase *node) {
+        if (node->is_leaf_) {
+            delete static_cast<Leaf *>(node);
+            return;
+        }
+        Inner *inner = static_cast<Inner *>(node);
+        for (size_t i = 0; i <= inner->count_; i++) {
+            FreeSubtree(inner->children_[i]);
+        }
+        delete inner;
+    }
+
+    // Nodes are never freed while the tree is alive (erase leaves underfull
+    // nodes in place instead of merging them), so an optimistic reader can
+    // always safely dereference a node pointer that it read.
+    // 在树存活期间节点永远不会被释放（erase会把未满的节点留在原地而不是合并
+    // 它们），所以乐观的读者总是可以安全地解引用它读到的节点指针。
+    std::atomic<NodeBase *> root_;
+};
+
+// A B+ tree that stores only keys, with the same interface as std::set.
+// 只存储键的B+树，接口与std::set相同。
+template<typename Key, size_t NodeBytes = 256>
+using BPlusTreeSet = BPlusTree<Key, Empty, NodeBytes>;
+
+// The same B+ tree with a std::shared_mutex in every node and classic lock
+// coupling, as the baseline for optimistic lock coupling.
+// 同样的B+树，但每个节点中有一个std::shared_mutex并使用经典的锁耦合，作为乐观锁耦合
+// 的基准。
+template<typename Key, typename Value, size_t NodeBytes = 256>
+using SharedMutexBPlusTree = BPlusTree<Key, Value, NodeBytes, false>;
+
+// Runs func once and returns how long it took, in milliseconds.
+// 运行func一次并返回它所花的时间，单位为毫秒。
+template<typename Func>
+double TimeMs(Func func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// Compares bulk loading, point lookups and a full ordered scan against
+// std::set, and compares cache-line-sized nodes with page-sized nodes.
+// 比较批量加载、点查询以及完整的有序扫描与std::set的表现，并比较缓存行大小
+// 的节点与页大小的节点。
+template<size_t NodeBytes>
+void BenchmarkTree(const std::vector<int> &keys, const std::vector<int> &probes) {
+    BPlusTree<int, int, NodeBytes> tree;
+    double build = TimeMs([&] { tree.BulkLoad(keys, keys); });
+    size_t hits = 0;
+    double lookup = TimeMs([&] {
+        for (int probe: probes) {
+            hits += tree.count(probe);
+        }
+    });
+    long long sum = 0;
+    double scan = TimeMs([&] {
+        for (auto it = tree.begin(); it != tree.end(); ++it) {
+            sum += it.key();
+        }
+    });
+    std::cout << "  B+ tree (" << NodeBytes << "B nodes, height " << tree.Height() << "): bulk load " << build
+              << " ms, lookup " << lookup << " ms, scan " << scan << " ms (key sum " << sum << "), " << hits
+              << " hits\n";
+}
+
+void RunBenchmark() {
+    const int num_keys = 1 << 18;
+    std::vector<int> keys(num_keys);
+    for (int i = 0; i < num_keys; i++) {
+        keys[i] = i * 2;
+    }
+    std::vector<int> probes;
+    for (int i = 0; i < num_keys; i++) {
+        probes.push_back(static_cast<int>((i * 2654435761u) % (num_keys * 2)));
+    }
+
+    std::set<int> tree_set;
+    double build = TimeMs([&] { tree_set.insert(keys.begin(), keys.end()); });
+    size_t hits = 0;
+    double lookup = TimeMs([&] {
+        for (int probe: probes) {
+            hits += tree_set.count(probe);
+        }
+    });
+    long long sum = 0;
+    double scan = TimeMs([&] {
+        for (int key: tree_set) {
+            sum += key;
+        }
+    });
+    std::cout << "Benchmark with " << num_keys << " keys:\n";
+    std::cout << "  std::set: build " << build << " ms, lookup " << lookup << " ms, scan " << scan
+              << " ms (key sum " << sum << "), " << hits << " hits\n";
+    BenchmarkTree<256>(keys, probes);
+    BenchmarkTree<4096>(keys, probes);
+}
+
+// Runs num_threads threads that together perform total_ops operations on
+// tree, which holds the even keys below 2 * num_keys with value key * 10.
+// write_percent of the operations insert or erase an odd key, the rest look
+// up an even key and check its value. Returns Mops/s.
+// 运行num_threads个线程，它们一共对tree执行total_ops次操作，tree中保存着小于
+// 2 * num_keys的偶数键，值为key * 10。其中write_percent%的操作插入或删除一个奇数键，
+// 其余的查找一个偶数键并检查它的值。返回Mops/s。
+template<typename Tree>
+double RunMix(Tree &tree, int num_keys, int num_threads, int total_ops, int write_percent) {
+    std::atomic<int64_t> errors{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&tree, &errors, t, num_keys, num_threads, total_ops, write_percent] {
+            std::mt19937 rng(t);
+            for (int i = 0; i < total_ops / num_threads; i++) {
+                int key = static_cast<int>(rng() % num_keys) * 2;
+                if (static_cast<int>(rng() % 100) < write_percent) {
+                    if (rng() % 2 == 0) {
+                        tree.insert(key + 1, key + 1);
+                    } else {
+                        tree.erase(key + 1);
+                    }
+                } else {
+                    int value = 0;
+                    if (!tree.Lookup(key, value) || value != key * 10) {
+                        errors++;
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    if (errors != 0) {
+        std::cout << "    " << errors << " wrong lookups!\n";
+    }
+    return total_ops / std::chrono::duration<double, std::micro>(stop - start).count();
+}
+
+// Compares optimistic lock coupling with std::shared_mutex coupling on the
+// same keys, read-only and with 5% writes, from 1 to 64 threads. Lookup
+// scaling needs threads on many cores at once; with a single core no cache
+// line moves between cores and only the cost per node shows.
+// 在相同的键上比较乐观锁耦合与std::shared_mutex锁耦合，分别测试只读以及5%写入的
+// 情况，线程数从1到64。查找的扩展需要许多核心上同时有线程；只有一个核心时，没有缓存
+// 行在核心之间移动，只能体现出每个节点的开销。
+void RunCouplingBenchmark() {
+    const int num_keys = 1 << 17;
+    const int total_ops = 1 << 17;
+    std::vector<int> keys(num_keys);
+    std::vector<int> values(num_keys);
+    for (int i = 0; i < num_keys; i++) {
+        keys[i] = i * 2;
+        values[i] = keys[i] * 10;
+    }
+    BPlusTree<int, int> optimistic;
+    SharedMutexBPlusTree<int, int> coupled;
+    optimistic.BulkLoad(keys, values);
+    coupled.BulkLoad(keys, values);
+
+    std::cout << "Coupling benchmark with " << num_keys << " keys, height " << optimistic.Height()
+              << " (OLC) and " << coupled.Height() << " (std::shared_mutex), "
+              << std::thread::hardware_concurrency() << " hardware threads\n";
+    for (int write_percent: {0, 5}) {
+        std::cout << "Throughput in Mops/s with " << write_percent << "% writes:\n";
+        for (int num_threads = 1; num_threads <= 64; num_threads *= 4) {
+            double coupled_mops = RunMix(coupled, num_keys, num_threads, total_ops, write_percent);
+            double optimistic_mops = RunMix(optimistic, num_keys, num_threads, total_ops, write_percent);
+            std::cout << "  " << num_threads << " threads: std::shared_mutex coupling " << coupled_mops
+                      << ", optimistic lock coupling " << optimistic_mops << "\n";
+        }
+    }
+}
+
+// Several threads insert disjoint ranges while others look keys up and scan.
+// Afterwards every inserted key must be in the tree exactly once.
+// 若干线程插入互不相交的范围，同时其他线程查找键并进行扫描。之后每个插入的
+// 键都必须恰好在树中出现一次。
+template<typename Tree>
+void RunConcurrentDemo(const char *name) {
+    const int num_writers = 4;
+    const int keys_per_writer = 20000;
+    Tree tree;
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_writers; t++) {
+        threads.emplace_back([&tree, t] {
+            for (int i = 0; i < keys_per_writer; i++) {
+                int key = i * num_writers + t;
+                tree.insert(key, key * 10);
+            }
+        });
+    }
+    threads.emplace_back([&tree, &done] {
+        std::vector<std::pair<int, int>> out;
+        while (!done.load()) {
+            int value = 0;
+            if (tree.Lookup(4, value) && value != 40) {
+                std::cout << "Reader saw a wrong value!\n";
+            }
+            tree.Scan(1000, 100, out);
+            for (size_t i = 1; i < out.size(); i++) {
+                if (!(out[i - 1].first < out[i].first)) {
+                    std::cout << "Scan returned keys out of order!\n";
+                }
+            }
+        }
+    });
+    for (int t = 0; t < num_writers; t++) {
+        threads[t].join();
+    }
+    done.store(true);
+    threads.back().join();
+
+    size_t found = 0;
+    for (int key = 0; key < num_writers * keys_per_writer; key++) {
+        found += tree.count(key);
+    }
+    std::cout << name << ": found " << found << " of " << num_writers * keys_per_writer << " keys\n";
+}
+
+int main() {
+    // BPlusTreeSet supports the std::set operations from sets.cpp.
+    // BPlusTreeSet支持sets.cpp中的std::set操作。
+    BPlusTreeSet<int> int_set;
+    for (int i = 1; i <= 10; ++i) {
+        int_set.insert(i);
+    }
+
+    if (int_set.find(2) != int_set.end()) {
+        std::cout << "Element 2 is in int_set.\n";
+    }
+    if (int_set.count(11) == 0) {
+        std::cout << "Element 11 is not in the set.\n";
+    }
+    int_set.erase(4);
+    if (int_set.count(4) == 0) {
+        std::cout << "Element 4 is not in the set.\n";
+    }
+
+    // The range erase walks the linked leaves from 9 to the end.
+    // 范围删除沿着链接的叶子节点从9走到末尾。
+    int_set.erase(int_set.find(9), int_set.end());
+    if (int_set.count(9) == 0 && int_set.count(10) == 0) {
+        std::cout << "Elements 9 and 10 are not in the set.\n";
+    }
+
+    std::cout << "Printing the elements of the B+ tree set:\n";
+    for (auto it = int_set.begin(); it != int_set.end(); ++it) {
+        std::cout << it.key() << " ";
+    }
+    std::cout << "\n";
+
+    // BPlusTree is also an ordered map. Scan returns a range of pairs.
+    // BPlusTree也是一个有序映射。Scan返回一个范围内的键值对。
+    BPlusTree<int, int> map;
+    for (int i = 0; i < 1000; i++) {
+        map.insert(i, i * i);
+    }
+    std::vector<std::pair<int, int>> range;
+    map.Scan(500, 3, range);
+    for (const auto &pair: range) {
+        std::cout << "Key " << pair.first << " has value " << pair.second << "\n";
+    }
+
+    RunBenchmark();
+    RunConcurrentDemo<BPlusTree<int, int>>("Concurrent inserts with optimistic lock coupling");
+    RunConcurrentDemo<SharedMutexBPlusTree<int, int>>("Concurrent inserts with std::shared_mutex coupling");
+    RunCouplingBenchmark();
+
+    return 0;
+}
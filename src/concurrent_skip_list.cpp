@@ -0,0 +1,494 @@
+/**
+ * @file concurrent_skip_list.cpp
+ * @brief Tutorial code for a concurrent ordered set with lock-free reads.
+ * @brief 具有无锁读取的并发有序集合的教程代码。
+ */
+
+// std::set is not thread safe. The simplest way to share one between threads
+// is to protect every find, insert and erase with one global std::mutex
+// (mutex.cpp), but then only one thread can use the set at a time, even when
+// all of them just want to read.
+// std::set不是线程安全的。在线程之间共享它的最简单方法是用一个全局的
+// std::mutex（mutex.cpp）保护每一次find、insert和erase，但这样一来同一时间
+// 只有一个线程能使用这个集合，即使它们都只是想读。
+
+// This file implements the "lazy" concurrent skip list from Herlihy, Lev,
+// Luchangco and Shavit. A skip list is a sorted linked list with extra
+// "express lane" lists on top of it: every node is in the bottom list, about
+// half of them are also in the list above, a quarter in the list above that,
+// and so on. A search starts in the top list and drops down a level whenever
+// the next node would overshoot, so it takes O(log n) steps, just like a
+// balanced tree.
+// 本文件实现了Herlihy、Lev、Luchangco和Shavit提出的"懒惰"并发跳表。跳表是
+// 一个有序链表，在它之上还有额外的"快车道"链表：每个节点都在最底层的链表中，
+// 大约一半的节点也在上一层的链表中，四分之一在再上一层中，依此类推。搜索从
+// 最顶层的链表开始，每当下一个节点会越过目标时就下降一层，所以它需要O(log n)
+// 步，就像平衡树一样。
+
+// The concurrency rules are:
+//   - count and find take no locks at all and never write shared memory.
+//     They finish in a bounded number of steps no matter what other threads
+//     do, which makes them wait-free.
+//   - insert and erase lock only the few predecessor nodes they relink.
+//   - erase first sets a "marked" flag on the node (logical deletion) and then
+//     unlinks it (physical deletion). Readers treat marked nodes as absent.
+// 并发规则如下：
+//   - count和find完全不加锁，也从不写共享内存。不管其他线程做什么，它们都在
+//     有限的步数内完成，这使得它们是无等待（wait-free）的。
+//   - insert和erase只锁住它们要重新链接的少数几个前驱节点。
+//   - erase首先在节点上设置一个"marked"标志（逻辑删除），然后再把它摘下来
+//     （物理删除）。读者把被标记的节点视为不存在。
+
+// Includes std::atomic.
+// 包含std::atomic。
+#include <atomic>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as uint32_t.
+// 包含uint32_t等定宽整数类型。
+#include <cstdint>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes the mutex library header.
+// 包含互斥锁库头文件。
+#include <mutex>
+// Includes the random number library, used to pick node heights.
+// 包含随机数库，用于选择节点高度。
+#include <random>
+// Includes the set container library header, for comparison.
+// 包含集合容器库头文件，用于对比。
+#include <set>
+// Includes the thread library header.
+// 包含线程库头文件。
+#include <thread>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+
+// ConcurrentSkipList is an ordered set of T that many threads may use at
+// once. kMaxLevel bounds the number of lists; 20 levels comfortably hold a
+// million keys.
+// ConcurrentSkipList是一个T的有序集合，许多线程可以同时使用它。kMaxLevel限制了
+// 链表的层数；20层足以容纳一百万个键。
+template<typename T, int kMaxLevel = 20>
+class ConcurrentSkipList {
+    struct Node {
+        Node(const T &key, int height) : key_(key), height_(height) {
+            for (auto &next: next_) {
+                next.store(nullptr);
+            }
+        }
+
+        T key_;
+        int height_;
+        std::atomic<Node *> next_[kMaxLevel];
+        std::mutex lock_;
+        // Set once the node is logically deleted.
+        // 一旦节点被逻辑删除就会被设置。
+        std::atomic<bool> marked_{false};
+        // Set once the node is linked into all of its levels.
+        // 一旦节点被链接到它的所有层就会被设置。
+        std::atomic<bool> fully_linked_{false};
+    };
+
+public:
+    // A weakly consistent iterator over the bottom list. It never blocks and
+    // never fails, but it may or may not see keys inserted or erased while it
+    // is running. Every key it returns is in sorted order.
+    // 遍历最底层链表的弱一致迭代器。它从不阻塞也从不失败，但它可能看到也可能
+    // 看不到在它运行期间插入或删除的键。它返回的键总是有序的。
+    class Iterator {
+    public:
+        explicit Iterator(Node *node) : node_(node) { SkipDeleted(); }
+
+        const T &operator*() const { return node_->key_; }
+
+        Iterator &operator++() {
+            node_ = node_->next_[0].load();
+            SkipDeleted();
+            return *this;
+        }
+
+        bool operator==(const Iterator &other) const { return node_ == other.node_; }
+        bool operator!=(const Iterator &other) const { return node_ != other.node_; }
+
+    private:
+        void SkipDeleted() {
+            while (node_ != nullptr && (node_->marked_.load() || !node_->fully_linked_.load())) {
+                node_ = node_->next_[0].load();
+            }
+        }
+
+        Node *node_;
+    };
+
+    // The head is a sentinel node that is smaller than every key. A nullptr
+    // next pointer plays the role of a tail that is larger than every key.
+    // 头节点是一个比所有键都小的哨兵节点。nullptr的next指针扮演一个比所有键都
+    // 大的尾节点的角色。
+    ConcurrentSkipList() : head_(new Node(T(), kMaxLevel)) { head_->fully_linked_.store(true); }
+
+    ~ConcurrentSkipList() {
+        Node *node = head_;
+        while (node != nullptr) {
+            Node *next = node->next_[0].load();
+            delete node;
+            node = next;
+        }
+        for (Node *node: retired_) {
+            delete node;
+        }
+    }
+
+    ConcurrentSkipList(const ConcurrentSkipList &) = delete;
+    ConcurrentSkipList &operator=(const ConcurrentSkipList &) = delete;
+
+    Iterator begin() const { return Iterator(head_->next_[0].load()); }
+    Iterator end() const { return Iterator(nullptr); }
+
+    // An approximate size: it is exact when no other thread is writing.
+    // 一个近似的大小：在没有其他线程写入时它是准确的。
+    size_t size() const { return size_.load(); }
+
+    // Wait-free membership test.
+    // 无等待的成员测试。
+    size_t count(const T &key) const {
+        Node *preds[kMaxLevel];
+        Node *succs[kMaxLevel];
+        int level = Find(key, preds, succs);
+        return level != -1 && succs[level]->fully_linked_.load() && !succs[level]->marked_.load() ? 1 : 0;
+    }
+
+    Iterator find(const T &key) const {
+        Node *preds[kMaxLevel];
+        Node *succs[kMaxLevel];
+        int level = Find(key, preds, succs);
+        if (level != -1 && succs[level]->fully_linked_.load() && !succs[level]->marked_.load()) {
+            return Iterator(succs[level]);
+        }
+        return end();
+    }
+
+    // Returns true if key was inserted, and false if it was already present.
+    // 如果key被插入则返回true，如果它已经存在则返回false。
+    bool insert(const T &key) {
+        int height = RandomHeight();
+        Node *preds[kMaxLevel];
+        Node *succs[kMaxLevel];
+        while (true) {
+            int found = Find(key, preds, succs);
+            if (found != -1) {
+                Node *node = succs[found];
+                if (!node->marked_.load()) {
+                    // Someone else is inserting the same key. Wait until it is
+                    // fully linked so that a count right after we return sees it.
+                    // 别人正在插入相同的键。等到它被完全链接，这样我们返回后立即
+                    // 调用的count就能看到它。
+                    while (!node->fully_linked_.load()) {
+                        std::this_thread::yield();
+                    }
+                    return false;
+                }
+                // The key is being erased; retry until it is gone.
+                // 这个键正在被删除；重试直到它消失。
+                std::this_thread::yield();
+                continue;
+            }
+
+            // Lock the predecessors bottom up and check that nothing changed
+            // between them and their successors since Find looked at them.
+            // 自底向上锁住前驱节点，并检查自从Find查看它们以来，它们和它们的后继之间
+            // 没有发生任何变化。
+            int locked = 0;
+            bool valid = LockPredecessors(
+                    preds, height,
+                    [&](int level) {
+                        Node *succ = succs[level];
+                        return !preds[level]->marked_.load() && (succ == nullptr || !succ->marked_.load()) &&
+                               preds[level]->next_[level].load() == succ;
+                    },
+                    locked);
+            if (!valid) {
+                UnlockPredecessors(preds, locked);
+                continue;
+            }
+
+            Node *node = new Node(key, height);
+            for (int level = 0; level < height; level++) {
+                node->next_[level].store(succs[level]);
+            }
+            for (int level = 0; level < height; level++) {
+                preds[level]->next_[level].store(node);
+            }
+            node->fully_linked_.store(true);
+            UnlockPredecessors(preds, height);
+            size_.fetch_add(1);
+            return true;
+        }
+    }
+
+    bool emplace(const T &key) { return insert(key); }
+
+    size_t erase(const T &key) {
+        Node *preds[kMaxLevel];
+        Node *succs[kMaxLevel];
+        Node *victim = nullptr;
+        bool is_marked = false;
+        int height = 0;
+        while (true) {
+            int found = Find(key, preds, succs);
+            if (!is_marked) {
+                // Only a fully linked, unmarked node that was found at its own
+                // top level can be deleted by us.
+                // 只有一个完全链接的、未被标记的、并且是在它自己的最高层被找到的
+                // 节点才能被我们删除。
+                if (found == -1) {
+                    return 0;
+                }
+                victim = succs[found];
+                if (!victim->fully_linked_.load() || victim->height_ - 1 != found || victim->marked_.load()) {
+                    return 0;
+                }
+                height = victim->height_;
+                victim->lock_.lock();
+                if (victim->marked_.load()) {
+                    victim->lock_.unlock();
+                    return 0;
+                }
+                victim->marked_.store(true);
+                is_marked = true;
+            }
+
+            int locked = 0;
+            bool valid = LockPredecessors(
+                    preds, height,
+                    [&](int level) {
+                        return !preds[level]->marked_.load() && preds[level]->next_[level].load() == victim;
+                    },
+                    locked);
+            if (!valid) {
+                UnlockPredecessors(preds, locked);
+                continue;
+            }
+
+            for (int level = height - 1; level >= 0; level--) {
+                preds[level]->next_[level].store(victim->next_[level].load());
+            }
+            victim->lock_.unlock();
+            UnlockPredecessors(preds, height);
+            Retire(victim);
+            size_.fetch_sub(1);
+            return 1;
+        }
+    }
+
+private:
+    // Fills preds and succs with the nodes just before and at-or-after key on
+    // every level. Returns the highest level where key was found, or -1.
+    // 在每一层上，用紧挨在key之前以及在key处或之后的节点填充preds和succs。返回
+    // 找到key的最高层，或者-1。
+    int Find(const T &key, Node **preds, Node **succs) const {
+        int found = -1;
+        Node *pred = head_;
+        for (int level = kMaxLevel - 1; level >= 0; level--) {
+            Node *curr = pred->next_[level].load();
+            while (curr != nullptr && curr->key_ < key) {
+                pred = curr;
+                curr = pred->next_[level].load();
+            }
+            if (found == -1 && curr != nullptr && !(key < curr->key_)) {
+                found = level;
+            }
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+        return found;
+    }
+
+    // Locks preds[0, height) bottom up, skipping repeats (the same node is
+    // often the predecessor on several levels), and checks validate on every
+    // level. Returns false as soon as a level fails validation. Either way,
+    // locked is set to the number of levels whose locks are now held.
+    // 自底向上锁住preds[0, height)，跳过重复的节点（同一个节点经常是好几层的
+    // 前驱），并在每一层上检查validate。一旦某一层验证失败就返回false。无论哪种
+    // 情况，locked都被设置为当前持有锁的层数。
+    template<typename Validate>
+    bool LockPredecessors(Node **preds, int height, Validate validate, int &locked) {
+        for (int level = 0; level < height; level++) {
+            if (level == 0 || preds[level] != preds[level - 1]) {
+                preds[level]->lock_.lock();
+            }
+            locked = level + 1;
+            if (!validate(level)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Unlocks the distinct nodes in preds[0, levels).
+    // 解锁preds[0, levels)中不同的节点。
+    void UnlockPredecessors(Node **preds, int levels) {
+        for (int level = 0; level < levels; level++) {
+            if (level == 0 || preds[level] != preds[level - 1]) {
+                preds[level]->lock_.unlock();
+            }
+        }
+    }
+
+    // Returns the height of a new node: 1 with probability 1/2, 2 with
+    // probability 1/4, and so on.
+    // 返回新节点的高度：概率1/2为1，概率1/4为2，依此类推。
+    static int RandomHeight() {
+        thread_local std::mt19937 rng(std::random_device{}());
+        int height = 1;
+        uint32_t bits = rng();
+        while (height < kMaxLevel && (bits & 1)) {
+            height++;
+            bits >>= 1;
+        }
+        return height;
+    }
+
+    // An erased node cannot be freed right away, because a reader may still
+    // be standing on it. We keep it until the list is destroyed. A production
+    // version would use epoch-based reclamation or hazard pointers to free it
+    // as soon as no reader can reach it.
+    // 被删除的节点不能立即释放，因为可能还有读者停留在它上面。我们一直保留它，
+    // 直到链表被销毁。生产版本会使用基于epoch的回收或者危险指针，在没有读者能
+    // 访问到它时立即释放它。
+    void Retire(Node *node) {
+        std::scoped_lock lk(retired_lock_);
+        retired_.push_back(node);
+    }
+
+    Node *head_;
+    std::atomic<size_t> size_{0};
+    std::mutex retired_lock_;
+    std::vector<Node *> retired_;
+};
+
+// The baseline from mutex.cpp: a std::set with one global mutex.
+// 来自mutex.cpp的基线：一个带有一个全局互斥锁的std::set。
+class MutexSet {
+public:
+    size_t count(int key) {
+        std::scoped_lock lk(m_);
+        return set_.count(key);
+    }
+    bool insert(int key) {
+        std::scoped_lock lk(m_);
+        return set_.insert(key).second;
+    }
+    size_t erase(int key) {
+        std::scoped_lock lk(m_);
+        return set_.erase(key);
+    }
+
+private:
+    std::mutex m_;
+    std::set<int> set_;
+};
+
+// Runs total_ops operations split across num_threads threads. read_percent
+// of them are count calls, and the rest are split evenly between insert and
+// erase. Returns throughput in million operations per second.
+// 运行total_ops次操作，分摊到num_threads个线程上。其中read_percent是count调用，
+// 其余的在insert和erase之间平均分配。返回以每秒百万次操作计的吞吐量。
+template<typename Set>
+double RunMix(Set &set, int num_threads, int read_percent, int total_ops, int key_range) {
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&set, t, num_threads, read_percent, total_ops, key_range] {
+            std::mt19937 rng(t);
+            for (int i = 0; i < total_ops / num_threads; i++) {
+                int key = static_cast<int>(rng() % key_range);
+                int op = static_cast<int>(rng() % 100);
+                if (op < read_percent) {
+                    set.count(key);
+                } else if (op % 2 == 0) {
+                    set.insert(key);
+                } else {
+                    set.erase(key);
+                }
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return total_ops / std::chrono::duration<double, std::micro>(stop - start).count();
+}
+
+// Compares the skip list with a mutex-protected std::set from 1 to 64
+// threads. On a machine with fewer cores than threads, the mutex version
+// also suffers from threads being descheduled while holding the lock.
+// 在1到64个线程下比较跳表与受互斥锁保护的std::set。在核心数少于线程数的机器
+// 上，互斥锁版本还会因为线程在持有锁时被调度出去而受到影响。
+void RunBenchmark() {
+    const int key_range = 1 << 14;
+    const int total_ops = 1 << 17;
+    std::cout << "Throughput in Mops/s (" << std::thread::hardware_concurrency() << " hardware threads):\n";
+    for (int read_percent: {90, 50}) {
+        std::cout << "  " << read_percent << "% reads:\n";
+        for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+            ConcurrentSkipList<int> skip_list;
+            MutexSet mutex_set;
+            for (int key = 0; key < key_range; key += 2) {
+                skip_list.insert(key);
+                mutex_set.insert(key);
+            }
+            double skip_list_mops = RunMix(skip_list, num_threads, read_percent, total_ops, key_range);
+            double mutex_mops = RunMix(mutex_set, num_threads, read_percent, total_ops, key_range);
+            std::cout << "    " << num_threads << " threads: skip list " << skip_list_mops << ", std::set + mutex "
+                      << mutex_mops << "\n";
+        }
+    }
+}
+
+int main() {
+    // The skip list supports the std::set operations from sets.cpp that make
+    // sense when other threads may be writing at the same time.
+    // 跳表支持sets.cpp中那些在其他线程可能同时写入时仍然有意义的std::set操作。
+    ConcurrentSkipList<int> int_set;
+
+    // Four threads insert 1 through 20 concurrently, each taking every fourth
+    // key.
+    // 四个线程并发地插入1到20，每个线程负责每第四个键。
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&int_set, t] {
+            for (int i = 1 + t; i <= 20; i += 4) {
+                int_set.insert(i);
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+
+    if (int_set.find(2) != int_set.end()) {
+        std::cout << "Element 2 is in int_set.\n";
+    }
+    if (int_set.count(21) == 0) {
+        std::cout << "Element 21 is not in the set.\n";
+    }
+    int_set.erase(4);
+    if (int_set.count(4) == 0) {
+        std::cout << "Element 4 is not in the set.\n";
+    }
+
+    std::cout << "Printing the " << int_set.size() << " elements of the skip list:\n";
+    for (const int &elem: int_set) {
+        std::cout << elem << " ";
+    }
+    std::cout << "\n";
+
+    RunBenchmark();
+
+    return 0;
+}
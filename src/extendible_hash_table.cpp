@@ -0,0 +1,924 @@
+/**
+ * @file extendible_hash_table.cpp
+ * @brief Tutorial code for a disk-backed extendible hash table.
+ * @brief 基于磁盘的可扩展哈希表的教程代码。
+ */
+
+// std::unordered_map (unordered_maps.cpp) only lives in memory. Once the
+// mapping is bigger than RAM we need a hash table whose data lives in a file,
+// split into fixed-size pages, with only the pages we are using cached in
+// memory. This is exactly how a database stores a hash index, and it is the
+// structure you build in the 15-445/645 hash index project.
+// std::unordered_map（unordered_maps.cpp）只存在于内存中。一旦映射比内存还大，
+// 我们就需要一个数据存放在文件中的哈希表，文件被划分为固定大小的页，只有正在使用
+// 的页才缓存在内存里。数据库正是这样存储哈希索引的，这也是你在15-445/645哈希索引
+// 项目中要构建的结构。
+
+// The file is built from three layers:
+//   - DiskManager reads and writes 4 KB pages of one file.
+//   - BufferPool is the page cache: a fixed number of in-memory frames that
+//     hold recently used pages and write dirty pages back when they are
+//     evicted. Every frame has a reader-writer latch.
+//   - ExtendibleHashTable stores its header, directories and buckets in
+//     pages that it only touches through the buffer pool.
+// 本文件由三层构成：
+//   - DiskManager读写一个文件中的4 KB页。
+//   - BufferPool是页缓存：固定数量的内存帧，保存最近使用的页，并在淘汰脏页时把
+//     它们写回。每个帧都有一个读写锁存器（latch）。
+//   - ExtendibleHashTable把它的头部、目录和桶都存放在页中，并且只通过缓冲池访问
+//     这些页。
+
+// Extendible hashing grows one bucket at a time instead of rehashing the whole
+// table. A directory of 2^global_depth entries maps the low global_depth bits
+// of a key's hash to a bucket page. A bucket with local depth L holds all keys
+// whose low L bits match, and is shared by 2^(global_depth - L) directory
+// entries. When a bucket overflows, only that bucket is split in two (doubling
+// the directory first if L == global_depth). When a delete empties a bucket,
+// it is merged back with its "split image", and the directory halves once no
+// bucket needs the top bit.
+// 可扩展哈希每次只增长一个桶，而不是对整个表重新哈希。一个有2^global_depth个项的
+// 目录把键的哈希值的低global_depth位映射到一个桶页。局部深度为L的桶保存低L位匹配
+// 的所有键，并被2^(global_depth - L)个目录项共享。当一个桶溢出时，只把这个桶一分
+// 为二（如果L == global_depth，先把目录加倍）。当删除使一个桶变空时，它会与它的
+// "分裂镜像"合并回去，并且一旦没有桶需要最高位，目录就减半。
+
+// Includes std::sort.
+// 包含std::sort。
+#include <algorithm>
+// Includes std::atomic, for the cache statistics.
+// 包含std::atomic，用于缓存统计。
+#include <atomic>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as uint32_t.
+// 包含uint32_t等定宽整数类型。
+#include <cstdint>
+// Includes std::memset.
+// 包含std::memset。
+#include <cstring>
+// Includes std::hash.
+// 包含std::hash。
+#include <functional>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes std::list, used for the LRU list of the buffer pool.
+// 包含std::list，用于缓冲池的LRU链表。
+#include <list>
+// Includes std::unique_ptr.
+// 包含std::unique_ptr。
+#include <memory>
+// Includes the mutex library header.
+// 包含互斥锁库头文件。
+#include <mutex>
+// Includes std::optional, the return type of Find.
+// 包含std::optional，Find的返回类型。
+#include <optional>
+// Includes the random number library, used by the benchmark.
+// 包含随机数库，供基准测试使用。
+#include <random>
+// Includes the shared mutex library header, used for the page latches.
+// 包含共享互斥锁库头文件，用于页锁存器。
+#include <shared_mutex>
+// Includes std::runtime_error and std::length_error.
+// 包含std::runtime_error和std::length_error。
+#include <stdexcept>
+// Includes the C++ string library.
+// 包含C++字符串库。
+#include <string>
+// Includes std::string_view.
+// 包含std::string_view。
+#include <string_view>
+// Includes the thread library header.
+// 包含线程库头文件。
+#include <thread>
+// Includes the unordered_map container library header.
+// 包含unordered_map容器库头文件。
+#include <unordered_map>
+// Includes std::move and std::swap.
+// 包含std::move和std::swap。
+#include <utility>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+// Includes open.
+// 包含open。
+#include <fcntl.h>
+// Includes pread, pwrite, close and unlink.
+// 包含pread、pwrite、close和unlink。
+#include <unistd.h>
+
+using page_id_t = int32_t;
+
+constexpr page_id_t kInvalidPageId = -1;
+constexpr size_t kPageSize = 4096;
+
+// DiskManager turns a file into an array of pages. Page i lives at byte
+// offset i * kPageSize. Pages freed by a bucket merge are reused by later
+// allocations so that the file does not keep growing.
+// DiskManager把一个文件变成一个页的数组。第i页位于字节偏移i * kPageSize处。被桶
+// 合并释放的页会被之后的分配重用，这样文件就不会一直增长。
+class DiskManager {
+public:
+    explicit DiskManager(const std::string &path) : path_(path) {
+        fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("Could not open " + path);
+        }
+    }
+
+    ~DiskManager() {
+        close(fd_);
+        unlink(path_.c_str());
+    }
+
+    DiskManager(const DiskManager &) = delete;
+    DiskManager &operator=(const DiskManager &) = delete;
+
+    // A page that was allocated but never written reads as all zeros.
+    // 一个已分配但从未写过的页读出来全是零。
+    void ReadPage(page_id_t page_id, char *data) {
+        ssize_t n = pread(fd_, data, kPageSize, static_cast<off_t>(page_id) * kPageSize);
+        if (n < static_cast<ssize_t>(kPageSize)) {
+            std::memset(data + std::max<ssize_t>(n, 0), 0, kPageSize - std::max<ssize_t>(n, 0));
+        }
+        reads_++;
+    }
+
+    void WritePage(page_id_t page_id, const char *data) {
+        if (pwrite(fd_, data, kPageSize, static_cast<off_t>(page_id) * kPageSize) != static_cast<ssize_t>(kPageSize)) {
+            throw std::runtime_error("Could not write page " + std::to_string(page_id));
+        }
+        writes_++;
+    }
+
+    page_id_t AllocatePage() {
+        std::scoped_lock lk(mutex_);
+        if (!free_pages_.empty()) {
+            page_id_t page_id = free_pages_.back();
+            free_pages_.pop_back();
+            return page_id;
+        }
+        return next_page_id_++;
+    }
+
+    void DeallocatePage(page_id_t page_id) {
+        std::scoped_lock lk(mutex_);
+        free_pages_.push_back(page_id);
+    }
+
+    size_t reads() const { return reads_; }
+    size_t writes() const { return writes_; }
+
+private:
+    std::string path_;
+    int fd_;
+    std::mutex mutex_;
+    page_id_t next_page_id_ = 0;
+    std::vector<page_id_t> free_pages_;
+    std::atomic<size_t> reads_{0};
+    std::atomic<size_t> writes_{0};
+};
+
+// A frame is one page-sized slot of the buffer pool. pin_count is the number
+// of users of the page; a pinned frame is never evicted. latch protects the
+// contents of data, and is only ever taken on a pinned frame.
+// 帧是缓冲池中一个页大小的槽。pin_count是该页的使用者数量；被固定（pin）的帧永远
+// 不会被淘汰。latch保护data的内容，并且只会在被固定的帧上获取。
+struct Frame {
+    alignas(8) char data[kPageSize];
+    std::shared_mutex latch;
+    page_id_t page_id = kInvalidPageId;
+    int pin_count = 0;
+    bool dirty = false;
+    std::list<size_t>::iterator lru_position;
+};
+
+template<bool kExclusive>
+class PageGuard;
+using ReadPageGuard = PageGuard<false>;
+using WritePageGuard = PageGuard<true>;
+
+// BufferPool caches up to num_frames pages and evicts the least recently
+// unpinned page when it needs room. One mutex protects the page table and the
+// LRU list; the page contents are protected by the per-frame latches, so
+// readers of different pages (and of the same page) never block each other
+// once their pages are cached. To keep the code short, a miss does its disk
+// read while holding the mutex. A real buffer pool releases it for the I/O.
+// BufferPool最多缓存num_frames个页，在需要空间时淘汰最久未被使用（unpin）的页。
+// 一个互斥锁保护页表和LRU链表；页内容由每帧的锁存器保护，所以一旦页被缓存，读不同
+// 页（以及读同一页）的读者之间永远不会互相阻塞。为了让代码简短，未命中时会在持有
+// 互斥锁的情况下进行磁盘读取。真正的缓冲池会在I/O期间释放它。
+class BufferPool {
+public:
+    BufferPool(DiskManager *disk, size_t num_frames) : disk_(disk), frames_(new Frame[num_frames]) {
+        for (size_t i = 0; i < num_frames; i++) {
+            free_frames_.push_back(i);
+        }
+    }
+
+    ~BufferPool() { FlushAll(); }
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    // These return the page pinned and latched. The guard unlatches and
+    // unpins it when it goes out of scope.
+    // 这些函数返回已被固定并加了锁存器的页。guard在离开作用域时解锁并取消固定它。
+    ReadPageGuard FetchRead(page_id_t page_id);
+    WritePageGuard FetchWrite(page_id_t page_id);
+    WritePageGuard NewPage();
+
+    // Drops an unpinned page from the cache and frees it on disk.
+    // 从缓存中丢弃一个未被固定的页，并在磁盘上释放它。
+    void DeletePage(page_id_t page_id) {
+        std::scoped_lock lk(mutex_);
+        auto it = page_table_.find(page_id);
+        if (it != page_table_.end()) {
+            Frame &frame = frames_[it->second];
+            lru_.erase(frame.lru_position);
+            frame.page_id = kInvalidPageId;
+            frame.dirty = false;
+            free_frames_.push_back(it->second);
+            page_table_.erase(it);
+        }
+        disk_->DeallocatePage(page_id);
+    }
+
+    // Writes every dirty cached page back to disk.
+    // 把所有缓存的脏页写回磁盘。
+    void FlushAll() {
+        std::scoped_lock lk(mutex_);
+        for (const auto &[page_id, index]: page_table_) {
+            if (frames_[index].dirty) {
+                disk_->WritePage(page_id, frames_[index].data);
+                frames_[index].dirty = false;
+            }
+        }
+    }
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+private:
+    friend class PageGuard<false>;
+    friend class PageGuard<true>;
+
+    Frame *Pin(page_id_t page_id, bool is_new) {
+        std::scoped_lock lk(mutex_);
+        auto it = page_table_.find(page_id);
+        if (it != page_table_.end()) {
+            hits_++;
+            Frame &frame = frames_[it->second];
+            if (frame.pin_count++ == 0) {
+                lru_.erase(frame.lru_position);
+            }
+            return &frame;
+        }
+        misses_++;
+
+        size_t index;
+        if (!free_frames_.empty()) {
+            index = free_frames_.back();
+            free_frames_.pop_back();
+        } else if (!lru_.empty()) {
+            index = lru_.front();
+            lru_.pop_front();
+            Frame &victim = frames_[index];
+            if (victim.dirty) {
+                disk_->WritePage(victim.page_id, victim.data);
+            }
+            page_table_.erase(victim.page_id);
+        } else {
+            throw std::runtime_error("Every frame of the buffer pool is pinned");
+        }
+
+        Frame &frame = frames_[index];
+        if (is_new) {
+            std::memset(frame.data, 0, kPageSize);
+        } else {
+            disk_->ReadPage(page_id, frame.data);
+        }
+        frame.page_id = page_id;
+        frame.pin_count = 1;
+        frame.dirty = is_new;
+        page_table_[page_id] = index;
+        return &frame;
+    }
+
+    void Unpin(Frame *frame, bool dirty) {
+        std::scoped_lock lk(mutex_);
+        frame->dirty = frame->dirty || dirty;
+        if (--frame->pin_count == 0) {
+            frame->lru_position = lru_.insert(lru_.end(), frame - frames_.get());
+        }
+    }
+
+    DiskManager *disk_;
+    std::unique_ptr<Frame[]> frames_;
+    std::mutex mutex_;
+    std::unordered_map<page_id_t, size_t> page_table_;
+    std::vector<size_t> free_frames_;
+    std::list<size_t> lru_;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+};
+
+// PageGuard is the RAII handle for a pinned page, like std::shared_lock
+// (kExclusive = false) or std::unique_lock (kExclusive = true) in rwlock.cpp.
+// As<T>() views the page as a T. AsMut<T>() is only available on write
+// guards, and marks the page dirty so that it is written back on eviction.
+// PageGuard是被固定页的RAII句柄，就像rwlock.cpp中的std::shared_lock
+// （kExclusive = false）或std::unique_lock（kExclusive = true）。As<T>()把页视为
+// 一个T。AsMut<T>()只在写guard上可用，它会把页标记为脏，使其在被淘汰时写回。
+template<bool kExclusive>
+class PageGuard {
+public:
+    PageGuard(BufferPool *pool, Frame *frame) : pool_(pool), frame_(frame) {
+        if constexpr (kExclusive) {
+            frame_->latch.lock();
+        } else {
+            frame_->latch.lock_shared();
+        }
+    }
+
+    PageGuard(PageGuard &&other) noexcept : pool_(other.pool_), frame_(other.frame_), dirty_(other.dirty_) {
+        other.frame_ = nullptr;
+    }
+
+    PageGuard &operator=(PageGuard &&other) noexcept {
+        if (this != &other) {
+            Release();
+            pool_ = other.pool_;
+            frame_ = other.frame_;
+            dirty_ = other.dirty_;
+            other.frame_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~PageGuard() { Release(); }
+
+    page_id_t page_id() const { return frame_->page_id; }
+
+    template<typename T>
+    const T *As() const {
+        return reinterpret_cast<const T *>(frame_->data);
+    }
+
+    template<typename T>
+    T *AsMut() {
+        static_assert(kExclusive, "Only a write guard can modify its page");
+        dirty_ = true;
+        return reinterpret_cast<T *>(frame_->data);
+    }
+
+    // Unlatches and unpins the page before the guard goes out of scope.
+    // 在guard离开作用域之前解锁并取消固定该页。
+    void Release() {
+        if (frame_ == nullptr) {
+            return;
+        }
+        if constexpr (kExclusive) {
+            frame_->latch.unlock();
+        } else {
+            frame_->latch.unlock_shared();
+        }
+        pool_->Unpin(frame_, dirty_);
+        frame_ = nullptr;
+    }
+
+private:
+    BufferPool *pool_;
+    Frame *frame_;
+    bool dirty_ = false;
+};
+
+ReadPageGuard BufferPool::FetchRead(page_id_t page_id) { return ReadPageGuard(this, Pin(page_id, false)); }
+
+WritePageGuard BufferPool::FetchWrite(page_id_t page_id) { return WritePageGuard(this, Pin(page_id, false)); }
+
+WritePageGuard BufferPool::NewPage() { return WritePageGuard(this, Pin(disk_->AllocatePage(), true)); }
+
+// The top kHeaderDepth bits of a hash pick one of the directories, and the
+// low bits pick a bucket inside it. Directories are created on first use and
+// never freed.
+// 哈希值的最高kHeaderDepth位选择一个目录，低位选择目录中的一个桶。目录在第一次使用
+// 时创建，并且永远不会被释放。
+constexpr uint32_t kHeaderDepth = 6;
+
+struct HeaderPage {
+    page_id_t directory_ids[1 << kHeaderDepth];
+};
+
+// A directory has at most 2^kMaxDepth entries, so that it fits in one page.
+// Together with the header this allows 2^15 buckets.
+// 一个目录最多有2^kMaxDepth个项，这样它能放进一个页。加上头部，最多允许2^15个桶。
+struct DirectoryPage {
+    static constexpr uint32_t kMaxDepth = 9;
+
+    uint32_t global_depth;
+    uint8_t local_depths[1 << kMaxDepth];
+    page_id_t bucket_ids[1 << kMaxDepth];
+
+    uint32_t Size() const { return 1u << global_depth; }
+    uint32_t IndexOf(uint32_t hash) const { return hash & (Size() - 1); }
+
+    // Doubles the directory. Entry i + Size() starts out pointing to the
+    // same bucket as entry i, since the buckets do not use the new bit yet.
+    // 把目录加倍。项i + Size()一开始与项i指向同一个桶，因为桶还没有使用新的位。
+    void Grow() {
+        for (uint32_t i = 0; i < Size(); i++) {
+            bucket_ids[i + Size()] = bucket_ids[i];
+            local_depths[i + Size()] = local_depths[i];
+        }
+        global_depth++;
+    }
+
+    bool CanShrink() const {
+        if (global_depth == 0) {
+            return false;
+        }
+        for (uint32_t i = 0; i < Size(); i++) {
+            if (local_depths[i] == global_depth) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Keys are stored inline as NUL-terminated strings of at most kMaxKeySize
+// bytes, so every entry, and every bucket, has a fixed size.
+// 键以最多kMaxKeySize字节的NUL结尾字符串的形式内联存储，所以每个项和每个桶都有
+// 固定的大小。
+constexpr size_t kMaxKeySize = 31;
+
+struct BucketPage {
+    struct Entry {
+        char key[kMaxKeySize + 1];
+        int32_t value;
+    };
+    static constexpr uint32_t kCapacity = (kPageSize - sizeof(uint32_t)) / sizeof(Entry);
+
+    uint32_t size;
+    Entry entries[kCapacity];
+
+    // Returns the index of key, or -1.
+    // 返回key的下标，或者-1。
+    int Find(std::string_view key) const {
+        for (uint32_t i = 0; i < size; i++) {
+            if (key == entries[i].key) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    void Insert(std::string_view key, int32_t value) {
+        Entry &entry = entries[size++];
+        std::memset(entry.key, 0, sizeof(entry.key));
+        std::memcpy(entry.key, key.data(), key.size());
+        entry.value = value;
+    }
+
+    // Order inside a bucket does not matter, so the last entry fills the hole.
+    // 桶内的顺序无关紧要，所以用最后一项填补空洞。
+    void RemoveAt(uint32_t index) { entries[index] = entries[--size]; }
+};
+
+static_assert(sizeof(HeaderPage) <= kPageSize, "HeaderPage must fit in a page");
+static_assert(sizeof(DirectoryPage) <= kPageSize, "DirectoryPage must fit in a page");
+static_assert(sizeof(BucketPage) <= kPageSize, "BucketPage must fit in a page");
+
+// Maps string keys of up to kMaxKeySize bytes to int32_t values. All methods
+// are thread safe. Readers latch pages in shared mode, and hold the latch on
+// a directory until they have latched the bucket it points to ("latch
+// coupling"), so a concurrent split can never move a key out from under them.
+// 把最多kMaxKeySize字节的字符串键映射到int32_t值。所有方法都是线程安全的。读者以
+// 共享模式给页加锁存器，并且会一直持有目录的锁存器，直到给它指向的桶加上锁存器为止
+// （"锁存器耦合"），所以并发的分裂永远不会把键从它们眼皮底下移走。
+class ExtendibleHashTable {
+public:
+    // Creates a new, empty table.
+    // 创建一个新的空表。
+    explicit ExtendibleHashTable(BufferPool *pool) : pool_(pool) {
+        WritePageGuard header = pool_->NewPage();
+        header_page_id_ = header.page_id();
+        HeaderPage *page = header.AsMut<HeaderPage>();
+        for (page_id_t &directory_id: page->directory_ids) {
+            directory_id = kInvalidPageId;
+        }
+    }
+
+    // Opens a table that was created earlier on the same disk.
+    // 打开之前在同一个磁盘上创建的表。
+    ExtendibleHashTable(BufferPool *pool, page_id_t header_page_id)
+        : pool_(pool), header_page_id_(header_page_id) {}
+
+    page_id_t header_page_id() const { return header_page_id_; }
+
+    std::optional<int32_t> Find(std::string_view key) const {
+        uint32_t hash = HashKey(key);
+        page_id_t directory_id = DirectoryFor(hash, false);
+        if (directory_id == kInvalidPageId) {
+            return std::nullopt;
+        }
+        ReadPageGuard directory = pool_->FetchRead(directory_id);
+        const DirectoryPage *dir = directory.As<DirectoryPage>();
+        ReadPageGuard bucket = pool_->FetchRead(dir->bucket_ids[dir->IndexOf(hash)]);
+        directory.Release();
+
+        const BucketPage *page = bucket.As<BucketPage>();
+        int index = page->Find(key);
+        if (index < 0) {
+            return std::nullopt;
+        }
+        return page->entries[index].value;
+    }
+
+    // Inserts the pair if key is absent. Returns false if key was already
+    // present, or if its bucket is full and can no longer be split.
+    // 如果key不存在则插入键值对。如果key已经存在，或者它所在的桶已满且不能再分裂，
+    // 则返回false。
+    bool Insert(std::string_view key, int32_t value) {
+        CheckKey(key);
+        uint32_t hash = HashKey(key);
+        page_id_t directory_id = DirectoryFor(hash, true);
+
+        // Most inserts find room in their bucket, so we first try with only a
+        // shared latch on the directory.
+        // 大多数插入都能在桶中找到空间，所以我们先尝试只在目录上加共享锁存器。
+        {
+            ReadPageGuard directory = pool_->FetchRead(directory_id);
+            const DirectoryPage *dir = directory.As<DirectoryPage>();
+            WritePageGuard bucket = pool_->FetchWrite(dir->bucket_ids[dir->IndexOf(hash)]);
+            directory.Release();
+            const BucketPage *page = bucket.As<BucketPage>();
+            if (page->Find(key) >= 0) {
+                return false;
+            }
+            if (page->size < BucketPage::kCapacity) {
+                bucket.AsMut<BucketPage>()->Insert(key, value);
+                return true;
+            }
+        }
+
+        // The bucket is full: take the directory exclusively and split until
+        // the key's bucket has room. Other threads may have changed things
+        // in between, so we check everything again.
+        // 桶满了：以独占方式获取目录，并不断分裂直到键所在的桶有空间。在此期间其他
+        // 线程可能已经改变了状态，所以我们重新检查一切。
+        WritePageGuard directory = pool_->FetchWrite(directory_id);
+        while (true) {
+            const DirectoryPage *dir = directory.As<DirectoryPage>();
+            uint32_t index = dir->IndexOf(hash);
+            WritePageGuard bucket = pool_->FetchWrite(dir->bucket_ids[index]);
+            const BucketPage *page = bucket.As<BucketPage>();
+            if (page->Find(key) >= 0) {
+                return false;
+            }
+            if (page->size < BucketPage::kCapacity) {
+                bucket.AsMut<BucketPage>()->Insert(key, value);
+                return true;
+            }
+            if (!SplitBucket(directory, index, bucket)) {
+                return false;
+            }
+        }
+    }
+
+    // Removes key. Returns false if it was not present.
+    // 删除key。如果它不存在则返回false。
+    bool Remove(std::string_view key) {
+        uint32_t hash = HashKey(key);
+        page_id_t directory_id = DirectoryFor(hash, false);
+        if (directory_id == kInvalidPageId) {
+            return false;
+        }
+
+        // Like Insert, try with a shared directory latch first. That works
+        // unless the remove empties the bucket, which then has to be merged.
+        // 与Insert一样，先尝试使用目录的共享锁存器。除非删除使桶变空（这时需要合并），
+        // 否则这样就够了。
+        {
+            ReadPageGuard directory = pool_->FetchRead(directory_id);
+            const DirectoryPage *dir = directory.As<DirectoryPage>();
+            WritePageGuard bucket = pool_->FetchWrite(dir->bucket_ids[dir->IndexOf(hash)]);
+            directory.Release();
+            int index = bucket.As<BucketPage>()->Find(key);
+            if (index < 0) {
+                return false;
+            }
+            if (bucket.As<BucketPage>()->size > 1) {
+                bucket.AsMut<BucketPage>()->RemoveAt(index);
+                return true;
+            }
+        }
+
+        WritePageGuard directory = pool_->FetchWrite(directory_id);
+        const DirectoryPage *dir = directory.As<DirectoryPage>();
+        uint32_t index = dir->IndexOf(hash);
+        WritePageGuard bucket = pool_->FetchWrite(dir->bucket_ids[index]);
+        int entry = bucket.As<BucketPage>()->Find(key);
+        if (entry < 0) {
+            return false;
+        }
+        BucketPage *page = bucket.AsMut<BucketPage>();
+        page->RemoveAt(entry);
+        if (page->size == 0) {
+            MergeBuckets(directory, index, std::move(bucket));
+        }
+        return true;
+    }
+
+    // Returns the number of bucket pages, and the largest global depth of any
+    // directory.
+    // 返回桶页的数量，以及所有目录中最大的全局深度。
+    std::pair<size_t, uint32_t> Shape() const {
+        ReadPageGuard header = pool_->FetchRead(header_page_id_);
+        size_t buckets = 0;
+        uint32_t max_depth = 0;
+        for (page_id_t directory_id: header.As<HeaderPage>()->directory_ids) {
+            if (directory_id == kInvalidPageId) {
+                continue;
+            }
+            ReadPageGuard directory = pool_->FetchRead(directory_id);
+            const DirectoryPage *dir = directory.As<DirectoryPage>();
+            max_depth = std::max(max_depth, dir->global_depth);
+            // A bucket with local depth L is referenced by every 2^L-th entry,
+            // and we count it at its first one.
+            // 局部深度为L的桶每隔2^L个项被引用一次，我们在它的第一个项处计数。
+            for (uint32_t i = 0; i < dir->Size(); i++) {
+                if (i < (1u << dir->local_depths[i])) {
+                    buckets++;
+                }
+            }
+        }
+        return {buckets, max_depth};
+    }
+
+private:
+    static void CheckKey(std::string_view key) {
+        if (key.size() > kMaxKeySize) {
+            throw std::length_error("ExtendibleHashTable keys are at most 31 bytes");
+        }
+    }
+
+    // Mixes std::hash so that both the top bits (header) and the low bits
+    // (directory) are well distributed.
+    // 混合std::hash，使最高位（头部）和低位（目录）都分布良好。
+    static uint32_t HashKey(std::string_view key) {
+        uint64_t h = std::hash<std::string_view>()(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return static_cast<uint32_t>(h);
+    }
+
+    // Returns the directory for hash, creating it (and its first bucket) if
+    // create is true. Directories are never freed, so the caller can use the
+    // id after the header latch is released.
+    // 返回hash对应的目录，如果create为true则创建它（以及它的第一个桶）。目录永远
+    // 不会被释放，所以调用者可以在头部锁存器释放之后使用这个id。
+    page_id_t DirectoryFor(uint32_t hash, bool create) const {
+        uint32_t slot = hash >> (32 - kHeaderDepth);
+        {
+            ReadPageGuard header = pool_->FetchRead(header_page_id_);
+            page_id_t directory_id = header.As<HeaderPage>()->directory_ids[slot];
+            if (directory_id != kInvalidPageId || !create) {
+                return directory_id;
+            }
+        }
+        WritePageGuard header = pool_->FetchWrite(header_page_id_);
+        page_id_t directory_id = header.As<HeaderPage>()->directory_ids[slot];
+        if (directory_id != kInvalidPageId) {
+            return directory_id;
+        }
+        WritePageGuard directory = pool_->NewPage();
+        WritePageGuard bucket = pool_->NewPage();
+        DirectoryPage *dir = directory.AsMut<DirectoryPage>();
+        dir->global_depth = 0;
+        dir->local_depths[0] = 0;
+        dir->bucket_ids[0] = bucket.page_id();
+        bucket.AsMut<BucketPage>()->size = 0;
+        header.AsMut<HeaderPage>()->directory_ids[slot] = directory.page_id();
+        return directory.page_id();
+    }
+
+    // Splits the full bucket at directory entry index into itself and a new
+    // "split image" that takes the keys whose next hash bit is 1. Returns
+    // false if the directory is already at kMaxDepth and cannot double.
+    // 把目录项index处的满桶分裂为它自己和一个新的"分裂镜像"，后者接收下一个哈希位
+    // 为1的键。如果目录已经达到kMaxDepth而不能加倍，则返回false。
+    bool SplitBucket(WritePageGuard &directory, uint32_t index, WritePageGuard &bucket) {
+        DirectoryPage *dir = directory.AsMut<DirectoryPage>();
+        uint8_t local_depth = dir->local_depths[index];
+        if (local_depth == dir->global_depth) {
+            if (dir->global_depth == DirectoryPage::kMaxDepth) {
+                return false;
+            }
+            dir->Grow();
+        }
+
+        WritePageGuard image = pool_->NewPage();
+        BucketPage *image_page = image.AsMut<BucketPage>();
+        BucketPage *page = bucket.AsMut<BucketPage>();
+        image_page->size = 0;
+
+        uint32_t split_bit = 1u << local_depth;
+        page_id_t bucket_id = bucket.page_id();
+        for (uint32_t i = 0; i < dir->Size(); i++) {
+            if (dir->bucket_ids[i] == bucket_id) {
+                dir->local_depths[i] = local_depth + 1;
+                if ((i & split_bit) != 0) {
+                    dir->bucket_ids[i] = image.page_id();
+                }
+            }
+        }
+        for (uint32_t i = 0; i < page->size;) {
+            if ((HashKey(page->entries[i].key) & split_bit) != 0) {
+                image_page->entries[image_page->size++] = page->entries[i];
+                page->RemoveAt(i);
+            } else {
+                i++;
+            }
+        }
+        return true;
+    }
+
+    // Merges the bucket at directory entry index with its split image while
+    // one of the two is empty, then halves the directory while it can.
+    // 当两者之一为空时，把目录项index处的桶与它的分裂镜像合并，然后在可能的情况下
+    // 把目录减半。
+    void MergeBuckets(WritePageGuard &directory, uint32_t index, WritePageGuard bucket) {
+        DirectoryPage *dir = directory.AsMut<DirectoryPage>();
+        while (dir->local_depths[index] > 0) {
+            uint8_t local_depth = dir->local_depths[index];
+            uint32_t image_index = index ^ (1u << (local_depth - 1));
+            if (dir->local_depths[image_index] != local_depth) {
+                break;
+            }
+            WritePageGuard image = pool_->FetchWrite(dir->bucket_ids[image_index]);
+            if (bucket.As<BucketPage>()->size != 0 && image.As<BucketPage>()->size != 0) {
+                break;
+            }
+            // Keep the bucket that still has entries and drop the other one.
+            // 保留仍有项的桶，丢弃另一个。
+            if (bucket.As<BucketPage>()->size == 0) {
+                std::swap(bucket, image);
+                std::swap(index, image_index);
+            }
+            page_id_t keep_id = bucket.page_id();
+            page_id_t drop_id = image.page_id();
+            for (uint32_t i = 0; i < dir->Size(); i++) {
+                if (dir->bucket_ids[i] == keep_id || dir->bucket_ids[i] == drop_id) {
+                    dir->bucket_ids[i] = keep_id;
+                    dir->local_depths[i] = local_depth - 1;
+                }
+            }
+            // No other thread can reach the dropped page: we hold the
+            // directory exclusively, and we held the page's own latch until
+            // now, so nobody who found it earlier is still using it.
+            // 其他线程不可能访问到被丢弃的页：我们以独占方式持有目录，并且直到现在都
+            // 持有该页自己的锁存器，所以之前找到它的人都不会还在使用它。
+            image.Release();
+            pool_->DeletePage(drop_id);
+        }
+        while (dir->CanShrink()) {
+            dir->global_depth--;
+        }
+    }
+
+    BufferPool *pool_;
+    page_id_t header_page_id_;
+};
+
+// Returns the p-th quantile (0 <= p <= 1) of sorted.
+// 返回sorted的第p分位数（0 <= p <= 1）。
+double Percentile(const std::vector<double> &sorted, double p) {
+    size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+    return sorted[index];
+}
+
+// Builds a table of 200K keys (about 2,500 bucket pages, or 10 MB), then
+// reopens it with buffer pools of different sizes and measures the latency
+// of random lookups from four threads. Only the largest pool holds the whole
+// table. The file stays in the operating system's page cache, so a miss here
+// costs a system call and a 4 KB copy rather than a real disk read; on an
+// actual disk the gap between the rows would be far larger.
+// 构建一个有200K个键的表（大约2,500个桶页，即10 MB），然后用不同大小的缓冲池重新
+// 打开它，并测量四个线程随机查找的延迟。只有最大的缓冲池能容纳整个表。文件留在
+// 操作系统的页缓存中，所以这里的一次未命中花费的是一次系统调用和一次4 KB拷贝，
+// 而不是真正的磁盘读取；在真实的磁盘上，各行之间的差距会大得多。
+void RunBenchmark(DiskManager *disk) {
+    const int num_keys = 200'000;
+    const int lookups_per_thread = 50'000;
+    const int num_threads = 4;
+
+    page_id_t header_page_id;
+    {
+        BufferPool pool(disk, 64);
+        ExtendibleHashTable table(&pool);
+        header_page_id = table.header_page_id();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_keys; i++) {
+            table.Insert("key" + std::to_string(i), i);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        auto [buckets, depth] = table.Shape();
+        std::cout << "Inserted " << num_keys << " keys through a 64-frame pool in "
+                  << std::chrono::duration<double, std::milli>(stop - start).count() << " ms: " << buckets
+                  << " buckets, max global depth " << depth << "\n";
+    }
+
+    std::cout << "Lookup latency in us (" << num_threads << " threads):\n";
+    for (size_t num_frames: {64, 512, 4096}) {
+        BufferPool pool(disk, num_frames);
+        ExtendibleHashTable table(&pool, header_page_id);
+        std::vector<std::vector<double>> latencies(num_threads);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back([&table, &latencies, t, num_keys, lookups_per_thread] {
+                std::mt19937 rng(t);
+                for (int i = 0; i < lookups_per_thread; i++) {
+                    std::string key = "key" + std::to_string(rng() % num_keys);
+                    auto start = std::chrono::steady_clock::now();
+                    std::optional<int32_t> value = table.Find(key);
+                    auto stop = std::chrono::steady_clock::now();
+                    if (!value.has_value()) {
+                        std::cout << "Lost key " << key << "\n";
+                    }
+                    latencies[t].push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+                }
+            });
+        }
+        for (std::thread &thread: threads) {
+            thread.join();
+        }
+        std::vector<double> all;
+        for (const std::vector<double> &thread_latencies: latencies) {
+            all.insert(all.end(), thread_latencies.begin(), thread_latencies.end());
+        }
+        std::sort(all.begin(), all.end());
+        double hit_rate = static_cast<double>(pool.hits()) / (pool.hits() + pool.misses());
+        std::cout << "  " << num_frames << " frames (" << num_frames * kPageSize / 1024 << " KB), hit rate "
+                  << hit_rate << ": p50 " << Percentile(all, 0.5) << ", p90 " << Percentile(all, 0.9) << ", p99 "
+                  << Percentile(all, 0.99) << ", p99.9 " << Percentile(all, 0.999) << ", max " << all.back()
+                  << "\n";
+    }
+
+    // Removing every key merges the buckets back and shrinks the directories.
+    // 删除所有键会把桶合并回去并缩小目录。
+    BufferPool pool(disk, 64);
+    ExtendibleHashTable table(&pool, header_page_id);
+    for (int i = 0; i < num_keys; i++) {
+        table.Remove("key" + std::to_string(i));
+    }
+    auto [buckets, depth] = table.Shape();
+    std::cout << "After removing every key: " << buckets << " buckets, max global depth " << depth << "\n";
+}
+
+int main() {
+    DiskManager disk("extendible_hash_table.db");
+
+    // The table is used like the std::unordered_map in unordered_maps.cpp,
+    // through a buffer pool of just 16 pages.
+    // 这个表的用法类似于unordered_maps.cpp中的std::unordered_map，通过一个只有16页
+    // 的缓冲池来使用。
+    {
+        BufferPool pool(&disk, 16);
+        ExtendibleHashTable table(&pool);
+        table.Insert("foo", 2);
+        table.Insert("jignesh", 445);
+        table.Insert("spam", 1);
+        table.Insert("eggs", 2);
+
+        std::optional<int32_t> result = table.Find("jignesh");
+        if (result.has_value()) {
+            std::cout << "Found key jignesh with value " << *result << std::endl;
+        }
+        if (!table.Insert("spam", 15)) {
+            std::cout << "Key spam is already in the table.\n";
+        }
+        table.Remove("eggs");
+        if (!table.Find("eggs").has_value()) {
+            std::cout << "Key eggs does not exist in the table.\n";
+        }
+
+        // Enough keys to split buckets and double directories many times.
+        // 足够多的键，使桶分裂、目录加倍很多次。
+        for (int i = 0; i < 20'000; i++) {
+            table.Insert("key" + std::to_string(i), i);
+        }
+        auto [buckets, depth] = table.Shape();
+        std::cout << "20000 keys use " << buckets << " buckets of " << BucketPage::kCapacity
+                  << " entries, max global depth " << depth << ", " << disk.reads() << " page reads and "
+                  << disk.writes() << " page writes so far\n";
+    }
+
+    RunBenchmark(&disk);
+
+    return 0;
+}
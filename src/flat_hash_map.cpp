@@ -0,0 +1,785 @@
+/**
+ * @file flat_hash_map.cpp
+ * @brief Tutorial code for an open-addressing, SwissTable-style hash map.
+ * @brief 开放寻址的SwissTable风格哈希映射的教程代码。
+ */
+
+// std::unordered_map (unordered_maps.cpp) is a "node based" hash table: the
+// table is an array of buckets, and every key-value pair lives in its own
+// heap-allocated node that is chained off a bucket. That means one allocation
+// per insert, and at least two dependent cache misses (bucket, then node) for
+// every find, count or operator[].
+// std::unordered_map（unordered_maps.cpp）是一个"基于节点"的哈希表：表是一个
+// 桶的数组，每个键值对都存在它自己的堆分配节点中，节点挂在某个桶的链上。这意味着
+// 每次插入都要分配一次内存，而每次find、count或operator[]至少有两次相互依赖的
+// 缓存未命中（先是桶，然后是节点）。
+
+// FlatHashMap follows Google's SwissTable (absl::flat_hash_map) design. The
+// pairs are stored directly in one big array of slots ("open addressing").
+// Next to it is an array of one-byte "control" entries, one per slot:
+//   - kEmpty (0b10000000) if the slot was never used,
+//   - kDeleted (0b11111110) if the slot held a pair that was erased,
+//   - otherwise the low 7 bits of the key's hash (called H2).
+// The rest of the hash (H1) picks a group of 16 slots to start probing. With
+// SSE2 we compare all 16 control bytes of a group against H2 in one
+// instruction, and only compare real keys for the (few) bytes that match.
+// FlatHashMap遵循Google的SwissTable（absl::flat_hash_map）设计。键值对直接存储
+// 在一个大的槽数组中（"开放寻址"）。在它旁边是一个单字节"控制"项的数组，每个槽
+// 一个：
+//   - 如果槽从未被使用过，则为kEmpty（0b10000000），
+//   - 如果槽中的键值对已被删除，则为kDeleted（0b11111110），
+//   - 否则为键的哈希值的低7位（称为H2）。
+// 哈希值的其余部分（H1）选择一个从哪里开始探测的16个槽组成的组。使用SSE2，我们
+// 可以用一条指令把一个组的全部16个控制字节与H2进行比较，并且只对（少数）匹配的
+// 字节比较真正的键。
+
+// Includes std::max.
+// 包含std::max。
+#include <algorithm>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as int8_t.
+// 包含int8_t等定宽整数类型。
+#include <cstdint>
+// Includes std::malloc and std::free, used by the counting operator new.
+// 包含std::malloc和std::free，供计数的operator new使用。
+#include <cstdlib>
+// Includes std::memset.
+// 包含std::memset。
+#include <cstring>
+// Includes std::hash and std::equal_to.
+// 包含std::hash和std::equal_to。
+#include <functional>
+// Includes std::initializer_list.
+// 包含std::initializer_list。
+#include <initializer_list>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes std::allocator.
+// 包含std::allocator。
+#include <memory>
+// Includes placement new.
+// 包含placement new。
+#include <new>
+// Includes std::mt19937_64, used by the batch lookup benchmark.
+// 包含std::mt19937_64，供批量查找基准测试使用。
+#include <random>
+// Includes the C++ string library.
+// 包含C++字符串库。
+#include <string>
+// Includes std::string_view, the borrowed key type for heterogeneous lookups.
+// 包含std::string_view，异构查找中借用的键类型。
+#include <string_view>
+// Includes std::enable_if_t and std::void_t.
+// 包含std::enable_if_t和std::void_t。
+#include <type_traits>
+// Includes the unordered_map container library header, for comparison.
+// 包含unordered_map容器库头文件，用于对比。
+#include <unordered_map>
+// Includes std::pair and std::move.
+// 包含std::pair和std::move。
+#include <utility>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+// Includes the SSE2 intrinsics used to match a whole group at once. Without
+// SSE2 the group is scanned one byte at a time.
+// 包含用于一次匹配整个组的SSE2内建函数。没有SSE2时，组会被逐字节扫描。
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The control byte values. Full slots hold H2, which is in [0, 127], so the
+// top bit tells full slots apart from empty and deleted ones.
+// 控制字节的取值。满的槽保存H2，它在[0, 127]范围内，所以最高位可以把满的槽与空的
+// 和已删除的槽区分开来。
+constexpr int8_t kEmpty = -128;
+constexpr int8_t kDeleted = -2;
+constexpr size_t kGroupSize = 16;
+
+// A Group is a view of 16 consecutive control bytes. Each Match function
+// returns a 16-bit mask with one bit per slot of the group.
+// Group是16个连续控制字节的视图。每个Match函数返回一个16位的掩码，组中的每个槽
+// 对应一位。
+class Group {
+public:
+    explicit Group(const int8_t *ctrl) : ctrl_(ctrl) {}
+
+#if defined(__SSE2__)
+    uint32_t Match(int8_t h2) const { return _mm_movemask_epi8(_mm_cmpeq_epi8(Load(), _mm_set1_epi8(h2))); }
+    uint32_t MatchEmpty() const { return Match(kEmpty); }
+    // Empty and deleted both have their top bit set, and movemask collects
+    // exactly the top bits.
+    // 空和已删除的最高位都被设置了，而movemask收集的正是这些最高位。
+    uint32_t MatchEmptyOrDeleted() const { return _mm_movemask_epi8(Load()); }
+
+private:
+    __m128i Load() const { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl_)); }
+#else
+    uint32_t Match(int8_t h2) const {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupSize; i++) {
+            mask |= static_cast<uint32_t>(ctrl_[i] == h2) << i;
+        }
+        return mask;
+    }
+    uint32_t MatchEmpty() const { return Match(kEmpty); }
+    uint32_t MatchEmptyOrDeleted() const {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupSize; i++) {
+            mask |= static_cast<uint32_t>(ctrl_[i] < 0) << i;
+        }
+        return mask;
+    }
+
+private:
+#endif
+    const int8_t *ctrl_;
+};
+
+// IsTransparent<T> is true if T declares an is_transparent member type. This
+// is the standard way for a hasher or comparator to say that it accepts more
+// than one argument type (std::less<> does the same for std::set).
+// 如果T声明了一个is_transparent成员类型，IsTransparent<T>就为true。这是哈希器
+// 或比较器表示它接受不止一种参数类型的标准方式（std::less<>对std::set也是这样
+// 做的）。
+template<typename T, typename = void>
+struct IsTransparent : std::false_type {};
+template<typename T>
+struct IsTransparent<T, std::void_t<typename T::is_transparent>> : std::true_type {};
+
+// A transparent hasher and comparator for std::string keys. Both take
+// std::string_view, which std::string, const char * and std::string_view all
+// convert to without allocating. Hashing a std::string_view gives the same
+// value as hashing the equal std::string, so lookups find what inserts stored.
+// 用于std::string键的透明哈希器和比较器。它们都接受std::string_view，而
+// std::string、const char *和std::string_view都能在不分配内存的情况下转换为它。
+// 对std::string_view求哈希与对相等的std::string求哈希得到相同的值，所以查找能
+// 找到插入时存入的内容。
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+};
+
+struct StringEqual {
+    using is_transparent = void;
+    bool operator()(std::string_view a, std::string_view b) const { return a == b; }
+};
+
+// FlatHashMap has the std::unordered_map interface used in unordered_maps.cpp.
+// One simplification: value_type is std::pair<Key, Value> rather than
+// std::pair<const Key, Value>, so that pairs can be moved cheaply when the
+// table grows. Do not modify a key through an iterator!
+// FlatHashMap具有unordered_maps.cpp中使用的std::unordered_map接口。有一个简化：
+// value_type是std::pair<Key, Value>而不是std::pair<const Key, Value>，这样在表
+// 增长时可以廉价地移动键值对。不要通过迭代器修改键！
+template<typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap {
+    // Enables an overload for lookup key type K when the hasher and the key
+    // comparator are both transparent. It depends on K, so that a failure is
+    // a substitution failure rather than a compile error.
+    // 当哈希器和键比较器都是透明的时，为查找键类型K启用一个重载。它依赖于K，这样
+    // 失败时是一个替换失败而不是编译错误。
+    template<typename K>
+    using EnableIfTransparent = std::enable_if_t<IsTransparent<Hash>::value && IsTransparent<KeyEqual>::value &&
+                                                         !std::is_same<std::decay_t<K>, Key>::value,
+                                                 int>;
+
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<Key, Value>;
+
+    class iterator {
+    public:
+        iterator(const FlatHashMap *map, size_t index) : map_(map), index_(index) { SkipEmpty(); }
+
+        value_type &operator*() const { return map_->slots_[index_]; }
+        value_type *operator->() const { return &map_->slots_[index_]; }
+
+        iterator &operator++() {
+            index_++;
+            SkipEmpty();
+            return *this;
+        }
+
+        bool operator==(const iterator &other) const { return index_ == other.index_; }
+        bool operator!=(const iterator &other) const { return index_ != other.index_; }
+
+    private:
+        friend class FlatHashMap;
+
+        void SkipEmpty() {
+            while (index_ < map_->capacity_ && map_->ctrl_[index_] < 0) {
+                index_++;
+            }
+        }
+
+        const FlatHashMap *map_;
+        size_t index_;
+    };
+
+    FlatHashMap() = default;
+
+    FlatHashMap(std::initializer_list<value_type> init) { insert(init); }
+
+    ~FlatHashMap() { DestroyAll(); }
+
+    FlatHashMap(const FlatHashMap &) = delete;
+    FlatHashMap &operator=(const FlatHashMap &) = delete;
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, capacity_); }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // The number of slots. Like bucket_count() for std::unordered_map.
+    // 槽的数量。类似于std::unordered_map的bucket_count()。
+    size_t bucket_count() const { return capacity_; }
+    float load_factor() const { return capacity_ == 0 ? 0.0f : static_cast<float>(size_) / capacity_; }
+
+    // The table grows when it would be more than 7/8 full (counting deleted
+    // slots). Probing stays short at this load thanks to the 16-wide groups.
+    // 当表会超过7/8满（包括已删除的槽）时它就会增长。得益于16宽的组，在这个负载
+    // 下探测仍然很短。
+    float max_load_factor() const { return 7.0f / 8.0f; }
+
+    // Bytes of heap memory owned by the map: the slots and the control bytes.
+    // 映射拥有的堆内存字节数：槽和控制字节。
+    size_t MemoryUsage() const { return capacity_ * (sizeof(value_type) + 1); }
+
+    // Makes room for count pairs without growing again.
+    // 为count个键值对预留空间，不需要再次增长。
+    void reserve(size_t count) { rehash(count * 8 / 7 + 1); }
+
+    // Rebuilds the table with at least count slots (rounded up to a power of
+    // two, at least 16), and never fewer than the current size needs.
+    // 用至少count个槽（向上取整为2的幂，至少为16）重建表，并且不会少于当前大小
+    // 所需要的槽数。
+    void rehash(size_t count) {
+        size_t needed = std::max(count, size_ * 8 / 7 + 1);
+        size_t new_capacity = kGroupSize;
+        while (new_capacity < needed) {
+            new_capacity *= 2;
+        }
+        Resize(new_capacity);
+    }
+
+    iterator find(const Key &key) const {
+        size_t index = FindIndex(key, HashOf(key));
+        return index == kNotFound ? end() : iterator(this, index);
+    }
+
+    size_t count(const Key &key) const { return FindIndex(key, HashOf(key)) == kNotFound ? 0 : 1; }
+
+    // Looks up n keys and stores find(keys[i]) in out[i]. In a big table
+    // almost every find misses the cache twice, on the control group and
+    // then on the slot, and a loop of find calls waits for each miss before
+    // starting the next lookup. FindBatch works on groups of kBatch keys in
+    // three passes instead: hash every key and prefetch its control group,
+    // then match H2 and prefetch the first candidate slot, then finish each
+    // lookup. The misses of a whole group overlap ("group prefetching").
+    // 查找n个键，并把find(keys[i])存入out[i]。在大表中，几乎每次find都会有两次缓存
+    // 未命中，先是控制组，然后是槽，而一个调用find的循环会等每次未命中结束后才开始
+    // 下一次查找。FindBatch改为分三遍处理每组kBatch个键：对每个键求哈希并预取它的
+    // 控制组，然后匹配H2并预取第一个候选槽，最后完成每次查找。这样一整组的未命中会
+    // 重叠起来（"组预取"）。
+    void FindBatch(const Key *keys, size_t n, iterator *out) const {
+        constexpr size_t kBatch = 32;
+        if (capacity_ == 0) {
+            std::fill(out, out + n, end());
+            return;
+        }
+        size_t group_mask = capacity_ / kGroupSize - 1;
+        size_t hashes[kBatch];
+        for (size_t start = 0; start < n; start += kBatch) {
+            size_t count = std::min(kBatch, n - start);
+            for (size_t i = 0; i < count; i++) {
+                hashes[i] = HashOf(keys[start + i]);
+                __builtin_prefetch(ctrl_.get() + (H1(hashes[i]) & group_mask) * kGroupSize);
+            }
+            for (size_t i = 0; i < count; i++) {
+                size_t group = H1(hashes[i]) & group_mask;
+                uint32_t match = Group(ctrl_.get() + group * kGroupSize).Match(H2(hashes[i]));
+                if (match != 0) {
+                    __builtin_prefetch(&slots_[group * kGroupSize + __builtin_ctz(match)]);
+                }
+            }
+            for (size_t i = 0; i < count; i++) {
+                size_t index = FindIndex(keys[start + i], hashes[i]);
+                out[start + i] = index == kNotFound ? end() : iterator(this, index);
+            }
+        }
+    }
+
+    // Heterogeneous lookups. When both Hash and KeyEqual are transparent
+    // (see StringHash below), find, count and erase accept any type that they
+    // can hash and compare, such as std::string_view or const char *, and no
+    // temporary Key is ever built. Otherwise these overloads disappear and
+    // the argument is converted to Key as usual.
+    // 异构查找。当Hash和KeyEqual都是透明的（见下面的StringHash）时，find、count和
+    // erase接受任何它们能够哈希和比较的类型，例如std::string_view或const char *，
+    // 并且永远不会构造临时的Key。否则这些重载会消失，参数像往常一样被转换为Key。
+    template<typename K, EnableIfTransparent<K> = 0>
+    iterator find(const K &key) const {
+        size_t index = FindIndex(key, HashOf(key));
+        return index == kNotFound ? end() : iterator(this, index);
+    }
+
+    template<typename K, EnableIfTransparent<K> = 0>
+    size_t count(const K &key) const {
+        return FindIndex(key, HashOf(key)) == kNotFound ? 0 : 1;
+    }
+
+    template<typename K, EnableIfTransparent<K> = 0>
+    size_t erase(const K &key) {
+        size_t index = FindIndex(key, HashOf(key));
+        if (index == kNotFound) {
+            return 0;
+        }
+        EraseAt(index);
+        return 1;
+    }
+
+    std::pair<iterator, bool> insert(const value_type &pair) { return TryEmplace(pair.first, pair.second); }
+    std::pair<iterator, bool> insert(value_type &&pair) {
+        return TryEmplace(std::move(pair.first), std::move(pair.second));
+    }
+    void insert(std::initializer_list<value_type> pairs) {
+        for (const value_type &pair: pairs) {
+            insert(pair);
+        }
+    }
+
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args &&...args) {
+        return insert(value_type(std::forward<Args>(args)...));
+    }
+
+    Value &operator[](const Key &key) { return TryEmplace(key, Value()).first->second; }
+
+    size_t erase(const Key &key) {
+        size_t index = FindIndex(key, HashOf(key));
+        if (index == kNotFound) {
+            return 0;
+        }
+        EraseAt(index);
+        return 1;
+    }
+
+    iterator erase(iterator pos) {
+        EraseAt(pos.index_);
+        return iterator(this, pos.index_ + 1);
+    }
+
+private:
+    static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+    // Scrambles the user's hash so that both H1 and H2 get good bits, even
+    // for std::hash<int> which is the identity function.
+    // 打乱用户的哈希值，使H1和H2都能得到质量好的位，即使对于恒等函数
+    // std::hash<int>也是如此。
+    template<typename K>
+    size_t HashOf(const K &key) const {
+        uint64_t h = hasher_(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    static int8_t H2(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+    static size_t H1(size_t hash) { return hash >> 7; }
+
+    // Probing visits groups in triangular order: g, g + 1, g + 3, g + 6, ...
+    // When the number of groups is a power of two, this visits every group.
+    // 探测按三角数的顺序访问组：g、g + 1、g + 3、g + 6……当组的数量是2的幂时，
+    // 这会访问到每一个组。
+    template<typename K>
+    size_t FindIndex(const K &key, size_t hash) const {
+        if (capacity_ == 0) {
+            return kNotFound;
+        }
+        size_t group_mask = capacity_ / kGroupSize - 1;
+        size_t group = H1(hash) & group_mask;
+        for (size_t step = 1;; step++) {
+            Group g(ctrl_.get() + group * kGroupSize);
+            for (uint32_t match = g.Match(H2(hash)); match != 0; match &= match - 1) {
+                size_t index = group * kGroupSize + __builtin_ctz(match);
+                if (key_equal_(slots_[index].first, key)) {
+                    return index;
+                }
+            }
+            // An empty slot ends the probe: if the key were in the table, it
+            // would have been put here or earlier.
+            // 空槽结束探测：如果键在表中，它应该被放在这里或者更早的位置。
+            if (g.MatchEmpty() != 0) {
+                return kNotFound;
+            }
+            group = (group + step) & group_mask;
+        }
+    }
+
+    // Returns the first empty or deleted slot on the probe sequence of hash.
+    // 返回hash的探测序列上第一个空的或已删除的槽。
+    size_t FindInsertSlot(size_t hash) const {
+        size_t group_mask = capacity_ / kGroupSize - 1;
+        size_t group = H1(hash) & group_mask;
+        for (size_t step = 1;; step++) {
+            uint32_t free = Group(ctrl_.get() + group * kGroupSize).MatchEmptyOrDeleted();
+            if (free != 0) {
+                return group * kGroupSize + __builtin_ctz(free);
+            }
+            group = (group + step) & group_mask;
+        }
+    }
+
+    template<typename K, typename V>
+    std::pair<iterator, bool> TryEmplace(K &&key, V &&value) {
+        size_t hash = HashOf(key);
+        size_t index = FindIndex(key, hash);
+        if (index != kNotFound) {
+            return {iterator(this, index), false};
+        }
+        if (capacity_ == 0) {
+            Resize(kGroupSize);
+        }
+        index = FindInsertSlot(hash);
+        if (ctrl_[index] == kEmpty && growth_left_ == 0) {
+            // Too full. If many slots are tombstones, rebuilding at the same
+            // size is enough to clean them up; otherwise double the capacity.
+            // 太满了。如果有许多槽是墓碑，以相同大小重建就足以清理它们；否则把
+            // 容量加倍。
+            Resize(size_ * 2 < capacity_ * 7 / 8 ? capacity_ : capacity_ * 2);
+            index = FindInsertSlot(hash);
+        }
+        if (ctrl_[index] == kEmpty) {
+            growth_left_--;
+        }
+        new (&slots_[index]) value_type(std::forward<K>(key), std::forward<V>(value));
+        ctrl_[index] = H2(hash);
+        size_++;
+        return {iterator(this, index), true};
+    }
+
+    // If the slot's group still has an empty slot, no probe ever continued
+    // past this group, so the slot can become empty again. Otherwise it must
+    // become a tombstone (kDeleted) so that probes keep going past it.
+    // 如果该槽所在的组仍然有空槽，那么从来没有任何探测越过这个组，所以该槽可以重新
+    // 变为空。否则它必须变为墓碑（kDeleted），这样探测才会继续越过它。
+    void EraseAt(size_t index) {
+        slots_[index].~value_type();
+        size_--;
+        size_t group_start = index / kGroupSize * kGroupSize;
+        if (Group(ctrl_.get() + group_start).MatchEmpty() != 0) {
+            ctrl_[index] = kEmpty;
+            growth_left_++;
+        } else {
+            ctrl_[index] = kDeleted;
+        }
+    }
+
+    void Resize(size_t new_capacity) {
+        std::unique_ptr<int8_t[]> old_ctrl = std::move(ctrl_);
+        value_type *old_slots = slots_;
+        size_t old_capacity = capacity_;
+
+        capacity_ = new_capacity;
+        ctrl_.reset(new int8_t[capacity_]);
+        std::memset(ctrl_.get(), kEmpty, capacity_);
+        slots_ = allocator_.allocate(capacity_);
+        growth_left_ = capacity_ * 7 / 8 - size_;
+
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old_ctrl[i] >= 0) {
+                size_t hash = HashOf(old_slots[i].first);
+                size_t index = FindInsertSlot(hash);
+                new (&slots_[index]) value_type(std::move(old_slots[i]));
+                ctrl_[index] = H2(hash);
+                old_slots[i].~value_type();
+            }
+        }
+        if (old_slots != nullptr) {
+            allocator_.deallocate(old_slots, old_capacity);
+        }
+    }
+
+    void DestroyAll() {
+        for (size_t i = 0; i < capacity_; i++) {
+            if (ctrl_[i] >= 0) {
+                slots_[i].~value_type();
+            }
+        }
+        if (slots_ != nullptr) {
+            allocator_.deallocate(slots_, capacity_);
+        }
+    }
+
+    std::unique_ptr<int8_t[]> ctrl_;
+    value_type *slots_{nullptr};
+    size_t capacity_{0};
+    size_t size_{0};
+    // How many more empty slots may be filled before the table must grow.
+    // 在表必须增长之前还可以填充多少个空槽。
+    size_t growth_left_{0};
+    std::allocator<value_type> allocator_;
+    Hash hasher_;
+    KeyEqual key_equal_;
+};
+
+// CountingAllocator forwards to std::allocator, but adds every allocation to
+// a global byte counter. We plug it into std::unordered_map to see how much
+// memory its nodes and bucket array take.
+// CountingAllocator转发给std::allocator，但会把每次分配的字节数累加到一个全局
+// 计数器中。我们把它用于std::unordered_map，以看到它的节点和桶数组占用了多少
+// 内存。
+size_t allocated_bytes = 0;
+
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        allocated_bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T *p, size_t n) {
+        allocated_bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const CountingAllocator<U> &) const { return true; }
+    template<typename U>
+    bool operator!=(const CountingAllocator<U> &) const { return false; }
+};
+
+// To prove that heterogeneous lookups do not allocate, we replace the global
+// operator new and count every call. This sees all heap allocations in the
+// program, including the temporary std::string that std::unordered_map::find
+// builds from a const char *.
+// 为了证明异构查找不会分配内存，我们替换全局的operator new并统计每次调用。这能
+// 看到程序中所有的堆分配，包括std::unordered_map::find从const char *构造的临时
+// std::string。
+size_t heap_allocations = 0;
+
+void *operator new(size_t size) {
+    heap_allocations++;
+    if (void *p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+// Returns the nanoseconds per iteration of running func n times.
+// 返回运行func n次时每次迭代的纳秒数。
+template<typename Func>
+double NsPerOp(size_t n, Func func) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++) {
+        func(i);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / n;
+}
+
+// Compares insert, lookup and memory against std::unordered_map. The keys are
+// short strings that fit in std::string's small-string buffer, so the memory
+// numbers measure the tables themselves. We stop at 1M keys to keep the run
+// short; set kMaxKeys to 100'000'000 on a machine with enough memory.
+// 比较插入、查找和内存与std::unordered_map的表现。键是能放进std::string小字符串
+// 缓冲区的短字符串，所以内存数字衡量的是表本身。为了让运行时间短一些，我们在1M个
+// 键时停止；在内存足够的机器上可以把kMaxKeys设置为100'000'000。
+void RunBenchmark() {
+    constexpr size_t kMaxKeys = 1'000'000;
+    using StdMap = std::unordered_map<std::string, int, std::hash<std::string>, std::equal_to<std::string>,
+                                      CountingAllocator<std::pair<const std::string, int>>>;
+    std::cout << "Benchmark (ns/op; bytes/key):\n";
+    for (size_t n = 1000; n <= kMaxKeys; n *= 10) {
+        std::vector<std::string> keys;
+        std::vector<std::string> misses;
+        for (size_t i = 0; i < n; i++) {
+            keys.push_back("key" + std::to_string(i * 7919));
+            misses.push_back("miss" + std::to_string(i * 7919));
+        }
+
+        allocated_bytes = 0;
+        StdMap std_map;
+        double std_insert = NsPerOp(n, [&](size_t i) { std_map[keys[i]] = static_cast<int>(i); });
+        size_t std_bytes = allocated_bytes;
+        size_t hits = 0;
+        double std_hit = NsPerOp(n, [&](size_t i) { hits += std_map.count(keys[i]); });
+        double std_miss = NsPerOp(n, [&](size_t i) { hits += std_map.count(misses[i]); });
+
+        FlatHashMap<std::string, int> flat_map;
+        double flat_insert = NsPerOp(n, [&](size_t i) { flat_map[keys[i]] = static_cast<int>(i); });
+        double flat_hit = NsPerOp(n, [&](size_t i) { hits += flat_map.count(keys[i]); });
+        double flat_miss = NsPerOp(n, [&](size_t i) { hits += flat_map.count(misses[i]); });
+
+        std::cout << "  " << n << " keys:\n";
+        std::cout << "    std::unordered_map: insert " << std_insert << ", hit " << std_hit << ", miss " << std_miss
+                  << "; " << static_cast<double>(std_bytes) / n << "\n";
+        std::cout << "    FlatHashMap:        insert " << flat_insert << ", hit " << flat_hit << ", miss "
+                  << flat_miss << "; " << static_cast<double>(flat_map.MemoryUsage()) / n << "\n";
+        if (hits != 2 * n) {
+            std::cout << "    Unexpected hit count " << hits << "\n";
+        }
+    }
+}
+
+// Looks up keys that are too long for std::string's small-string buffer, via
+// const char * and std::string_view, and counts the heap allocations made.
+// Returns false if the transparent FlatHashMap allocated at all.
+// 通过const char *和std::string_view查找太长而放不进std::string小字符串缓冲区的
+// 键，并统计发生的堆分配次数。如果透明的FlatHashMap进行了任何分配，就返回false。
+bool RunHeterogeneousLookupDemo() {
+    constexpr size_t kNumKeys = 1000;
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < kNumKeys; i++) {
+        keys.push_back("a_rather_long_key_number_" + std::to_string(i));
+    }
+
+    std::unordered_map<std::string, int> std_map;
+    FlatHashMap<std::string, int, StringHash, StringEqual> flat_map;
+    for (size_t i = 0; i < kNumKeys; i++) {
+        std_map[keys[i]] = static_cast<int>(i);
+        flat_map[keys[i]] = static_cast<int>(i);
+    }
+
+    // Before C++20, std::unordered_map::find only takes const Key &, so every
+    // lookup by const char * first builds (and frees) a std::string.
+    // 在C++20之前，std::unordered_map::find只接受const Key &，所以每次用
+    // const char *查找都要先构造（再释放）一个std::string。
+    size_t found = 0;
+    size_t before = heap_allocations;
+    for (const std::string &key : keys) {
+        found += std_map.count(key.c_str());
+    }
+    size_t std_allocations = heap_allocations - before;
+
+    before = heap_allocations;
+    for (const std::string &key : keys) {
+        const char *c_str = key.c_str();
+        std::string_view view = key;
+        found += flat_map.count(c_str);
+        found += flat_map.find(view) != flat_map.end() ? 1 : 0;
+    }
+    found += flat_map.erase(std::string_view(keys[0]));
+    found += flat_map.erase(keys[1].c_str());
+    size_t flat_allocations = heap_allocations - before;
+
+    std::cout << "Heap allocations for " << kNumKeys << " lookups by const char *: std::unordered_map "
+              << std_allocations << ", transparent FlatHashMap " << flat_allocations << " (for " << 2 * kNumKeys
+              << " lookups and 2 erases)\n";
+    return found == 3 * kNumKeys + 2 && flat_allocations == 0;
+}
+
+// Compares a loop of find calls with FindBatch on a table that fits in the
+// L2 cache and on one that is bigger than most last level caches. Batching
+// only pays off when the lookups actually miss the cache.
+// 在一个能放进L2缓存的表和一个比大多数末级缓存都大的表上，比较调用find的循环与
+// FindBatch。只有当查找确实会缓存未命中时，批处理才有回报。
+void RunBatchBenchmark() {
+    constexpr size_t kNumLookups = 1 << 20;
+    std::cout << "Lookup throughput in Mops/s:\n";
+    for (size_t n: {size_t{1} << 14, size_t{1} << 22}) {
+        FlatHashMap<uint64_t, uint64_t> map;
+        std::mt19937_64 rng(n);
+        std::vector<uint64_t> keys(n);
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = rng();
+            map[keys[i]] = i;
+        }
+        std::vector<uint64_t> lookups(kNumLookups);
+        for (uint64_t &key: lookups) {
+            key = keys[rng() % n];
+        }
+
+        uint64_t sum = 0;
+        double find_ns = NsPerOp(kNumLookups, [&](size_t i) { sum += map.find(lookups[i])->second; });
+        // An operator would look up its keys one vector of a few hundred at a
+        // time, so out stays in the L1 cache.
+        // 算子每次会查找一个包含几百个键的向量，所以out会留在L1缓存中。
+        constexpr size_t kVectorSize = 256;
+        std::vector<FlatHashMap<uint64_t, uint64_t>::iterator> out(kVectorSize, map.end());
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < kNumLookups; i += kVectorSize) {
+            map.FindBatch(lookups.data() + i, kVectorSize, out.data());
+            for (const auto &it: out) {
+                sum -= it->second;
+            }
+        }
+        auto stop = std::chrono::steady_clock::now();
+        double batch_ns = std::chrono::duration<double, std::nano>(stop - start).count() / kNumLookups;
+
+        std::cout << "  " << n << " keys (" << map.MemoryUsage() / 1024 << " KB): find loop " << 1000 / find_ns
+                  << ", FindBatch " << 1000 / batch_ns << " (" << find_ns / batch_ns << "x)\n";
+        if (sum != 0) {
+            std::cout << "  FindBatch disagrees with find!\n";
+        }
+    }
+}
+
+int main() {
+    // FlatHashMap is used just like the std::unordered_map in
+    // unordered_maps.cpp.
+    // FlatHashMap的用法与unordered_maps.cpp中的std::unordered_map完全相同。
+    FlatHashMap<std::string, int> map;
+    map.insert({"foo", 2});
+    map.insert(std::make_pair("jignesh", 445));
+    map.insert({{"spam", 1}, {"eggs", 2}, {"garlic rice", 3}});
+    map["bacon"] = 5;
+    map["spam"] = 15;
+
+    FlatHashMap<std::string, int>::iterator result = map.find("jignesh");
+    if (result != map.end()) {
+        std::cout << "Found key " << result->first << " with value " << result->second << std::endl;
+        std::pair<std::string, int> pair = *result;
+        std::cout << "DEREF: Found key " << pair.first << " with value " << pair.second << std::endl;
+    }
+
+    size_t count = map.count("spam");
+    if (count == 1) {
+        std::cout << "A key-value pair with key spam exists in the unordered map.\n";
+    }
+
+    map.erase("eggs");
+    if (map.count("eggs") == 0) {
+        std::cout << "Key-value pair with key eggs does not exist in the unordered map.\n";
+    }
+
+    map.erase(map.find("garlic rice"));
+    if (map.count("garlic rice") == 0) {
+        std::cout << "Key-value pair with key garlic rice does not exist in the unordered map.\n";
+    }
+
+    // Iteration walks the slot array and skips the empty slots.
+    // 遍历会走过槽数组并跳过空槽。
+    std::cout << "Printing all elements of the " << map.size() << "-element map (" << map.bucket_count()
+              << " slots, load factor " << map.load_factor() << "):\n";
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        std::cout << "(" << it->first << ", " << it->second << "), ";
+    }
+    std::cout << "\n";
+
+    if (!RunHeterogeneousLookupDemo()) {
+        std::cout << "Heterogeneous lookups allocated memory!\n";
+        return 1;
+    }
+
+    RunBenchmark();
+    RunBatchBenchmark();
+
+    return 0;
+}
@@ -0,0 +1,681 @@
+/**
+ * @file flat_set.cpp
+ * @brief Tutorial code for a flat sorted set, an alternative to std::set.
+ * @brief 扁平有序集合的教程代码，它是std::set的一种替代方案。
+ */
+
+// In sets.cpp we introduced std::set, which is usually implemented as a
+// Red-Black tree. Every element lives in its own heap-allocated tree node that
+// also stores three pointers and a color bit, so a std::set<int> spends
+// roughly 40 bytes on every 4-byte int. Walking the tree also means chasing
+// pointers to nodes scattered all over the heap, which is bad for the cache.
+// 在sets.cpp中我们介绍了std::set，它通常实现为红黑树。每个元素都存放在
+// 自己的堆分配树节点中，节点还存储了三个指针和一个颜色位，所以
+// std::set<int>为每个4字节的int花费大约40字节。遍历树还意味着要追踪
+// 散落在堆中各处的节点指针，这对缓存很不友好。
+
+// For sets that are read much more often than they are written, a better
+// choice is a "flat" set: a std::vector that is kept sorted. Lookups are a
+// binary search over contiguous memory, iteration is a linear scan, and the
+// memory overhead is just the unused capacity of the vector. The price is that
+// a single insert or erase has to shift the elements after it, so we also
+// provide a batched insert that sorts a whole batch and merges it in at once.
+// 对于读远多于写的集合，更好的选择是"扁平"集合：一个保持有序的std::vector。
+// 查找是在连续内存上的二分查找，遍历是线性扫描，内存开销只是vector未使用的
+// 容量。代价是单次插入或删除需要移动其后的元素，所以我们还提供了批量插入，
+// 它将整批元素排序后一次性合并进来。
+
+// Includes std::sort, std::inplace_merge and std::unique.
+// 包含std::sort、std::inplace_merge和std::unique。
+#include <algorithm>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes std::size_t.
+// 包含std::size_t。
+#include <cstddef>
+// Includes fixed width integer types such as uint32_t.
+// 包含uint32_t等定宽整数类型。
+#include <cstdint>
+// Includes std::less.
+// 包含std::less。
+#include <functional>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes std::back_inserter.
+// 包含std::back_inserter。
+#include <iterator>
+// Includes std::allocator.
+// 包含std::allocator。
+#include <memory>
+// Includes the random number library, used to generate benchmark keys.
+// 包含随机数库，用于生成基准测试的键。
+#include <random>
+// Includes the set container library header, for comparison.
+// 包含集合容器库头文件，用于对比。
+#include <set>
+// Includes std::forward.
+// 包含std::forward。
+#include <utility>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+// Includes the SSE2 intrinsics used by the set algebra kernels. SSE2 is part
+// of every x86-64 CPU; on other CPUs the kernels fall back to scalar code.
+// 包含集合代数内核使用的SSE2内建函数。每个x86-64 CPU都支持SSE2；在其他CPU上
+// 这些内核会退回到标量代码。
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// FlatSet stores its elements in a sorted std::vector without duplicates.
+// Its interface mirrors the parts of std::set that sets.cpp demonstrates, so
+// it can be dropped in wherever those functions are used.
+// FlatSet将元素存储在一个有序且无重复的std::vector中。它的接口与sets.cpp
+// 中演示的std::set部分相对应，因此可以在使用这些函数的地方直接替换。
+template<typename T>
+class FlatSet {
+public:
+    // Iterators into a set may not modify the elements, since that could
+    // break the sorted order. So both iterator types are const iterators.
+    // 集合的迭代器不能修改元素，因为那样可能破坏有序性。
+    // 所以两种迭代器类型都是const迭代器。
+    using iterator = typename std::vector<T>::const_iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    FlatSet() = default;
+
+    // Adopts a vector that is already sorted and free of duplicates, for
+    // example the output of one of the set algebra kernels below.
+    // 接管一个已经有序且没有重复元素的vector，例如下面某个集合代数内核的输出。
+    static FlatSet FromSortedUnique(std::vector<T> sorted) {
+        FlatSet set;
+        set.data_ = std::move(sorted);
+        return set;
+    }
+
+    iterator begin() const { return data_.cbegin(); }
+    iterator end() const { return data_.cend(); }
+    size_t size() const { return data_.size(); }
+    bool empty() const { return data_.empty(); }
+    void reserve(size_t n) { data_.reserve(n); }
+
+    // Returns the raw sorted array. This is useful for algorithms that want
+    // to work on plain contiguous memory.
+    // 返回原始的有序数组。这对于想在普通连续内存上工作的算法很有用。
+    const T *data() const { return data_.data(); }
+
+    // Returns the number of heap bytes owned by the set.
+    // 返回集合拥有的堆内存字节数。
+    size_t MemoryUsage() const { return data_.capacity() * sizeof(T); }
+
+    // Inserts a single key. Like std::set::insert, it returns an iterator to
+    // the element and whether the insertion took place.
+    // 插入单个键。与std::set::insert一样，它返回指向该元素的迭代器以及是否
+    // 发生了插入。
+    std::pair<iterator, bool> insert(const T &key) {
+        size_t pos = LowerBound(key);
+        if (pos < data_.size() && !(key < data_[pos])) {
+            return {data_.cbegin() + pos, false};
+        }
+        data_.insert(data_.begin() + pos, key);
+        return {data_.cbegin() + pos, true};
+    }
+
+    // Batched insert. Instead of paying the shifting cost once per element,
+    // we append the whole batch, sort only the new part, merge the two sorted
+    // runs and finally drop duplicates. This costs O(n + k log k) for k new
+    // elements instead of O(n * k).
+    // 批量插入。我们不为每个元素都付出一次移动的代价，而是先追加整个批次，
+    // 只对新的部分排序，合并两个有序段，最后去掉重复元素。对于k个新元素，
+    // 代价是O(n + k log k)而不是O(n * k)。
+    template<typename InputIt>
+    void insert(InputIt first, InputIt last) {
+        size_t old_size = data_.size();
+        data_.insert(data_.end(), first, last);
+        auto mid = data_.begin() + old_size;
+        std::sort(mid, data_.end());
+        std::inplace_merge(data_.begin(), mid, data_.end());
+        data_.erase(std::unique(data_.begin(), data_.end()), data_.end());
+    }
+
+    // emplace constructs the key first, since we have to compare it against
+    // the existing keys before we know where it belongs.
+    // emplace先构造出键，因为我们需要先和已有的键比较才知道它该放在哪里。
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args &&...args) {
+        return insert(T(std::forward<Args>(args)...));
+    }
+
+    iterator find(const T &key) const {
+        size_t pos = LowerBound(key);
+        if (pos < data_.size() && !(key < data_[pos])) {
+            return data_.cbegin() + pos;
+        }
+        return data_.cend();
+    }
+
+    size_t count(const T &key) const { return find(key) != end() ? 1 : 0; }
+
+    iterator lower_bound(const T &key) const { return data_.cbegin() + LowerBound(key); }
+
+    // The three erase overloads of std::set: by key, by position and by range.
+    // std::set的三个erase重载：按键、按位置和按范围。
+    size_t erase(const T &key) {
+        iterator it = find(key);
+        if (it == end()) {
+            return 0;
+        }
+        erase(it);
+        return 1;
+    }
+
+    iterator erase(iterator pos) { return data_.erase(pos); }
+
+    iterator erase(iterator first, iterator last) { return data_.erase(first, last); }
+
+private:
+    // A branchless binary search. A normal binary search has an unpredictable
+    // "go left or go right" branch at every step, and a mispredicted branch
+    // costs more than the comparison itself. Here the only data dependent
+    // choice is a conditional move, and the loop always runs log2(n) times.
+    // 无分支的二分查找。普通的二分查找在每一步都有一个不可预测的"向左还是
+    // 向右"分支，而一次分支预测失败的代价比比较本身还要高。这里唯一依赖于
+    // 数据的选择是一个条件移动，并且循环总是执行log2(n)次。
+    size_t LowerBound(const T &key) const {
+        size_t n = data_.size();
+        if (n == 0) {
+            return 0;
+        }
+        const T *base = data_.data();
+        while (n > 1) {
+            size_t half = n / 2;
+            base = (base[half] < key) ? base + half : base;
+            n -= half;
+        }
+        return (base - data_.data()) + (*base < key);
+    }
+
+    std::vector<T> data_;
+};
+
+// Sorted set algebra kernels. Intersecting, uniting and subtracting sorted
+// sets (think posting lists in a search engine) is a classic database
+// operation. std::set_intersection over std::set iterators compares one pair
+// of elements per step and chases a tree pointer for every element. Over flat
+// sorted uint32_t arrays we can do much better in two ways:
+// 有序集合的代数运算内核。对有序集合求交、并、差（比如搜索引擎中的倒排列表）
+// 是经典的数据库操作。在std::set迭代器上调用std::set_intersection每一步只比较
+// 一对元素，并且每个元素都要追踪一次树指针。在扁平的有序uint32_t数组上，我们
+// 可以从两个方面做得好得多：
+//   1. SIMD: compare a block of 4 elements of a against a block of 4
+//      elements of b at once, with 4 vector compares instead of 16 scalar
+//      ones.
+//   1. SIMD：一次用4个向量比较（而不是16个标量比较）把a中的4个元素组成的块与
+//      b中的4个元素组成的块进行比较。
+//   2. Galloping: when one input is much smaller than the other, walking the
+//      big one element by element wastes time. Instead, for each element of
+//      the small input we jump ahead in the big one with an exponential search
+//      (1, 2, 4, 8, ... steps) followed by a binary search.
+//   2. 跳跃搜索（galloping）：当一个输入比另一个小得多时，逐个元素地遍历大的
+//      那个是在浪费时间。取而代之的是，对小输入中的每个元素，我们在大输入中用
+//      指数搜索（步长1、2、4、8……）向前跳，再接一个二分查找。
+// The kernels work on SortedSpan, a plain pointer and length, so they can be
+// used on any sorted array. The overloads further below apply them to
+// FlatSet<uint32_t>.
+// 这些内核作用于SortedSpan（一个普通的指针加长度），所以它们可以用于任何有序
+// 数组。更下面的重载把它们应用于FlatSet<uint32_t>。
+
+// A read-only view of a sorted array without duplicates.
+// 一个无重复有序数组的只读视图。
+struct SortedSpan {
+    const uint32_t *data;
+    size_t size;
+};
+
+// If one input is this many times larger than the other, galloping beats a
+// linear merge.
+// 如果一个输入比另一个大这么多倍，跳跃搜索就会胜过线性归并。
+constexpr size_t kGallopRatio = 32;
+
+// Returns the first index i >= lo such that data[i] >= key, or size.
+// 返回第一个满足i >= lo且data[i] >= key的下标i，或者size。
+size_t GallopLowerBound(SortedSpan span, size_t lo, uint32_t key) {
+    size_t step = 1;
+    size_t hi = lo;
+    while (hi < span.size && span.data[hi] < key) {
+        lo = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+    hi = std::min(hi, span.size);
+    return std::lower_bound(span.data + lo, span.data + hi, key) - span.data;
+}
+
+#if defined(__SSE2__)
+// Compares every element of va with every element of vb, by comparing va
+// with vb rotated by 0, 1, 2 and 3 lanes. Returns a 4-bit mask with bit k set
+// if va[k] appears anywhere in vb.
+// 通过把va与循环移动0、1、2、3个通道的vb进行比较，来比较va的每个元素和vb的每
+// 个元素。返回一个4位掩码，如果va[k]出现在vb中的某处，则第k位被设置。
+inline int MatchMask(__m128i va, __m128i vb) {
+    __m128i eq = _mm_cmpeq_epi32(va, vb);
+    eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+    eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+    eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+    return _mm_movemask_ps(_mm_castsi128_ps(eq));
+}
+#endif
+
+// Writes a ∩ b to out.
+// 把a ∩ b写入out。
+void IntersectSorted(SortedSpan a, SortedSpan b, std::vector<uint32_t> &out) {
+    out.clear();
+    if (a.size > b.size) {
+        std::swap(a, b);
+    }
+    if (a.size * kGallopRatio < b.size) {
+        size_t j = 0;
+        for (size_t i = 0; i < a.size && j < b.size; i++) {
+            j = GallopLowerBound(b, j, a.data[i]);
+            if (j < b.size && b.data[j] == a.data[i]) {
+                out.push_back(a.data[i]);
+            }
+        }
+        return;
+    }
+    size_t i = 0;
+    size_t j = 0;
+#if defined(__SSE2__)
+    // Both blocks are compared all-against-all. Then the block whose largest
+    // element is smaller moves on, since none of its elements can match
+    // anything later in the other input.
+    // 两个块进行全对全比较。然后最大元素较小的那个块向前移动，因为它的元素都
+    // 不可能与另一个输入中后面的任何元素相匹配。
+    while (i + 4 <= a.size && j + 4 <= b.size) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a.data + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b.data + j));
+        int mask = MatchMask(va, vb);
+        while (mask != 0) {
+            out.push_back(a.data[i + __builtin_ctz(mask)]);
+            mask &= mask - 1;
+        }
+        uint32_t a_max = a.data[i + 3];
+        uint32_t b_max = b.data[j + 3];
+        i += (a_max <= b_max) ? 4 : 0;
+        j += (b_max <= a_max) ? 4 : 0;
+    }
+#endif
+    while (i < a.size && j < b.size) {
+        if (a.data[i] < b.data[j]) {
+            i++;
+        } else if (b.data[j] < a.data[i]) {
+            j++;
+        } else {
+            out.push_back(a.data[i]);
+            i++;
+            j++;
+        }
+    }
+}
+
+// Writes a \ b (elements of a that are not in b) to out.
+// 把a \ b（在a中但不在b中的元素）写入out。
+void DifferenceSorted(SortedSpan a, SortedSpan b, std::vector<uint32_t> &out) {
+    out.clear();
+    if (a.size * kGallopRatio < b.size) {
+        size_t j = 0;
+        for (size_t i = 0; i < a.size; i++) {
+            j = GallopLowerBound(b, j, a.data[i]);
+            if (j == b.size || b.data[j] != a.data[i]) {
+                out.push_back(a.data[i]);
+            }
+        }
+        return;
+    }
+    if (b.size * kGallopRatio < a.size) {
+        // Copy the runs of a between consecutive elements of b.
+        // 复制a中位于b的相邻元素之间的各段。
+        size_t i = 0;
+        for (size_t j = 0; j < b.size && i < a.size; j++) {
+            size_t k = GallopLowerBound(a, i, b.data[j]);
+            out.insert(out.end(), a.data + i, a.data + k);
+            i = (k < a.size && a.data[k] == b.data[j]) ? k + 1 : k;
+        }
+        out.insert(out.end(), a.data + i, a.data + a.size);
+        return;
+    }
+    size_t i = 0;
+    size_t j = 0;
+    // Bits of the current block of a that matched some element of b.
+    // a的当前块中与b的某个元素相匹配的位。
+    int matched = 0;
+#if defined(__SSE2__)
+    while (i + 4 <= a.size && j + 4 <= b.size) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a.data + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b.data + j));
+        matched |= MatchMask(va, vb);
+        uint32_t a_max = a.data[i + 3];
+        uint32_t b_max = b.data[j + 3];
+        if (a_max <= b_max) {
+            // The block of a is done, emit the elements that never matched.
+            // a的这个块处理完了，输出从未匹配过的元素。
+            int unmatched = ~matched & 0xF;
+            while (unmatched != 0) {
+                out.push_back(a.data[i + __builtin_ctz(unmatched)]);
+                unmatched &= unmatched - 1;
+            }
+            matched = 0;
+            i += 4;
+        }
+        j += (b_max <= a_max) ? 4 : 0;
+    }
+#endif
+    while (i < a.size) {
+        // Elements of a partially processed block may already have matched an
+        // element of b that we have moved past.
+        // 部分处理过的块中的元素可能已经与我们越过的b中的某个元素匹配过了。
+        if (matched & 1) {
+            matched >>= 1;
+            i++;
+            continue;
+        }
+        matched >>= 1;
+        while (j < b.size && b.data[j] < a.data[i]) {
+            j++;
+        }
+        if (j == b.size || b.data[j] != a.data[i]) {
+            out.push_back(a.data[i]);
+        }
+        i++;
+    }
+}
+
+// Writes a ∪ b to out. SSE2 has no cheap way to merge two vectors, so the
+// balanced case is a scalar merge written without unpredictable branches:
+// both cursors advance by the result of a comparison instead of an if/else.
+// 把a ∪ b写入out。SSE2没有合并两个向量的廉价方法，所以平衡的情况是一个没有
+// 不可预测分支的标量归并：两个游标按比较的结果前进，而不是通过if/else。
+void UnionSorted(SortedSpan a, SortedSpan b, std::vector<uint32_t> &out) {
+    out.clear();
+    if (a.size > b.size) {
+        std::swap(a, b);
+    }
+    if (a.size * kGallopRatio < b.size) {
+        size_t i = 0;
+        for (size_t j = 0; j < a.size; j++) {
+            size_t k = GallopLowerBound(b, i, a.data[j]);
+            out.insert(out.end(), b.data + i, b.data + k);
+            out.push_back(a.data[j]);
+            i = (k < b.size && b.data[k] == a.data[j]) ? k + 1 : k;
+        }
+        out.insert(out.end(), b.data + i, b.data + b.size);
+        return;
+    }
+    out.resize(a.size + b.size);
+    size_t i = 0;
+    size_t j = 0;
+    size_t n = 0;
+    while (i < a.size && j < b.size) {
+        uint32_t x = a.data[i];
+        uint32_t y = b.data[j];
+        out[n++] = x < y ? x : y;
+        i += (x <= y);
+        j += (y <= x);
+    }
+    std::copy(a.data + i, a.data + a.size, out.begin() + n);
+    n += a.size - i;
+    std::copy(b.data + j, b.data + b.size, out.begin() + n);
+    n += b.size - j;
+    out.resize(n);
+}
+
+// The same kernels for FlatSet<uint32_t>.
+// 用于FlatSet<uint32_t>的相同内核。
+SortedSpan AsSpan(const FlatSet<uint32_t> &set) { return {set.data(), set.size()}; }
+
+FlatSet<uint32_t> Intersect(const FlatSet<uint32_t> &a, const FlatSet<uint32_t> &b) {
+    std::vector<uint32_t> out;
+    IntersectSorted(AsSpan(a), AsSpan(b), out);
+    return FlatSet<uint32_t>::FromSortedUnique(std::move(out));
+}
+
+FlatSet<uint32_t> Union(const FlatSet<uint32_t> &a, const FlatSet<uint32_t> &b) {
+    std::vector<uint32_t> out;
+    UnionSorted(AsSpan(a), AsSpan(b), out);
+    return FlatSet<uint32_t>::FromSortedUnique(std::move(out));
+}
+
+FlatSet<uint32_t> Difference(const FlatSet<uint32_t> &a, const FlatSet<uint32_t> &b) {
+    std::vector<uint32_t> out;
+    DifferenceSorted(AsSpan(a), AsSpan(b), out);
+    return FlatSet<uint32_t>::FromSortedUnique(std::move(out));
+}
+
+// CountingAllocator forwards to std::allocator, but adds every allocation to
+// a global byte counter. We plug it into std::set to see exactly how much
+// memory its tree nodes take.
+// CountingAllocator转发给std::allocator，但会把每次分配的字节数累加到一个
+// 全局计数器中。我们把它用于std::set，以准确地看到树节点占用了多少内存。
+size_t allocated_bytes = 0;
+
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        allocated_bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T *p, size_t n) {
+        allocated_bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const CountingAllocator<U> &) const { return true; }
+    template<typename U>
+    bool operator!=(const CountingAllocator<U> &) const { return false; }
+};
+
+// Runs func once and returns how long it took, in milliseconds.
+// 运行func一次并返回它所花的时间，单位为毫秒。
+template<typename Func>
+double TimeMs(Func func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// Compares memory and lookup speed of FlatSet<int> against std::set<int>.
+// 比较FlatSet<int>与std::set<int>的内存占用和查找速度。
+void RunBenchmark() {
+    const int num_keys = 1 << 18;
+    const int num_probes = 1 << 18;
+    std::mt19937 rng(445);
+    std::vector<int> keys(num_keys);
+    for (int &key: keys) {
+        key = static_cast<int>(rng());
+    }
+    std::vector<int> probes(num_probes);
+    for (int i = 0; i < num_probes; ++i) {
+        // Half of the probes hit, and half of them (most likely) miss.
+        // 一半的探测命中，另一半（很可能）未命中。
+        probes[i] = (i % 2 == 0) ? keys[rng() % num_keys] : static_cast<int>(rng());
+    }
+
+    std::set<int, std::less<int>, CountingAllocator<int>> tree_set;
+    double tree_build = TimeMs([&] {
+        for (int key: keys) {
+            tree_set.insert(key);
+        }
+    });
+
+    FlatSet<int> flat_set;
+    double flat_build = TimeMs([&] { flat_set.insert(keys.begin(), keys.end()); });
+
+    size_t tree_hits = 0;
+    double tree_lookup = TimeMs([&] {
+        for (int probe: probes) {
+            tree_hits += tree_set.count(probe);
+        }
+    });
+    size_t flat_hits = 0;
+    double flat_lookup = TimeMs([&] {
+        for (int probe: probes) {
+            flat_hits += flat_set.count(probe);
+        }
+    });
+
+    std::cout << "Benchmark with " << tree_set.size() << " keys and " << num_probes << " lookups:\n";
+    std::cout << "  std::set: build " << tree_build << " ms, lookup " << tree_lookup << " ms, "
+              << static_cast<double>(allocated_bytes) / tree_set.size() << " bytes/key, " << tree_hits << " hits\n";
+    std::cout << "  FlatSet:  build " << flat_build << " ms, lookup " << flat_lookup << " ms, "
+              << static_cast<double>(flat_set.MemoryUsage()) / flat_set.size() << " bytes/key, " << flat_hits
+              << " hits\n";
+}
+
+// Compares the set algebra kernels against std::set_intersection, both over
+// std::set iterators and over plain vectors, on balanced and skewed inputs.
+// 在平衡和倾斜的输入上，把集合代数内核与std::set_intersection（分别作用于
+// std::set迭代器和普通vector）进行比较。
+void RunKernelBenchmark() {
+    std::mt19937 rng(645);
+    auto make_sorted = [&rng](size_t n, uint32_t universe) {
+        std::vector<uint32_t> values(n);
+        for (uint32_t &value: values) {
+            value = rng() % universe;
+        }
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+        return values;
+    };
+    std::vector<uint32_t> big = make_sorted(1 << 18, 1 << 20);
+    std::vector<uint32_t> medium = make_sorted(1 << 18, 1 << 20);
+    std::vector<uint32_t> tiny = make_sorted(1 << 8, 1 << 20);
+    std::set<uint32_t> big_tree(big.begin(), big.end());
+    std::set<uint32_t> medium_tree(medium.begin(), medium.end());
+
+    std::vector<uint32_t> out;
+    double tree_ms = TimeMs([&] {
+        std::set_intersection(big_tree.begin(), big_tree.end(), medium_tree.begin(), medium_tree.end(),
+                              std::back_inserter(out));
+    });
+    size_t expected = out.size();
+    out.clear();
+    double vector_ms = TimeMs([&] {
+        std::set_intersection(big.begin(), big.end(), medium.begin(), medium.end(), std::back_inserter(out));
+    });
+    double kernel_ms = TimeMs([&] { IntersectSorted({big.data(), big.size()}, {medium.data(), medium.size()}, out); });
+    std::cout << "Intersecting " << big.size() << " and " << medium.size() << " sorted keys (" << expected
+              << " results):\n";
+    std::cout << "  std::set_intersection on std::set: " << tree_ms << " ms\n";
+    std::cout << "  std::set_intersection on vectors:  " << vector_ms << " ms\n";
+    std::cout << "  IntersectSorted:                   " << kernel_ms << " ms, " << out.size() << " results\n";
+
+    out.clear();
+    double skew_merge_ms = TimeMs([&] {
+        std::set_intersection(big.begin(), big.end(), tiny.begin(), tiny.end(), std::back_inserter(out));
+    });
+    expected = out.size();
+    double skew_gallop_ms = TimeMs([&] { IntersectSorted({big.data(), big.size()}, {tiny.data(), tiny.size()}, out); });
+    std::cout << "Intersecting " << big.size() << " and " << tiny.size() << " sorted keys (" << expected
+              << " results):\n";
+    std::cout << "  std::set_intersection on vectors:  " << skew_merge_ms << " ms\n";
+    std::cout << "  IntersectSorted (galloping):       " << skew_gallop_ms << " ms, " << out.size()
+              << " results\n";
+
+    double union_ms = TimeMs([&] { UnionSorted({big.data(), big.size()}, {medium.data(), medium.size()}, out); });
+    size_t union_size = out.size();
+    double difference_ms =
+            TimeMs([&] { DifferenceSorted({big.data(), big.size()}, {medium.data(), medium.size()}, out); });
+    std::cout << "  UnionSorted: " << union_ms << " ms, " << union_size << " results; DifferenceSorted: "
+              << difference_ms << " ms, " << out.size() << " results\n";
+}
+
+int main() {
+    // The FlatSet supports the same operations that sets.cpp shows for
+    // std::set. We go through them in the same order.
+    // FlatSet支持sets.cpp中为std::set展示的相同操作。我们按相同的顺序来演示。
+    FlatSet<int> int_set;
+    for (int i = 1; i <= 5; ++i) {
+        int_set.insert(i);
+    }
+    for (int i = 6; i <= 10; ++i) {
+        int_set.emplace(i);
+    }
+
+    // Batched insert sorts the batch and merges it into the existing array.
+    // Duplicates, both inside the batch and with existing keys, are dropped.
+    // 批量插入会排序这个批次并将其合并到已有的数组中。批次内部以及与已有键
+    // 之间的重复元素都会被丢弃。
+    std::vector<int> batch = {15, 12, 3, 12, 11};
+    int_set.insert(batch.begin(), batch.end());
+    std::cout << "Size after batched insert: " << int_set.size() << "\n";
+
+    FlatSet<int>::iterator search = int_set.find(2);
+    if (search != int_set.end()) {
+        std::cout << "Element 2 is in int_set.\n";
+    }
+
+    if (int_set.count(13) == 0) {
+        std::cout << "Element 13 is not in the set.\n";
+    }
+
+    int_set.erase(4);
+    if (int_set.count(4) == 0) {
+        std::cout << "Element 4 is not in the set.\n";
+    }
+
+    int_set.erase(int_set.begin());
+    if (int_set.count(1) == 0) {
+        std::cout << "Element 1 is not in the set.\n";
+    }
+
+    // Range erase removes 9 and every element after it.
+    // 范围删除会删除9以及它之后的所有元素。
+    int_set.erase(int_set.find(9), int_set.end());
+    if (int_set.count(9) == 0 && int_set.count(15) == 0) {
+        std::cout << "Elements 9 through 15 are not in the set.\n";
+    }
+
+    std::cout << "Printing the elements of the flat set:\n";
+    for (const int &elem: int_set) {
+        std::cout << elem << " ";
+    }
+    std::cout << "\n";
+
+    // The set algebra kernels work on FlatSet<uint32_t> as well as on plain
+    // sorted arrays.
+    // 集合代数内核既可以作用于FlatSet<uint32_t>，也可以作用于普通的有序数组。
+    FlatSet<uint32_t> evens;
+    FlatSet<uint32_t> threes;
+    for (uint32_t i = 0; i <= 30; i++) {
+        if (i % 2 == 0) {
+            evens.insert(i);
+        }
+        if (i % 3 == 0) {
+            threes.insert(i);
+        }
+    }
+    std::cout << "Multiples of 6 up to 30:";
+    for (uint32_t elem: Intersect(evens, threes)) {
+        std::cout << " " << elem;
+    }
+    std::cout << "\nEven numbers that are not multiples of 3:";
+    for (uint32_t elem: Difference(evens, threes)) {
+        std::cout << " " << elem;
+    }
+    std::cout << "\nNumbers that are multiples of 2 or 3: " << Union(evens, threes).size() << "\n";
+
+    RunBenchmark();
+    RunKernelBenchmark();
+
+    return 0;
+}
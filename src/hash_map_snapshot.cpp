@@ -0,0 +1,451 @@
+/**
+ * @file hash_map_snapshot.cpp
+ * @brief Tutorial code for a hash map snapshot that is queried in place with
+ * mmap.
+ * @brief 用mmap就地查询的哈希映射快照的教程代码。
+ */
+
+// Loading a big std::unordered_map<std::string, int> (unordered_maps.cpp) at
+// startup means parsing the source and inserting every pair again: one node
+// and often one string allocation per key, and every key hashed again. With
+// millions of keys that takes seconds, every time the process starts.
+// 在启动时加载一个大的std::unordered_map<std::string, int>（unordered_maps.cpp）
+// 意味着解析数据源并再次插入每个键值对：每个键一个节点，通常还有一次字符串分配，
+// 并且每个键都要重新求哈希。当有几百万个键时，每次进程启动都要花几秒钟。
+
+// A snapshot instead stores the finished hash table itself in a file. The file
+// has no pointers, only offsets from its start, so it means the same thing at
+// whatever address it is mapped ("position independent"). Opening it is one
+// mmap call, and the operating system reads in pages lazily as lookups touch
+// them. Many processes that map the same file share one copy in the page
+// cache. This is the same idea as RoaringView in roaring_bitmap.cpp, applied
+// to a string-to-int map.
+// 快照则把构建好的哈希表本身存储在一个文件中。文件里没有指针，只有相对于文件开头
+// 的偏移量，所以不管它被映射到什么地址，含义都相同（"位置无关"）。打开它只需要一次
+// mmap调用，操作系统会在查找访问到页时才惰性地读入它们。映射同一个文件的多个进程
+// 在页缓存中共享同一份拷贝。这与roaring_bitmap.cpp中的RoaringView是同一个思路，
+// 只是应用到了字符串到整数的映射上。
+
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as uint32_t.
+// 包含uint32_t等定宽整数类型。
+#include <cstdint>
+// Includes std::memcmp.
+// 包含std::memcmp。
+#include <cstring>
+// Includes std::ofstream, used to write the snapshot to a file.
+// 包含std::ofstream，用于把快照写入文件。
+#include <fstream>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes std::length_error.
+// 包含std::length_error。
+#include <stdexcept>
+// Includes the C++ string library.
+// 包含C++字符串库。
+#include <string>
+// Includes std::string_view.
+// 包含std::string_view。
+#include <string_view>
+// Includes the unordered_map container library header, for comparison.
+// 包含unordered_map容器库头文件，用于对比。
+#include <unordered_map>
+// Includes std::pair.
+// 包含std::pair。
+#include <utility>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+// Includes the POSIX mmap API, used to query a snapshot in place.
+// 包含POSIX mmap API，用于就地查询快照。
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The snapshot format is little endian no matter what machine writes it:
+//   "HMS1"                        4-byte magic
+//   uint32 reserved               always 0
+//   uint64 num_entries
+//   uint64 num_slots              a power of two, at least 2 * num_entries
+//   uint64 strings_offset         where the key bytes start
+//   num_slots x {uint32 tag, uint32 key_length, uint32 key_offset, int32 value}
+//   key bytes                     all keys back to back
+// The slots form an open-addressing table with linear probing. An empty slot
+// has key_length 0xffffffff. tag holds the top 32 bits of the key's hash, so
+// a lookup only reads key bytes for slots whose tag matches. key_offset is
+// relative to strings_offset.
+// 快照格式不管是什么机器写的都是小端序的：
+//   "HMS1"                        4字节魔数
+//   uint32 reserved               总是0
+//   uint64 num_entries
+//   uint64 num_slots              2的幂，至少为2 * num_entries
+//   uint64 strings_offset         键字节开始的位置
+//   num_slots x {uint32 tag, uint32 key_length, uint32 key_offset, int32 value}
+//   键字节                         所有键首尾相接
+// 这些槽构成一个使用线性探测的开放寻址表。空槽的key_length为0xffffffff。tag保存键
+// 的哈希值的高32位，所以查找只会为tag匹配的槽读取键字节。key_offset是相对于
+// strings_offset的。
+constexpr size_t kHeaderSize = 32;
+constexpr size_t kSlotSize = 16;
+constexpr uint32_t kEmptySlot = 0xffffffff;
+
+// The hash is part of the file format, so it must give the same value in
+// every process and on every platform. std::hash makes no such promise, so we
+// use 64-bit FNV-1a followed by a MurmurHash3 finalizer.
+// 哈希是文件格式的一部分，所以它必须在每个进程、每个平台上给出相同的值。std::hash
+// 并不保证这一点，所以我们使用64位FNV-1a，再加上MurmurHash3的最终混合函数。
+uint64_t SnapshotHash(std::string_view key) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (char c: key) {
+        h = (h ^ static_cast<uint8_t>(c)) * 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// HashMapSnapshotWriter collects pairs and lays them out in the snapshot
+// format. Adding a key twice keeps the last value, like operator[].
+// HashMapSnapshotWriter收集键值对并按快照格式排列它们。添加同一个键两次会保留最后
+// 的值，就像operator[]一样。
+class HashMapSnapshotWriter {
+public:
+    void Add(std::string_view key, int32_t value) { pairs_.emplace_back(std::string(key), value); }
+
+    // Throws std::length_error if the keys take 4 GB or more, since key
+    // offsets are 32 bits.
+    // 如果键占用4 GB或更多则抛出std::length_error，因为键的偏移量是32位的。
+    std::vector<uint8_t> Serialize() const {
+        size_t num_slots = 16;
+        while (num_slots < 2 * pairs_.size()) {
+            num_slots *= 2;
+        }
+
+        // Build the table in memory first, as (pair index + 1) per slot.
+        // 先在内存中构建表，每个槽保存(键值对下标 + 1)。
+        std::vector<uint32_t> table(num_slots, 0);
+        size_t num_entries = 0;
+        for (size_t i = 0; i < pairs_.size(); i++) {
+            size_t slot = SnapshotHash(pairs_[i].first) & (num_slots - 1);
+            while (table[slot] != 0 && pairs_[table[slot] - 1].first != pairs_[i].first) {
+                slot = (slot + 1) & (num_slots - 1);
+            }
+            num_entries += table[slot] == 0 ? 1 : 0;
+            table[slot] = static_cast<uint32_t>(i + 1);
+        }
+
+        size_t strings_offset = kHeaderSize + num_slots * kSlotSize;
+        std::vector<uint8_t> out = {'H', 'M', 'S', '1'};
+        PutLE(out, 0, 4);
+        PutLE(out, num_entries, 8);
+        PutLE(out, num_slots, 8);
+        PutLE(out, strings_offset, 8);
+        std::vector<uint8_t> strings;
+        for (uint32_t entry: table) {
+            if (entry == 0) {
+                PutLE(out, 0, 4);
+                PutLE(out, kEmptySlot, 4);
+                PutLE(out, 0, 4);
+                PutLE(out, 0, 4);
+                continue;
+            }
+            const auto &[key, value] = pairs_[entry - 1];
+            if (strings.size() + key.size() >= kEmptySlot) {
+                throw std::length_error("Snapshot keys must take less than 4 GB");
+            }
+            PutLE(out, SnapshotHash(key) >> 32, 4);
+            PutLE(out, key.size(), 4);
+            PutLE(out, strings.size(), 4);
+            PutLE(out, static_cast<uint32_t>(value), 4);
+            strings.insert(strings.end(), key.begin(), key.end());
+        }
+        out.insert(out.end(), strings.begin(), strings.end());
+        return out;
+    }
+
+private:
+    static void PutLE(std::vector<uint8_t> &out, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    std::vector<std::pair<std::string, int32_t>> pairs_;
+};
+
+// HashMapSnapshotView answers find, count and iteration directly on the bytes
+// of a snapshot, for example a file mapped with mmap. Keys come back as
+// std::string_views into those bytes, so nothing is copied. The view checks
+// the header and every key's bounds, so a truncated or corrupt file makes
+// lookups fail instead of reading out of bounds.
+// HashMapSnapshotView直接在快照的字节上回答find、count和遍历，例如一个用mmap映射
+// 的文件。键以指向这些字节的std::string_view的形式返回，所以不会复制任何内容。视图
+// 会检查头部和每个键的边界，所以一个被截断或损坏的文件会使查找失败，而不是越界
+// 读取。
+class HashMapSnapshotView {
+public:
+    using value_type = std::pair<std::string_view, int32_t>;
+
+    class const_iterator {
+    public:
+        const_iterator(const HashMapSnapshotView *view, size_t slot) : view_(view), slot_(slot) { SkipEmpty(); }
+
+        value_type operator*() const { return {view_->KeyAt(slot_), view_->ValueAt(slot_)}; }
+
+        // The pair is built on the fly, so operator-> returns it wrapped in a
+        // small proxy object that owns it.
+        // 键值对是即时构造的，所以operator->返回一个拥有它的小代理对象。
+        struct Proxy {
+            value_type pair;
+            const value_type *operator->() const { return &pair; }
+        };
+        Proxy operator->() const { return Proxy{**this}; }
+
+        const_iterator &operator++() {
+            slot_++;
+            SkipEmpty();
+            return *this;
+        }
+
+        bool operator==(const const_iterator &other) const { return slot_ == other.slot_; }
+        bool operator!=(const const_iterator &other) const { return slot_ != other.slot_; }
+
+    private:
+        void SkipEmpty() {
+            while (slot_ < view_->num_slots_ && view_->IsEmpty(slot_)) {
+                slot_++;
+            }
+        }
+
+        const HashMapSnapshotView *view_;
+        size_t slot_;
+    };
+
+    HashMapSnapshotView(const uint8_t *data, size_t size) : data_(data), size_(size) {
+        valid_ = size >= kHeaderSize && std::memcmp(data, "HMS1", 4) == 0;
+        if (valid_) {
+            num_entries_ = GetLE(8, 8);
+            num_slots_ = GetLE(16, 8);
+            strings_offset_ = GetLE(24, 8);
+            valid_ = num_slots_ != 0 && (num_slots_ & (num_slots_ - 1)) == 0 && num_slots_ <= size / kSlotSize &&
+                     strings_offset_ == kHeaderSize + num_slots_ * kSlotSize && strings_offset_ <= size &&
+                     num_entries_ < num_slots_;
+        }
+        if (!valid_) {
+            num_entries_ = 0;
+            num_slots_ = 0;
+        }
+    }
+
+    bool IsValid() const { return valid_; }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, num_slots_); }
+
+    size_t size() const { return num_entries_; }
+    bool empty() const { return num_entries_ == 0; }
+
+    const_iterator find(std::string_view key) const {
+        if (num_slots_ == 0) {
+            return end();
+        }
+        uint64_t hash = SnapshotHash(key);
+        uint32_t tag = static_cast<uint32_t>(hash >> 32);
+        // A valid snapshot always has an empty slot, but a corrupt one might
+        // not, so we stop after visiting every slot once.
+        // 一个有效的快照总会有空槽，但损坏的快照可能没有，所以我们在每个槽都访问过
+        // 一次之后停止。
+        size_t slot = hash & (num_slots_ - 1);
+        for (size_t probes = 0; probes < num_slots_ && !IsEmpty(slot); probes++) {
+            if (GetLE(SlotOffset(slot), 4) == tag && KeyAt(slot) == key) {
+                return const_iterator(this, slot);
+            }
+            slot = (slot + 1) & (num_slots_ - 1);
+        }
+        return end();
+    }
+
+    size_t count(std::string_view key) const { return find(key) == end() ? 0 : 1; }
+
+private:
+    size_t SlotOffset(size_t slot) const { return kHeaderSize + slot * kSlotSize; }
+
+    bool IsEmpty(size_t slot) const { return GetLE(SlotOffset(slot) + 4, 4) == kEmptySlot; }
+
+    // Returns an empty key if the slot points outside the file.
+    // 如果槽指向文件之外，则返回一个空键。
+    std::string_view KeyAt(size_t slot) const {
+        size_t length = GetLE(SlotOffset(slot) + 4, 4);
+        size_t offset = strings_offset_ + GetLE(SlotOffset(slot) + 8, 4);
+        if (offset > size_ || length > size_ - offset) {
+            return {};
+        }
+        return std::string_view(reinterpret_cast<const char *>(data_ + offset), length);
+    }
+
+    int32_t ValueAt(size_t slot) const { return static_cast<int32_t>(GetLE(SlotOffset(slot) + 12, 4)); }
+
+    // Reads a little endian integer byte by byte, like RoaringView::GetLE.
+    // 逐字节读取一个小端序整数，就像RoaringView::GetLE一样。
+    uint64_t GetLE(size_t offset, int bytes) const {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value |= uint64_t{data_[offset + i]} << (8 * i);
+        }
+        return value;
+    }
+
+    const uint8_t *data_;
+    size_t size_;
+    size_t num_entries_{0};
+    size_t num_slots_{0};
+    size_t strings_offset_{0};
+    bool valid_{false};
+};
+
+// A read-only memory mapping of a whole file, unmapped by the destructor.
+// 一个整个文件的只读内存映射，由析构函数解除映射。
+class MappedFile {
+public:
+    explicit MappedFile(const char *path) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                data_ = static_cast<const uint8_t *>(addr);
+                size_ = st.st_size;
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            munmap(const_cast<uint8_t *>(data_), size_);
+        }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+void WriteFile(const char *path, const std::vector<uint8_t> &bytes) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+}
+
+// Compares "starting up" by inserting 1M pairs into a std::unordered_map with
+// starting up by mapping a snapshot of the same pairs, and then the lookup
+// speed of both.
+// 比较通过把1M个键值对插入std::unordered_map来"启动"与通过映射相同键值对的快照来
+// 启动，然后比较两者的查找速度。
+void RunBenchmark() {
+    constexpr size_t kNumKeys = 1'000'000;
+    const char *path = "hash_map_snapshot_benchmark.bin";
+    std::vector<std::string> keys;
+    HashMapSnapshotWriter writer;
+    for (size_t i = 0; i < kNumKeys; i++) {
+        keys.push_back("user_" + std::to_string(i * 7919) + "_session");
+        writer.Add(keys.back(), static_cast<int32_t>(i));
+    }
+    auto start = std::chrono::steady_clock::now();
+    WriteFile(path, writer.Serialize());
+    auto stop = std::chrono::steady_clock::now();
+    std::cout << "Wrote a " << kNumKeys << "-key snapshot in "
+              << std::chrono::duration<double, std::milli>(stop - start).count() << " ms\n";
+
+    start = std::chrono::steady_clock::now();
+    std::unordered_map<std::string, int> std_map;
+    for (size_t i = 0; i < kNumKeys; i++) {
+        std_map[keys[i]] = static_cast<int>(i);
+    }
+    auto middle = std::chrono::steady_clock::now();
+    MappedFile file(path);
+    HashMapSnapshotView view(file.data(), file.size());
+    stop = std::chrono::steady_clock::now();
+    std::cout << "Startup ms: std::unordered_map inserts "
+              << std::chrono::duration<double, std::milli>(middle - start).count() << ", mmap snapshot "
+              << std::chrono::duration<double, std::milli>(stop - middle).count() << "\n";
+
+    int64_t sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kNumKeys; i++) {
+        sum += std_map.find(keys[(i * 31) % kNumKeys])->second;
+    }
+    middle = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kNumKeys; i++) {
+        sum -= view.find(keys[(i * 31) % kNumKeys])->second;
+    }
+    stop = std::chrono::steady_clock::now();
+    std::cout << "Lookup ns/op: std::unordered_map "
+              << std::chrono::duration<double, std::nano>(middle - start).count() / kNumKeys << ", snapshot view "
+              << std::chrono::duration<double, std::nano>(stop - middle).count() / kNumKeys << "\n";
+    if (sum != 0 || view.size() != std_map.size()) {
+        std::cout << "The snapshot disagrees with std::unordered_map!\n";
+    }
+    unlink(path);
+}
+
+int main() {
+    // The writer takes the pairs from unordered_maps.cpp.
+    // 写入器接收unordered_maps.cpp中的键值对。
+    const char *path = "hash_map_snapshot.bin";
+    HashMapSnapshotWriter writer;
+    writer.Add("foo", 2);
+    writer.Add("jignesh", 445);
+    writer.Add("spam", 1);
+    writer.Add("eggs", 2);
+    writer.Add("garlic rice", 3);
+    writer.Add("bacon", 5);
+    writer.Add("spam", 15);
+    WriteFile(path, writer.Serialize());
+
+    // Another process could map the same file. The view answers queries on
+    // the mapped bytes without building anything.
+    // 另一个进程可以映射同一个文件。视图在映射的字节上回答查询，不需要构建任何东西。
+    MappedFile file(path);
+    HashMapSnapshotView view(file.data(), file.size());
+    if (!view.IsValid()) {
+        std::cout << "Could not map " << path << "\n";
+        return 1;
+    }
+    std::cout << "Mapped " << file.size() << " bytes holding " << view.size() << " pairs.\n";
+
+    HashMapSnapshotView::const_iterator result = view.find("jignesh");
+    if (result != view.end()) {
+        std::cout << "Found key " << result->first << " with value " << result->second << std::endl;
+    }
+    if (view.count("spam") == 1) {
+        std::cout << "Key spam has value " << view.find("spam")->second << ".\n";
+    }
+    if (view.count("tofu") == 0) {
+        std::cout << "Key tofu does not exist in the snapshot.\n";
+    }
+
+    std::cout << "Printing the elements of the snapshot:\n";
+    for (const std::pair<std::string_view, int32_t> &elem: view) {
+        std::cout << "(" << elem.first << ", " << elem.second << "), ";
+    }
+    std::cout << "\n";
+    unlink(path);
+
+    RunBenchmark();
+
+    return 0;
+}
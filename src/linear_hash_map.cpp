@@ -0,0 +1,361 @@
+/**
+ * @file linear_hash_map.cpp
+ * @brief Tutorial code for a hash map that grows one bucket at a time.
+ * @brief 每次增长一个桶的哈希映射的教程代码。
+ */
+
+// When a std::unordered_map (unordered_maps.cpp) goes over its maximum load
+// factor, the insert that crosses the line allocates a bucket array twice as
+// big and moves every node into it. Inserts are O(1) on average, but that one
+// insert takes time proportional to the whole map: milliseconds for a few
+// million entries. For a server, that shows up as a latency spike at p99.9.
+// 当std::unordered_map（unordered_maps.cpp）超过它的最大负载因子时，越过这条线
+// 的那次插入会分配一个两倍大的桶数组，并把每个节点都移动进去。插入平均是O(1)的，
+// 但那一次插入花费的时间与整个映射的大小成正比：对几百万个项来说是几毫秒。对于
+// 服务器来说，这表现为p99.9上的延迟尖峰。
+
+// LinearHashMap uses Litwin's linear hashing instead. The buckets are split in
+// a fixed round-robin order: bucket 0, then bucket 1, and so on. Each split
+// moves the nodes of one bucket into itself and one new bucket at the end, and
+// an insert that pushes the load over the limit does exactly one split. So the
+// work of doubling the table is spread over the inserts that fill it, and no
+// single insert does more than O(1) expected work.
+// LinearHashMap改用Litwin的线性哈希。桶按照固定的轮转顺序分裂：先是桶0，然后是
+// 桶1，依此类推。每次分裂把一个桶的节点移动到它自己和末尾的一个新桶中，而一次把
+// 负载推过上限的插入恰好做一次分裂。所以把表加倍的工作被分摊到填满它的那些插入
+// 上，没有哪一次插入做超过O(1)期望的工作。
+
+// Addressing works like this. In round L, the table has n0 * 2^L "old"
+// buckets, and split_ of them have already been split. A key normally goes to
+// bucket hash mod (n0 * 2^L). If that bucket was already split, its keys have
+// been divided by one more hash bit, so the key goes to bucket
+// hash mod (n0 * 2^(L+1)) instead. When every old bucket has been split, the
+// round ends: L increases by one and split_ goes back to 0.
+// 寻址是这样进行的。在第L轮，表有n0 * 2^L个"旧"桶，其中split_个已经被分裂。一个
+// 键通常去往桶hash mod (n0 * 2^L)。如果那个桶已经被分裂了，它的键已经按多一位
+// 哈希位被划分，所以这个键改为去往桶hash mod (n0 * 2^(L+1))。当所有旧桶都被分裂
+// 后，这一轮结束：L加一，split_回到0。
+
+// Includes std::sort.
+// 包含std::sort。
+#include <algorithm>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as uint64_t.
+// 包含uint64_t等定宽整数类型。
+#include <cstdint>
+// Includes std::hash and std::equal_to.
+// 包含std::hash和std::equal_to。
+#include <functional>
+// Includes std::initializer_list.
+// 包含std::initializer_list。
+#include <initializer_list>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes std::unique_ptr.
+// 包含std::unique_ptr。
+#include <memory>
+// Includes the random number library, used by the benchmark.
+// 包含随机数库，供基准测试使用。
+#include <random>
+// Includes the C++ string library.
+// 包含C++字符串库。
+#include <string>
+// Includes the unordered_map container library header, for comparison.
+// 包含unordered_map容器库头文件，用于对比。
+#include <unordered_map>
+// Includes std::pair and std::move.
+// 包含std::pair和std::move。
+#include <utility>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+
+// LinearHashMap is node based, like std::unordered_map, so references to
+// values stay valid while the table grows. It has the std::unordered_map
+// interface used in unordered_maps.cpp.
+// LinearHashMap与std::unordered_map一样是基于节点的，所以在表增长时指向值的引用
+// 仍然有效。它具有unordered_maps.cpp中使用的std::unordered_map接口。
+template<typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class LinearHashMap {
+    // Each node caches its hash, so a split never calls the hash function.
+    // 每个节点缓存它的哈希值，所以分裂时永远不会调用哈希函数。
+    struct Node {
+        std::pair<const Key, Value> value;
+        size_t hash;
+        Node *next;
+    };
+
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<const Key, Value>;
+
+    class iterator {
+    public:
+        iterator(const LinearHashMap *map, size_t bucket, Node *node) : map_(map), bucket_(bucket), node_(node) {
+            SkipEmpty();
+        }
+
+        value_type &operator*() const { return node_->value; }
+        value_type *operator->() const { return &node_->value; }
+
+        iterator &operator++() {
+            node_ = node_->next;
+            SkipEmpty();
+            return *this;
+        }
+
+        bool operator==(const iterator &other) const { return node_ == other.node_; }
+        bool operator!=(const iterator &other) const { return node_ != other.node_; }
+
+    private:
+        void SkipEmpty() {
+            while (node_ == nullptr && bucket_ + 1 < map_->bucket_count()) {
+                node_ = map_->Bucket(++bucket_);
+            }
+        }
+
+        const LinearHashMap *map_;
+        size_t bucket_;
+        Node *node_;
+    };
+
+    LinearHashMap() { segments_.emplace_back(new Node *[kSegmentSize]()); }
+
+    LinearHashMap(std::initializer_list<value_type> init) : LinearHashMap() { insert(init); }
+
+    ~LinearHashMap() {
+        for (size_t i = 0; i < bucket_count(); i++) {
+            Node *node = Bucket(i);
+            while (node != nullptr) {
+                Node *next = node->next;
+                delete node;
+                node = next;
+            }
+        }
+    }
+
+    LinearHashMap(const LinearHashMap &) = delete;
+    LinearHashMap &operator=(const LinearHashMap &) = delete;
+
+    iterator begin() const { return iterator(this, 0, Bucket(0)); }
+    iterator end() const { return iterator(this, bucket_count(), nullptr); }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    size_t bucket_count() const { return (kInitialBuckets << level_) + split_; }
+    float load_factor() const { return static_cast<float>(size_) / bucket_count(); }
+    float max_load_factor() const { return 1.0f; }
+
+    iterator find(const Key &key) const {
+        size_t hash = HashOf(key);
+        size_t bucket = BucketIndex(hash);
+        for (Node *node = Bucket(bucket); node != nullptr; node = node->next) {
+            if (node->hash == hash && key_equal_(node->value.first, key)) {
+                return iterator(this, bucket, node);
+            }
+        }
+        return end();
+    }
+
+    size_t count(const Key &key) const { return find(key) == end() ? 0 : 1; }
+
+    std::pair<iterator, bool> insert(const value_type &value) { return TryEmplace(value.first, value.second); }
+
+    void insert(std::initializer_list<value_type> init) {
+        for (const value_type &value: init) {
+            insert(value);
+        }
+    }
+
+    Value &operator[](const Key &key) { return TryEmplace(key, Value()).first->second; }
+
+    size_t erase(const Key &key) {
+        size_t hash = HashOf(key);
+        Node **link = &Bucket(BucketIndex(hash));
+        for (; *link != nullptr; link = &(*link)->next) {
+            Node *node = *link;
+            if (node->hash == hash && key_equal_(node->value.first, key)) {
+                *link = node->next;
+                delete node;
+                size_--;
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    void erase(iterator pos) { erase(pos->first); }
+
+private:
+    // The bucket array is split into fixed-size segments, so growing it never
+    // copies the buckets themselves: a split that needs a new segment
+    // allocates one. Only the small directory of segment pointers (one per
+    // 512 buckets) is ever copied by std::vector.
+    // 桶数组被划分为固定大小的段，所以增长它时永远不会复制桶本身：需要新段的分裂
+    // 只分配一个新段。只有很小的段指针目录（每512个桶一个）会被std::vector复制。
+    static constexpr size_t kSegmentBits = 9;
+    static constexpr size_t kSegmentSize = size_t{1} << kSegmentBits;
+    static constexpr size_t kInitialBuckets = 8;
+
+    size_t HashOf(const Key &key) const {
+        size_t h = hasher_(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    size_t BucketIndex(size_t hash) const {
+        size_t index = hash & ((kInitialBuckets << level_) - 1);
+        if (index < split_) {
+            index = hash & ((kInitialBuckets << (level_ + 1)) - 1);
+        }
+        return index;
+    }
+
+    Node *&Bucket(size_t index) const { return segments_[index >> kSegmentBits][index & (kSegmentSize - 1)]; }
+
+    template<typename K, typename V>
+    std::pair<iterator, bool> TryEmplace(K &&key, V &&value) {
+        size_t hash = HashOf(key);
+        size_t bucket = BucketIndex(hash);
+        for (Node *node = Bucket(bucket); node != nullptr; node = node->next) {
+            if (node->hash == hash && key_equal_(node->value.first, key)) {
+                return {iterator(this, bucket, node), false};
+            }
+        }
+        Node *node = new Node{value_type(std::forward<K>(key), std::forward<V>(value)), hash, Bucket(bucket)};
+        Bucket(bucket) = node;
+        size_++;
+        if (size_ > bucket_count() * max_load_factor()) {
+            SplitOne();
+        }
+        return {iterator(this, BucketIndex(hash), node), true};
+    }
+
+    // Splits bucket split_ into itself and bucket split_ + n0 * 2^L, using
+    // hash bit L of each node to decide where it goes.
+    // 把桶split_分裂为它自己和桶split_ + n0 * 2^L，用每个节点的第L位哈希位来决定它
+    // 去哪里。
+    void SplitOne() {
+        size_t round_size = kInitialBuckets << level_;
+        size_t new_index = round_size + split_;
+        if ((new_index >> kSegmentBits) == segments_.size()) {
+            segments_.emplace_back(new Node *[kSegmentSize]());
+        }
+
+        Node *node = Bucket(split_);
+        Node *stay = nullptr;
+        Node *move = nullptr;
+        while (node != nullptr) {
+            Node *next = node->next;
+            Node *&list = (node->hash & round_size) != 0 ? move : stay;
+            node->next = list;
+            list = node;
+            node = next;
+        }
+        Bucket(split_) = stay;
+        Bucket(new_index) = move;
+
+        if (++split_ == round_size) {
+            level_++;
+            split_ = 0;
+        }
+    }
+
+    std::vector<std::unique_ptr<Node *[]>> segments_;
+    size_t level_ = 0;
+    size_t split_ = 0;
+    size_t size_ = 0;
+    Hash hasher_;
+    KeyEqual key_equal_;
+};
+
+// Inserts n random keys one at a time, timing each insert, and prints the
+// latency percentiles and the worst insert.
+// 一次插入一个随机键，共n个，对每次插入计时，并打印延迟百分位数和最慢的那次插入。
+template<typename Map>
+void MeasureInserts(const char *name, size_t n) {
+    Map map;
+    std::mt19937_64 rng(42);
+    std::vector<double> latencies;
+    latencies.reserve(n);
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++) {
+        uint64_t key = rng();
+        auto start = std::chrono::steady_clock::now();
+        map[key] = i;
+        auto stop = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) { return latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+    std::cout << "  " << name << ": total " << std::chrono::duration<double, std::milli>(end - begin).count()
+              << " ms; p50 " << percentile(0.5) << ", p99 " << percentile(0.99) << ", p99.9 " << percentile(0.999)
+              << ", p99.99 " << percentile(0.9999) << ", max " << latencies.back() << " us\n";
+}
+
+// Compares insert latency while growing from empty to 2M keys. The totals are
+// similar, but std::unordered_map's worst inserts are its rehashes, which
+// grow with the table, while LinearHashMap's worst case stays flat.
+// 比较从空增长到2M个键时的插入延迟。总时间相近，但std::unordered_map最慢的插入
+// 是它的重新哈希，其耗时随表增长，而LinearHashMap的最坏情况保持平稳。
+void RunBenchmark() {
+    constexpr size_t kNumKeys = 2'000'000;
+    std::cout << "Insert latency while growing to " << kNumKeys << " keys:\n";
+    MeasureInserts<std::unordered_map<uint64_t, uint64_t>>("std::unordered_map", kNumKeys);
+    MeasureInserts<LinearHashMap<uint64_t, uint64_t>>("LinearHashMap     ", kNumKeys);
+}
+
+int main() {
+    // LinearHashMap is used just like the std::unordered_map in
+    // unordered_maps.cpp.
+    // LinearHashMap的用法与unordered_maps.cpp中的std::unordered_map完全相同。
+    LinearHashMap<std::string, int> map;
+    map.insert({"foo", 2});
+    map.insert(std::make_pair("jignesh", 445));
+    map.insert({{"spam", 1}, {"eggs", 2}, {"garlic rice", 3}});
+    map["bacon"] = 5;
+    map["spam"] = 15;
+
+    LinearHashMap<std::string, int>::iterator result = map.find("jignesh");
+    if (result != map.end()) {
+        std::cout << "Found key " << result->first << " with value " << result->second << std::endl;
+    }
+
+    map.erase("eggs");
+    if (map.count("eggs") == 0) {
+        std::cout << "Key-value pair with key eggs does not exist in the map.\n";
+    }
+    map.erase(map.find("garlic rice"));
+    if (map.count("garlic rice") == 0) {
+        std::cout << "Key-value pair with key garlic rice does not exist in the map.\n";
+    }
+
+    // Adding keys grows the table one bucket at a time, so the bucket count
+    // is usually not a power of two.
+    // 添加键会使表每次增长一个桶，所以桶的数量通常不是2的幂。
+    for (int i = 0; i < 100; i++) {
+        map["key" + std::to_string(i)] = i;
+    }
+    std::cout << "The map has " << map.size() << " elements in " << map.bucket_count() << " buckets (load factor "
+              << map.load_factor() << ").\n";
+    std::cout << "Printing the elements with a for-each loop:\n";
+    int printed = 0;
+    for (const std::pair<const std::string, int> &elem: map) {
+        if (printed++ < 8) {
+            std::cout << "(" << elem.first << ", " << elem.second << "), ";
+        }
+    }
+    std::cout << "... (" << printed << " in total)\n";
+
+    RunBenchmark();
+
+    return 0;
+}
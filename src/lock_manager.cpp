@@ -0,0 +1,697 @@
+/**
+ * @file lock_manager.cpp
+ * @brief Tutorial code for a hierarchical two-phase locking lock manager.
+ * @brief 分层两阶段锁管理器的教程代码。
+ */
+
+// std::scoped_lock (scoped_lock.cpp) avoids deadlock by locking a fixed set of
+// mutexes all at once. A database transaction cannot do that: it only learns
+// which rows it needs while it runs, it may lock a whole table or just a few
+// rows of it, and it may read a row first and decide to write it later. A
+// lock manager handles these locks on behalf of the transactions.
+// std::scoped_lock（scoped_lock.cpp）通过一次性锁住一组固定的互斥锁来避免死锁。
+// 数据库事务做不到这一点：它只有在运行时才知道需要哪些行，它可能锁住整张表，也可能
+// 只锁住其中几行，还可能先读一行、之后再决定写它。锁管理器代表事务来处理这些锁。
+
+// Locks are hierarchical: a transaction locks a table before any of its rows.
+// Besides shared (S) and exclusive (X), a table can be locked in an intention
+// mode, which says "I will lock some rows of this table": IS before S row
+// locks, IX before X row locks, and SIX for "read the whole table and write
+// some rows". A transaction scanning the whole table takes one S table lock
+// instead of a million row locks, and the intention modes let the lock
+// manager see the conflict with writers of individual rows at the table level.
+// 锁是分层的：事务在锁住表中的任何行之前先锁住这张表。除了共享（S）和独占（X）模式
+// 以外，表还可以用意向模式加锁，意思是"我将锁住这张表中的某些行"：在S行锁之前加IS，
+// 在X行锁之前加IX，SIX则表示"读整张表并写其中某些行"。扫描整张表的事务只需要一个
+// S表锁，而不是一百万个行锁，而意向模式让锁管理器在表这一层就能看到它与单独写某些
+// 行的事务之间的冲突。
+
+// Transactions follow two-phase locking (2PL): once a transaction releases an
+// S or X lock it may not take new locks, which makes concurrent transactions
+// serializable. Each resource has a FIFO queue of requests, so a writer is not
+// starved by a stream of readers. Transactions that wait for each other in a
+// cycle would wait forever, so a background thread builds the waits-for graph
+// every few milliseconds and aborts the youngest transaction in every cycle.
+// 事务遵循两阶段锁（2PL）协议：一旦事务释放了一个S或X锁，它就不能再获取新的锁，这使
+// 并发事务是可串行化的。每个资源有一个先进先出的请求队列，所以写者不会被源源不断的
+// 读者饿死。循环等待彼此的事务会永远等下去，所以一个后台线程每隔几毫秒构建一次等待图，
+// 并中止每个环中最年轻的事务。
+
+// Includes std::find and std::max_element.
+// 包含std::find和std::max_element。
+#include <algorithm>
+// Includes std::atomic.
+// 包含std::atomic。
+#include <atomic>
+// Includes std::chrono for the detection interval and the benchmark.
+// 包含std::chrono，用于检测间隔和基准测试。
+#include <chrono>
+// Includes std::condition_variable, which waiting requests block on.
+// 包含std::condition_variable，等待中的请求阻塞在它上面。
+#include <condition_variable>
+// Includes fixed width integer types such as uint64_t.
+// 包含uint64_t等定宽整数类型。
+#include <cstdint>
+// Includes std::hash.
+// 包含std::hash。
+#include <functional>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes std::next and std::prev.
+// 包含std::next和std::prev。
+#include <iterator>
+// Includes the list container library header, used for request queues.
+// 包含list容器库头文件，用于请求队列。
+#include <list>
+// Includes the map container library header.
+// 包含map容器库头文件。
+#include <map>
+// Includes std::unique_ptr.
+// 包含std::unique_ptr。
+#include <memory>
+// Includes the mutex library header.
+// 包含互斥锁库头文件。
+#include <mutex>
+// Includes the random number library, used by the benchmark.
+// 包含随机数库，供基准测试使用。
+#include <random>
+// Includes the set container library header.
+// 包含set容器库头文件。
+#include <set>
+// Includes std::logic_error.
+// 包含std::logic_error。
+#include <stdexcept>
+// Includes the thread library header.
+// 包含线程库头文件。
+#include <thread>
+// Includes the unordered_map container library header.
+// 包含unordered_map容器库头文件。
+#include <unordered_map>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+
+enum class LockMode { kIntentionShared, kIntentionExclusive, kShared, kSharedIntentionExclusive, kExclusive };
+
+const char *LockModeName(LockMode mode) {
+    static const char *names[] = {"IS", "IX", "S", "SIX", "X"};
+    return names[static_cast<int>(mode)];
+}
+
+// kCompatible[held][requested] says whether a transaction may be granted
+// requested while another transaction holds held on the same resource.
+// kCompatible[held][requested]表示当另一个事务在同一资源上持有held时，一个事务能否
+// 被授予requested。
+constexpr bool kCompatible[5][5] = {
+        // IS     IX     S      SIX    X
+        {true, true, true, true, false},     // IS
+        {true, true, false, false, false},   // IX
+        {true, false, true, false, false},   // S
+        {true, false, false, false, false},  // SIX
+        {false, false, false, false, false}, // X
+};
+
+bool Compatible(LockMode held, LockMode requested) {
+    return kCompatible[static_cast<int>(held)][static_cast<int>(requested)];
+}
+
+// The weakest mode that allows everything both a and b allow. A transaction
+// holding a that asks for b is upgraded to this mode; for example S and IX
+// combine into SIX.
+// 允许a和b所允许的一切的最弱模式。持有a的事务请求b时，会被升级到这个模式；例如S和IX
+// 组合成SIX。
+constexpr LockMode kSupremum[5][5] = {
+        {LockMode::kIntentionShared, LockMode::kIntentionExclusive, LockMode::kShared,
+         LockMode::kSharedIntentionExclusive, LockMode::kExclusive},
+        {LockMode::kIntentionExclusive, LockMode::kIntentionExclusive, LockMode::kSharedIntentionExclusive,
+         LockMode::kSharedIntentionExclusive, LockMode::kExclusive},
+        {LockMode::kShared, LockMode::kSharedIntentionExclusive, LockMode::kShared,
+         LockMode::kSharedIntentionExclusive, LockMode::kExclusive},
+        {LockMode::kSharedIntentionExclusive, LockMode::kSharedIntentionExclusive,
+         LockMode::kSharedIntentionExclusive, LockMode::kSharedIntentionExclusive, LockMode::kExclusive},
+        {LockMode::kExclusive, LockMode::kExclusive, LockMode::kExclusive, LockMode::kExclusive,
+         LockMode::kExclusive},
+};
+
+LockMode Supremum(LockMode a, LockMode b) { return kSupremum[static_cast<int>(a)][static_cast<int>(b)]; }
+
+// A lockable resource: a whole table when row_id is kTableLevel, otherwise a
+// row of the table.
+// 一个可加锁的资源：当row_id为kTableLevel时是整张表，否则是表中的一行。
+constexpr int64_t kTableLevel = -1;
+
+struct ResourceId {
+    uint32_t table_id;
+    int64_t row_id = kTableLevel;
+
+    bool IsTable() const { return row_id == kTableLevel; }
+    bool operator==(const ResourceId &other) const { return table_id == other.table_id && row_id == other.row_id; }
+    bool operator<(const ResourceId &other) const {
+        return table_id != other.table_id ? table_id < other.table_id : row_id < other.row_id;
+    }
+};
+
+struct ResourceIdHash {
+    size_t operator()(const ResourceId &rid) const {
+        return std::hash<uint64_t>()((static_cast<uint64_t>(rid.table_id) << 40) ^ static_cast<uint64_t>(rid.row_id));
+    }
+};
+
+using txn_id_t = uint64_t;
+
+enum class TransactionState { kGrowing, kShrinking, kCommitted, kAborted };
+
+struct LockRequestQueue;
+
+// A transaction is only ever used by one thread at a time, so the locks it
+// holds need no latch. Its state is atomic because the deadlock detector may
+// abort it from another thread. A larger id means a younger transaction.
+// 一个事务每次只会被一个线程使用，所以它持有的锁不需要闩锁。它的状态是原子的，因为
+// 死锁检测器可能从另一个线程中止它。id越大表示事务越年轻。
+class Transaction {
+public:
+    explicit Transaction(txn_id_t id) : id_(id) {}
+
+    txn_id_t id() const { return id_; }
+    TransactionState state() const { return state_.load(); }
+    const std::map<ResourceId, LockMode> &locks() const { return locks_; }
+
+private:
+    friend class LockManager;
+
+    const txn_id_t id_;
+    std::atomic<TransactionState> state_{TransactionState::kGrowing};
+    std::map<ResourceId, LockMode> locks_;
+};
+
+struct LockRequest {
+    Transaction *txn;
+    LockMode mode;
+    bool granted = false;
+};
+
+// Granted requests always form a prefix of the queue. A waiting request is
+// granted once it is compatible with every granted request and every request
+// in front of it has been granted.
+// 已授予的请求总是构成队列的前缀。一个等待中的请求在与所有已授予的请求兼容、并且它
+// 前面的每个请求都已被授予之后才会被授予。
+struct LockRequestQueue {
+    std::mutex latch;
+    std::condition_variable cv;
+    std::list<LockRequest> requests;
+    // At most one transaction may upgrade at a time: two upgraders would each
+    // wait for the other to give up its current lock.
+    // 同一时间最多只能有一个事务升级：两个升级者会各自等待对方放弃当前持有的锁。
+    Transaction *upgrading = nullptr;
+};
+
+class LockManager {
+public:
+    // Starts the deadlock detector, which runs every detection_interval.
+    // 启动死锁检测器，它每隔detection_interval运行一次。
+    explicit LockManager(std::chrono::milliseconds detection_interval = std::chrono::milliseconds(10))
+        : detection_interval_(detection_interval), detector_([this] { DetectorLoop(); }) {}
+
+    ~LockManager() {
+        {
+            std::scoped_lock lock(detector_latch_);
+            stop_detector_ = true;
+        }
+        detector_cv_.notify_all();
+        detector_.join();
+    }
+
+    LockManager(const LockManager &) = delete;
+    LockManager &operator=(const LockManager &) = delete;
+
+    std::unique_ptr<Transaction> Begin() { return std::make_unique<Transaction>(next_txn_id_++); }
+
+    // Blocks until txn holds rid in mode (or a mode covering it), and returns
+    // true. Returns false if txn was, or while waiting became, a deadlock
+    // victim; the caller must then call Abort. Asking for a mode while
+    // holding another upgrades the lock. Throws std::logic_error when the
+    // request breaks the locking protocol: a new lock in the shrinking phase,
+    // an intention mode on a row, or a row lock without a suitable table lock.
+    // 阻塞直到txn以mode（或覆盖它的模式）持有rid，并返回true。如果txn已经是、或在等待
+    // 时成为了死锁的牺牲者，则返回false；调用者之后必须调用Abort。在持有某个模式时请求
+    // 另一个模式会升级锁。当请求违反加锁协议时抛出std::logic_error：在收缩阶段获取新锁、
+    // 在行上使用意向模式，或者在没有合适的表锁时获取行锁。
+    bool Lock(Transaction *txn, const ResourceId &rid, LockMode mode) {
+        if (txn->state() == TransactionState::kAborted) {
+            return false;
+        }
+        if (txn->state() != TransactionState::kGrowing) {
+            throw std::logic_error("A transaction cannot take new locks after it has released one");
+        }
+        CheckHierarchy(txn, rid, mode);
+
+        auto held = txn->locks_.find(rid);
+        bool upgrade = held != txn->locks_.end();
+        if (upgrade && Supremum(held->second, mode) == held->second) {
+            return true;
+        }
+        LockMode target = upgrade ? Supremum(held->second, mode) : mode;
+
+        LockRequestQueue *queue = QueueFor(rid);
+        std::unique_lock lock(queue->latch);
+        auto position = queue->requests.end();
+        if (upgrade) {
+            if (queue->upgrading != nullptr) {
+                txn->state_ = TransactionState::kAborted;
+                return false;
+            }
+            // Give up the old lock and queue the stronger one in front of
+            // every waiting request, so the upgrade cannot be overtaken.
+            // 放弃旧的锁，并把更强的锁排在所有等待中的请求前面，这样升级就不会被超过。
+            auto old_request = FindRequest(queue, txn);
+            queue->requests.erase(old_request);
+            queue->upgrading = txn;
+            position = queue->requests.begin();
+            while (position != queue->requests.end() && position->granted) {
+                ++position;
+            }
+        }
+        auto request = queue->requests.insert(position, LockRequest{txn, target});
+        GrantWaiting(queue);
+
+        queue->cv.wait(lock, [&] { return request->granted || txn->state() == TransactionState::kAborted; });
+        if (upgrade) {
+            queue->upgrading = nullptr;
+        }
+        // The state is checked first: a victim must not go on to commit, even
+        // if its request was granted before it woke up. Its request is then
+        // dropped like any other release.
+        // 先检查状态：牺牲者即使在醒来之前请求已经被授予，也不能继续提交。这时它的请求
+        // 会像任何其他释放一样被丢弃。
+        if (txn->state() == TransactionState::kAborted) {
+            queue->requests.erase(request);
+            if (upgrade) {
+                txn->locks_.erase(rid);
+            }
+            GrantWaiting(queue);
+            return false;
+        }
+        txn->locks_[rid] = target;
+        return true;
+    }
+
+    // Releases one lock. Releasing an S or X lock moves txn into its shrinking
+    // phase. A table cannot be unlocked while txn still holds rows of it.
+    // 释放一个锁。释放S或X锁会使txn进入收缩阶段。当txn仍持有表中的行时，不能解锁这张表。
+    void Unlock(Transaction *txn, const ResourceId &rid) {
+        auto held = txn->locks_.find(rid);
+        if (held == txn->locks_.end()) {
+            throw std::logic_error("The transaction does not hold this lock");
+        }
+        if (rid.IsTable()) {
+            auto next = std::next(held);
+            if (next != txn->locks_.end() && next->first.table_id == rid.table_id) {
+                throw std::logic_error("Unlock the rows of a table before the table itself");
+            }
+        }
+        LockMode mode = held->second;
+        Release(txn, rid);
+        if (txn->state() == TransactionState::kGrowing && (mode == LockMode::kShared || mode == LockMode::kExclusive)) {
+            txn->state_ = TransactionState::kShrinking;
+        }
+    }
+
+    void Commit(Transaction *txn) {
+        ReleaseAll(txn);
+        txn->state_ = TransactionState::kCommitted;
+    }
+
+    void Abort(Transaction *txn) {
+        txn->state_ = TransactionState::kAborted;
+        ReleaseAll(txn);
+    }
+
+    // Builds the waits-for graph and aborts the youngest transaction of each
+    // cycle until there are none left. The background thread calls this;
+    // it is public so that it can also be run by hand. Returns the number of
+    // transactions aborted.
+    // 构建等待图，并中止每个环中最年轻的事务，直到不再有环。后台线程会调用它；它是
+    // public的，所以也可以手动运行。返回被中止的事务的数量。
+    int RunDeadlockDetection() {
+        std::map<txn_id_t, std::set<txn_id_t>> waits_for;
+        std::unordered_map<txn_id_t, LockRequestQueue *> waiting_on;
+        std::vector<LockRequestQueue *> queues;
+        {
+            std::scoped_lock lock(queues_latch_);
+            for (auto &[rid, queue]: queues_) {
+                queues.push_back(queue.get());
+            }
+        }
+        // The graph is built one queue at a time, so it can contain an edge
+        // that has gone away by the time the last queue is read, and a cycle
+        // that never existed. Only transaction ids and queues are kept, never
+        // Transaction pointers: the victim may have been granted its lock,
+        // committed and been freed since its queue was read. AbortIfWaiting
+        // looks it up again under the queue's latch.
+        // 图是一次一个队列构建的，所以它可能包含一条在读完最后一个队列时已经消失的边，
+        // 以及一个从未存在过的环。这里只保存事务id和队列，从不保存Transaction指针：自从
+        // 读取它的队列之后，牺牲者可能已经被授予了锁、提交并被释放了。AbortIfWaiting会在
+        // 队列的闩锁下重新查找它。
+        for (LockRequestQueue *queue: queues) {
+            std::scoped_lock lock(queue->latch);
+            for (auto waiter = queue->requests.begin(); waiter != queue->requests.end(); ++waiter) {
+                if (waiter->granted || waiter->txn->state() == TransactionState::kAborted) {
+                    continue;
+                }
+                // A waiter waits for every incompatible granted request and, since
+                // the queue is FIFO, for every waiting request in front of it.
+                // 等待者等待每个不兼容的已授予请求，并且由于队列是先进先出的，它还等待
+                // 排在它前面的每个等待中的请求。
+                for (auto other = queue->requests.begin(); other != waiter; ++other) {
+                    if (other->txn != waiter->txn && other->txn->state() != TransactionState::kAborted &&
+                        (!other->granted || !Compatible(other->mode, waiter->mode))) {
+                        waits_for[waiter->txn->id()].insert(other->txn->id());
+                        waiting_on[waiter->txn->id()] = queue;
+                    }
+                }
+            }
+        }
+
+        int aborted = 0;
+        for (txn_id_t victim = FindVictim(waits_for); victim != 0; victim = FindVictim(waits_for)) {
+            if (AbortIfWaiting(waiting_on[victim], victim)) {
+                aborted++;
+            }
+            waits_for.erase(victim);
+        }
+        deadlocks_ += aborted;
+        return aborted;
+    }
+
+    int64_t deadlocks() const { return deadlocks_.load(); }
+
+private:
+    // Aborts the transaction with id victim if it still has an ungranted
+    // request in queue. Such a transaction is blocked inside Lock, so it is
+    // alive, and it can only leave after taking the latch held here, at which
+    // point it sees its new state.
+    // 如果id为victim的事务在queue中仍有一个未被授予的请求，就中止它。这样的事务阻塞在
+    // Lock内部，所以它还活着，并且它只有在获取这里持有的闩锁之后才能离开，那时它会看到
+    // 自己的新状态。
+    static bool AbortIfWaiting(LockRequestQueue *queue, txn_id_t victim) {
+        std::scoped_lock lock(queue->latch);
+        for (LockRequest &request: queue->requests) {
+            if (!request.granted && request.txn->id() == victim) {
+                request.txn->state_ = TransactionState::kAborted;
+                queue->cv.notify_all();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void CheckHierarchy(Transaction *txn, const ResourceId &rid, LockMode mode) const {
+        if (rid.IsTable()) {
+            return;
+        }
+        if (mode != LockMode::kShared && mode != LockMode::kExclusive) {
+            throw std::logic_error("Rows can only be locked in S or X mode");
+        }
+        auto table = txn->locks_.find(ResourceId{rid.table_id});
+        if (table == txn->locks_.end()) {
+            throw std::logic_error("Lock the table before locking its rows");
+        }
+        // An X row lock needs a table mode that announces writes.
+        // X行锁需要一个宣告了写意图的表模式。
+        if (mode == LockMode::kExclusive && table->second != LockMode::kIntentionExclusive &&
+            table->second != LockMode::kSharedIntentionExclusive && table->second != LockMode::kExclusive) {
+            throw std::logic_error("An X row lock needs an IX, SIX or X table lock");
+        }
+    }
+
+    // Queues are created on first use and never freed, so a pointer to one
+    // stays valid without holding queues_latch_.
+    // 队列在首次使用时创建并且永远不会被释放，所以指向队列的指针在不持有queues_latch_
+    // 的情况下也保持有效。
+    LockRequestQueue *QueueFor(const ResourceId &rid) {
+        std::scoped_lock lock(queues_latch_);
+        std::unique_ptr<LockRequestQueue> &queue = queues_[rid];
+        if (queue == nullptr) {
+            queue = std::make_unique<LockRequestQueue>();
+        }
+        return queue.get();
+    }
+
+    static std::list<LockRequest>::iterator FindRequest(LockRequestQueue *queue, Transaction *txn) {
+        auto request = queue->requests.begin();
+        while (request->txn != txn) {
+            ++request;
+        }
+        return request;
+    }
+
+    // Grants waiting requests in FIFO order for as long as they are
+    // compatible with everything already granted. A request of an aborted
+    // transaction is never granted, and granting stops there so the granted
+    // requests stay a prefix; the victim removes its request when it wakes up
+    // and calls this again. Called with queue->latch held.
+    // 按先进先出的顺序授予等待中的请求，只要它们与所有已授予的请求兼容。已中止事务的
+    // 请求永远不会被授予，并且授予在那里停止，这样已授予的请求仍然构成前缀；牺牲者醒来
+    // 时会移除它的请求并再次调用这个函数。调用时需持有queue->latch。
+    static void GrantWaiting(LockRequestQueue *queue) {
+        bool granted_any = false;
+        for (auto waiter = queue->requests.begin(); waiter != queue->requests.end(); ++waiter) {
+            if (waiter->granted) {
+                continue;
+            }
+            if (waiter->txn->state() == TransactionState::kAborted) {
+                break;
+            }
+            for (auto holder = queue->requests.begin(); holder != waiter; ++holder) {
+                if (!Compatible(holder->mode, waiter->mode)) {
+                    if (granted_any) {
+                        queue->cv.notify_all();
+                    }
+                    return;
+                }
+            }
+            waiter->granted = true;
+            granted_any = true;
+        }
+        if (granted_any) {
+            queue->cv.notify_all();
+        }
+    }
+
+    void Release(Transaction *txn, const ResourceId &rid) {
+        LockRequestQueue *queue = QueueFor(rid);
+        {
+            std::scoped_lock lock(queue->latch);
+            queue->requests.erase(FindRequest(queue, txn));
+            GrantWaiting(queue);
+        }
+        txn->locks_.erase(rid);
+    }
+
+    // Releases rows before their tables by walking the locks backwards: a
+    // table's own entry sorts before all of its rows.
+    // 通过倒序遍历锁来先释放行、再释放它们的表：表自己的条目排在它所有的行之前。
+    void ReleaseAll(Transaction *txn) {
+        while (!txn->locks_.empty()) {
+            Release(txn, std::prev(txn->locks_.end())->first);
+        }
+    }
+
+    // Looks for a cycle with a depth-first search, starting from the smallest
+    // transaction id and following edges in id order, so the result does not
+    // depend on hash map order. Returns the youngest transaction on the first
+    // cycle found, or 0 if there is no cycle.
+    // 用深度优先搜索查找环，从最小的事务id开始，并按id顺序沿边前进，这样结果就不依赖于
+    // 哈希映射的顺序。返回找到的第一个环上最年轻的事务，如果没有环则返回0。
+    static txn_id_t FindVictim(const std::map<txn_id_t, std::set<txn_id_t>> &waits_for) {
+        std::set<txn_id_t> done;
+        for (const auto &[start, edges]: waits_for) {
+            std::vector<txn_id_t> path;
+            txn_id_t victim = Visit(waits_for, start, path, done);
+            if (victim != 0) {
+                return victim;
+            }
+        }
+        return 0;
+    }
+
+    static txn_id_t Visit(const std::map<txn_id_t, std::set<txn_id_t>> &waits_for, txn_id_t txn,
+                          std::vector<txn_id_t> &path, std::set<txn_id_t> &done) {
+        for (size_t i = 0; i < path.size(); i++) {
+            if (path[i] == txn) {
+                return *std::max_element(path.begin() + i, path.end());
+            }
+        }
+        if (done.count(txn) != 0) {
+            return 0;
+        }
+        auto edges = waits_for.find(txn);
+        if (edges != waits_for.end()) {
+            path.push_back(txn);
+            for (txn_id_t next: edges->second) {
+                txn_id_t victim = Visit(waits_for, next, path, done);
+                if (victim != 0) {
+                    return victim;
+                }
+            }
+            path.pop_back();
+        }
+        done.insert(txn);
+        return 0;
+    }
+
+    void DetectorLoop() {
+        std::unique_lock lock(detector_latch_);
+        while (!detector_cv_.wait_for(lock, detection_interval_, [this] { return stop_detector_; })) {
+            lock.unlock();
+            RunDeadlockDetection();
+            lock.lock();
+        }
+    }
+
+    std::atomic<txn_id_t> next_txn_id_{1};
+    std::atomic<int64_t> deadlocks_{0};
+
+    std::mutex queues_latch_;
+    std::unordered_map<ResourceId, std::unique_ptr<LockRequestQueue>, ResourceIdHash> queues_;
+
+    std::chrono::milliseconds detection_interval_;
+    std::mutex detector_latch_;
+    std::condition_variable detector_cv_;
+    bool stop_detector_ = false;
+    // Declared last so that it starts after every other member is ready.
+    // 最后声明，这样它会在所有其他成员都准备好之后才启动。
+    std::thread detector_;
+};
+
+// Runs num_threads threads of a synthetic OLTP workload on one table of
+// num_rows rows for duration_ms. 90% of transactions read two rows and write
+// two others, locking them in random order (so they can deadlock); 9% read
+// four rows; 1% scan the whole table with one S table lock. Aborted
+// transactions are retried. Prints committed transactions per second and the
+// number of deadlock victims.
+// 在一张有num_rows行的表上，用num_threads个线程运行duration_ms时间的合成OLTP负载。
+// 90%的事务读两行、写另外两行，并以随机顺序加锁（所以它们可能死锁）；9%的事务读四行；
+// 1%的事务用一个S表锁扫描整张表。被中止的事务会重试。打印每秒提交的事务数和死锁
+// 牺牲者的数量。
+void RunWorkload(int num_threads, int num_rows, int duration_ms) {
+    LockManager lock_manager(std::chrono::milliseconds(5));
+    std::vector<int64_t> table(num_rows, 0);
+    std::atomic<bool> stop{false};
+    std::atomic<int64_t> commits{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(t);
+            const ResourceId table_rid{0};
+            while (!stop.load()) {
+                int kind = static_cast<int>(rng() % 100);
+                std::vector<int64_t> rows;
+                while (rows.size() < 4) {
+                    int64_t row = rng() % num_rows;
+                    if (std::find(rows.begin(), rows.end(), row) == rows.end()) {
+                        rows.push_back(row);
+                    }
+                }
+                // Retry the same work until it commits.
+                // 重试同样的工作，直到它提交。
+                while (true) {
+                    std::unique_ptr<Transaction> txn = lock_manager.Begin();
+                    bool ok;
+                    if (kind < 90) {
+                        ok = lock_manager.Lock(txn.get(), table_rid, LockMode::kIntentionExclusive);
+                        for (size_t i = 0; ok && i < rows.size(); i++) {
+                            LockMode mode = i < 2 ? LockMode::kShared : LockMode::kExclusive;
+                            ok = lock_manager.Lock(txn.get(), ResourceId{0, rows[i]}, mode);
+                            std::this_thread::yield();
+                        }
+                        if (ok) {
+                            table[rows[2]] += table[rows[0]];
+                            table[rows[3]] += table[rows[1]];
+                        }
+                    } else if (kind < 99) {
+                        ok = lock_manager.Lock(txn.get(), table_rid, LockMode::kIntentionShared);
+                        for (size_t i = 0; ok && i < rows.size(); i++) {
+                            ok = lock_manager.Lock(txn.get(), ResourceId{0, rows[i]}, LockMode::kShared);
+                            std::this_thread::yield();
+                        }
+                    } else {
+                        ok = lock_manager.Lock(txn.get(), table_rid, LockMode::kShared);
+                    }
+                    if (ok) {
+                        lock_manager.Commit(txn.get());
+                        commits++;
+                        break;
+                    }
+                    lock_manager.Abort(txn.get());
+                }
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    stop = true;
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    std::cout << "  " << num_threads << " threads: " << commits * 1000 / duration_ms << " commits/s, "
+              << lock_manager.deadlocks() << " deadlock victims\n";
+}
+
+void RunBenchmark() {
+    std::cout << "OLTP workload on 64 rows (" << std::thread::hardware_concurrency() << " hardware threads):\n";
+    for (int num_threads = 1; num_threads <= 16; num_threads *= 2) {
+        RunWorkload(num_threads, 64, 300);
+    }
+}
+
+int main() {
+    LockManager lock_manager;
+    const ResourceId accounts{1};
+    const ResourceId alice{1, 0};
+    const ResourceId bob{1, 1};
+
+    // IS and IX are compatible, so one transaction can read rows while
+    // another writes different rows of the same table.
+    // IS和IX是兼容的，所以一个事务可以读取行，而另一个事务写同一张表的其他行。
+    std::unique_ptr<Transaction> reader = lock_manager.Begin();
+    std::unique_ptr<Transaction> writer = lock_manager.Begin();
+    lock_manager.Lock(reader.get(), accounts, LockMode::kIntentionShared);
+    lock_manager.Lock(reader.get(), alice, LockMode::kShared);
+    lock_manager.Lock(writer.get(), accounts, LockMode::kIntentionExclusive);
+    lock_manager.Lock(writer.get(), bob, LockMode::kExclusive);
+    std::cout << "Reader holds " << reader->locks().size() << " locks, writer holds " << writer->locks().size()
+              << " locks at the same time.\n";
+
+    // The reader decides to write: asking for IX while holding IS upgrades
+    // its table lock. Asking for S on the table would upgrade it to SIX.
+    // 读者决定写入：在持有IS时请求IX会升级它的表锁。在表上请求S会把它升级为SIX。
+    lock_manager.Lock(reader.get(), accounts, LockMode::kIntentionExclusive);
+    std::cout << "Reader's table lock is now " << LockModeName(reader->locks().at(accounts)) << ".\n";
+    lock_manager.Commit(reader.get());
+
+    // Two transactions lock alice and bob in opposite orders, the deadlock
+    // scoped_lock.cpp avoids by locking both at once. The detector notices
+    // the cycle and aborts the younger transaction, so the older one
+    // finishes.
+    // 两个事务以相反的顺序锁住alice和bob，这正是scoped_lock.cpp通过一次锁住两者来避免
+    // 的死锁。检测器发现这个环，并中止较年轻的事务，这样较老的事务就能完成。
+    std::unique_ptr<Transaction> younger = lock_manager.Begin();
+    lock_manager.Lock(younger.get(), accounts, LockMode::kIntentionExclusive);
+    lock_manager.Lock(younger.get(), alice, LockMode::kExclusive);
+    std::thread older_thread([&lock_manager, &writer, &alice] {
+        bool ok = lock_manager.Lock(writer.get(), alice, LockMode::kExclusive);
+        std::cout << "Older transaction " << writer->id() << (ok ? " got" : " did not get") << " alice.\n";
+        lock_manager.Commit(writer.get());
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    bool ok = lock_manager.Lock(younger.get(), bob, LockMode::kExclusive);
+    std::cout << "Younger transaction " << younger->id() << (ok ? " got" : " was aborted instead of getting")
+              << " bob.\n";
+    lock_manager.Abort(younger.get());
+    older_thread.join();
+
+    RunBenchmark();
+
+    return 0;
+}
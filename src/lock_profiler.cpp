@@ -0,0 +1,475 @@
+/**
+ * @file lock_profiler.cpp
+ * @brief Tutorial code for mutex wrappers that record lock contention.
+ * @brief 记录锁竞争情况的互斥锁包装类的教程代码。
+ */
+
+// A program with many mutexes, such as m in mutex.cpp, scoped_lock.cpp and
+// rwlock.cpp, can slow down because threads wait for one of them, but a CPU
+// profiler mostly shows time spent running, not time spent waiting. To find
+// the lock that is the bottleneck we need to know, per lock, how often it was
+// taken, how often a thread had to wait for it, how long those waits were,
+// and how long threads held it.
+// 一个有许多互斥锁的程序（比如mutex.cpp、scoped_lock.cpp和rwlock.cpp中的m）可能会
+// 因为线程在等待其中某一个锁而变慢，但CPU性能分析器主要显示的是运行的时间，而不是
+// 等待的时间。要找出哪个锁是瓶颈，我们需要知道每个锁被获取了多少次、线程有多少次
+// 必须等待它、这些等待有多长，以及线程持有它多长时间。
+
+// ProfiledMutex and ProfiledSharedMutex wrap std::mutex and std::shared_mutex
+// with the same member functions, so they are drop-in replacements that work
+// with std::scoped_lock, std::unique_lock and std::shared_lock. Each is
+// constructed with a name, and all locks with the same name add to the same
+// statistics, so for example every per-row lock of a table can share one
+// entry. LockProfiler::Instance() returns the statistics as structs, or as
+// JSON.
+// ProfiledMutex和ProfiledSharedMutex用相同的成员函数包装了std::mutex和
+// std::shared_mutex，所以它们可以直接替换，并且可以与std::scoped_lock、
+// std::unique_lock和std::shared_lock一起使用。每个锁在构造时都有一个名字，同名的
+// 所有锁累加到同一份统计信息中，例如一个表的所有行锁可以共享一个条目。
+// LockProfiler::Instance()以结构体或JSON的形式返回这些统计信息。
+
+// To stay cheap enough to leave on in production, an uncontended acquisition
+// costs one try_lock and one relaxed atomic increment. The clock is only read
+// when a thread has to wait, which is slow anyway, and for one in every
+// kHoldSampleEvery exclusive acquisitions, whose hold time is recorded.
+// 为了足够便宜、可以在生产环境中一直开着，一次无竞争的获取只需要一次try_lock和一次
+// relaxed原子增加。只有当线程必须等待时（这本来就很慢）才会读取时钟，另外每
+// kHoldSampleEvery次独占获取中有一次会读取时钟，并记录它的持有时间。
+
+// Includes std::sort.
+// 包含std::sort。
+#include <algorithm>
+// Includes std::array.
+// 包含std::array。
+#include <array>
+// Includes std::atomic.
+// 包含std::atomic。
+#include <atomic>
+// Includes std::chrono for measuring wait and hold times.
+// 包含std::chrono，用于测量等待时间和持有时间。
+#include <chrono>
+// Includes fixed width integer types such as uint64_t.
+// 包含uint64_t等定宽整数类型。
+#include <cstdint>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes the map container library header.
+// 包含map容器库头文件。
+#include <map>
+// Includes std::unique_ptr.
+// 包含std::unique_ptr。
+#include <memory>
+// Includes the mutex library header.
+// 包含互斥锁库头文件。
+#include <mutex>
+// Includes the shared mutex library header.
+// 包含共享互斥锁库头文件。
+#include <shared_mutex>
+// Includes std::ostringstream, used to build the JSON report.
+// 包含std::ostringstream，用于构建JSON报告。
+#include <sstream>
+// Includes the C++ string library.
+// 包含C++字符串库。
+#include <string>
+// Includes the thread library header.
+// 包含线程库头文件。
+#include <thread>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+
+// The size of a cache line on x86 and most ARM cores. C++17 has
+// std::hardware_destructive_interference_size for this, but not every
+// compiler provides it yet.
+// x86和大多数ARM核心上缓存行的大小。C++17为此提供了
+// std::hardware_destructive_interference_size，但并不是每个编译器都已经支持它。
+constexpr size_t kCacheLineSize = 64;
+
+// Hold times go into a histogram with power-of-two buckets: bucket i counts
+// hold times in [2^i, 2^(i+1)) nanoseconds, and the last bucket also counts
+// everything longer.
+// 持有时间被放入一个以2的幂为桶的直方图：桶i统计[2^i, 2^(i+1))纳秒范围内的持有时间，
+// 最后一个桶还统计所有更长的时间。
+constexpr int kHistogramBuckets = 32;
+constexpr uint64_t kHoldSampleEvery = 16;
+
+uint64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+// LockReport is a plain copy of one name's statistics, safe to read and pass
+// around while the locks keep running.
+// LockReport是某个名字的统计信息的一份普通拷贝，在锁继续运行时也可以安全地读取和
+// 传递。
+struct LockReport {
+    std::string name;
+    uint64_t acquisitions = 0;
+    uint64_t shared_acquisitions = 0;
+    uint64_t contended = 0;
+    uint64_t total_wait_ns = 0;
+    uint64_t max_wait_ns = 0;
+    uint64_t hold_samples = 0;
+    std::array<uint64_t, kHistogramBuckets> hold_histogram{};
+};
+
+// The live counters for one name. Every field is a relaxed atomic, since many
+// locks on many threads may update it at once and none of the updates needs to
+// be ordered with anything else. The struct is aligned to a cache line so that
+// two busy locks with different names do not slow each other down.
+// 某个名字的实时计数器。每个字段都是relaxed原子变量，因为许多线程上的许多锁可能同时
+// 更新它，而且这些更新都不需要与其他任何操作排序。这个结构体对齐到缓存行，这样两个
+// 名字不同的繁忙的锁不会相互拖慢。
+struct alignas(kCacheLineSize) LockStats {
+    // Counts an acquisition and returns whether its hold time should be
+    // sampled.
+    // 统计一次获取，并返回是否应该采样它的持有时间。
+    bool RecordAcquire() {
+        return acquisitions.fetch_add(1, std::memory_order_relaxed) % kHoldSampleEvery == 0;
+    }
+
+    void RecordSharedAcquire() { shared_acquisitions.fetch_add(1, std::memory_order_relaxed); }
+
+    void RecordWait(uint64_t wait_ns) {
+        contended.fetch_add(1, std::memory_order_relaxed);
+        total_wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+        uint64_t max = max_wait_ns.load(std::memory_order_relaxed);
+        while (wait_ns > max && !max_wait_ns.compare_exchange_weak(max, wait_ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    void RecordHold(uint64_t hold_ns) {
+        int bucket = 0;
+        while (bucket < kHistogramBuckets - 1 && (hold_ns >> (bucket + 1)) != 0) {
+            bucket++;
+        }
+        hold_histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> shared_acquisitions{0};
+    std::atomic<uint64_t> contended{0};
+    std::atomic<uint64_t> total_wait_ns{0};
+    std::atomic<uint64_t> max_wait_ns{0};
+    std::array<std::atomic<uint64_t>, kHistogramBuckets> hold_histogram{};
+};
+
+// LockProfiler owns the statistics of every name. Locks look their entry up
+// once, when they are constructed, so the registry's own mutex is never on the
+// locking path.
+// LockProfiler拥有每个名字的统计信息。锁只在构造时查找一次自己的条目，所以注册表
+// 自己的互斥锁永远不会出现在加锁路径上。
+class LockProfiler {
+public:
+    static LockProfiler &Instance() {
+        static LockProfiler profiler;
+        return profiler;
+    }
+
+    // Returns the statistics for name, creating them on first use. The
+    // pointer stays valid for the life of the program.
+    // 返回name的统计信息，首次使用时创建。该指针在程序的整个生命周期内都有效。
+    LockStats *StatsFor(const std::string &name) {
+        std::scoped_lock lock(m_);
+        std::unique_ptr<LockStats> &stats = stats_[name];
+        if (stats == nullptr) {
+            stats = std::make_unique<LockStats>();
+        }
+        return stats.get();
+    }
+
+    // Returns one report per name, with the longest total wait first, since
+    // that is the lock most worth looking at.
+    // 每个名字返回一份报告，总等待时间最长的排在最前面，因为那是最值得查看的锁。
+    std::vector<LockReport> Report() const {
+        std::vector<LockReport> reports;
+        {
+            std::scoped_lock lock(m_);
+            for (const auto &[name, stats]: stats_) {
+                LockReport report;
+                report.name = name;
+                report.acquisitions = stats->acquisitions.load(std::memory_order_relaxed);
+                report.shared_acquisitions = stats->shared_acquisitions.load(std::memory_order_relaxed);
+                report.contended = stats->contended.load(std::memory_order_relaxed);
+                report.total_wait_ns = stats->total_wait_ns.load(std::memory_order_relaxed);
+                report.max_wait_ns = stats->max_wait_ns.load(std::memory_order_relaxed);
+                for (int i = 0; i < kHistogramBuckets; i++) {
+                    report.hold_histogram[i] = stats->hold_histogram[i].load(std::memory_order_relaxed);
+                    report.hold_samples += report.hold_histogram[i];
+                }
+                reports.push_back(report);
+            }
+        }
+        std::sort(reports.begin(), reports.end(), [](const LockReport &a, const LockReport &b) {
+            return a.total_wait_ns > b.total_wait_ns;
+        });
+        return reports;
+    }
+
+    // Returns Report() as a JSON array. The histogram is written as an object
+    // from each non-empty bucket's lower bound in nanoseconds to its count.
+    // 以JSON数组的形式返回Report()。直方图被写成一个对象，把每个非空桶以纳秒计的下界
+    // 映射到它的计数。
+    std::string ToJson() const {
+        std::ostringstream out;
+        out << "[";
+        std::vector<LockReport> reports = Report();
+        for (size_t i = 0; i < reports.size(); i++) {
+            const LockReport &report = reports[i];
+            out << (i == 0 ? "\n" : ",\n") << "  {\"name\": \"" << EscapeJson(report.name)
+                << "\", \"acquisitions\": " << report.acquisitions
+                << ", \"shared_acquisitions\": " << report.shared_acquisitions
+                << ", \"contended\": " << report.contended << ", \"total_wait_ns\": " << report.total_wait_ns
+                << ", \"max_wait_ns\": " << report.max_wait_ns << ", \"hold_ns_histogram\": {";
+            bool first = true;
+            for (int bucket = 0; bucket < kHistogramBuckets; bucket++) {
+                if (report.hold_histogram[bucket] != 0) {
+                    out << (first ? "" : ", ") << "\"" << (uint64_t{1} << bucket)
+                        << "\": " << report.hold_histogram[bucket];
+                    first = false;
+                }
+            }
+            out << "}}";
+        }
+        out << (reports.empty() ? "]" : "\n]");
+        return out.str();
+    }
+
+private:
+    LockProfiler() = default;
+
+    static std::string EscapeJson(const std::string &text) {
+        std::string escaped;
+        for (char c: text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                const char *hex = "0123456789abcdef";
+                escaped += "\\u00";
+                escaped += hex[c >> 4];
+                escaped += hex[c & 0xf];
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    mutable std::mutex m_;
+    std::map<std::string, std::unique_ptr<LockStats>> stats_;
+};
+
+// ProfiledMutex has the member functions of std::mutex. lock first tries the
+// lock without waiting; only if that fails does it read the clock and count
+// the acquisition as contended.
+// ProfiledMutex具有std::mutex的成员函数。lock首先不等待地尝试加锁；只有失败时才会
+// 读取时钟，并把这次获取计为有竞争的。
+class ProfiledMutex {
+public:
+    explicit ProfiledMutex(const std::string &name) : stats_(LockProfiler::Instance().StatsFor(name)) {}
+    ProfiledMutex(const ProfiledMutex &) = delete;
+    ProfiledMutex &operator=(const ProfiledMutex &) = delete;
+
+    void lock() {
+        if (!mutex_.try_lock()) {
+            uint64_t start = NowNs();
+            mutex_.lock();
+            stats_->RecordWait(NowNs() - start);
+        }
+        OnAcquired();
+    }
+
+    bool try_lock() {
+        if (!mutex_.try_lock()) {
+            return false;
+        }
+        OnAcquired();
+        return true;
+    }
+
+    void unlock() {
+        if (hold_start_ns_ != 0) {
+            stats_->RecordHold(NowNs() - hold_start_ns_);
+        }
+        mutex_.unlock();
+    }
+
+private:
+    // hold_start_ns_ is only touched by the thread holding the lock.
+    // hold_start_ns_只会被持有锁的线程访问。
+    void OnAcquired() { hold_start_ns_ = stats_->RecordAcquire() ? NowNs() : 0; }
+
+    std::mutex mutex_;
+    LockStats *stats_;
+    uint64_t hold_start_ns_ = 0;
+};
+
+// ProfiledSharedMutex has the member functions of std::shared_mutex. Shared
+// acquisitions record waits but not hold times: many readers hold the lock at
+// once, and the mutex has nowhere to keep a start time per reader.
+// ProfiledSharedMutex具有std::shared_mutex的成员函数。共享获取会记录等待，但不记录
+// 持有时间：许多读者同时持有锁，而互斥锁没有地方为每个读者保存开始时间。
+class ProfiledSharedMutex {
+public:
+    explicit ProfiledSharedMutex(const std::string &name) : stats_(LockProfiler::Instance().StatsFor(name)) {}
+    ProfiledSharedMutex(const ProfiledSharedMutex &) = delete;
+    ProfiledSharedMutex &operator=(const ProfiledSharedMutex &) = delete;
+
+    void lock() {
+        if (!mutex_.try_lock()) {
+            uint64_t start = NowNs();
+            mutex_.lock();
+            stats_->RecordWait(NowNs() - start);
+        }
+        hold_start_ns_ = stats_->RecordAcquire() ? NowNs() : 0;
+    }
+
+    bool try_lock() {
+        if (!mutex_.try_lock()) {
+            return false;
+        }
+        hold_start_ns_ = stats_->RecordAcquire() ? NowNs() : 0;
+        return true;
+    }
+
+    void unlock() {
+        if (hold_start_ns_ != 0) {
+            stats_->RecordHold(NowNs() - hold_start_ns_);
+        }
+        mutex_.unlock();
+    }
+
+    void lock_shared() {
+        if (!mutex_.try_lock_shared()) {
+            uint64_t start = NowNs();
+            mutex_.lock_shared();
+            stats_->RecordWait(NowNs() - start);
+        }
+        stats_->RecordSharedAcquire();
+    }
+
+    bool try_lock_shared() {
+        if (!mutex_.try_lock_shared()) {
+            return false;
+        }
+        stats_->RecordSharedAcquire();
+        return true;
+    }
+
+    void unlock_shared() { mutex_.unlock_shared(); }
+
+private:
+    std::shared_mutex mutex_;
+    LockStats *stats_;
+    uint64_t hold_start_ns_ = 0;
+};
+
+// The global count and mutexes of mutex.cpp and rwlock.cpp, now profiled.
+// mutex.cpp和rwlock.cpp中的全局计数和互斥锁，现在带有性能分析。
+int count = 0;
+ProfiledMutex m("mutex.cpp m");
+ProfiledSharedMutex rw("rwlock.cpp m");
+
+void add_count() {
+    std::scoped_lock lk(m);
+    count += 1;
+}
+
+void read_value() {
+    std::shared_lock lk(rw);
+    std::cout << "Reading value " + std::to_string(count) + "\n" << std::flush;
+}
+
+void write_value() {
+    std::unique_lock lk(rw);
+    count += 3;
+}
+
+// Measures the cost of an uncontended lock and unlock, and throughput when
+// four threads share one lock, for std::mutex and ProfiledMutex.
+// 对std::mutex和ProfiledMutex，测量一次无竞争的加锁和解锁的开销，以及四个线程共享
+// 一个锁时的吞吐量。
+template<typename Mutex, typename... Args>
+double MeasureNsPerLock(int num_threads, Args... args) {
+    const int total_ops = 1 << 21;
+    Mutex mutex(args...);
+    uint64_t sum = 0;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&mutex, &sum, num_threads] {
+            for (int i = 0; i < total_ops / num_threads; i++) {
+                std::scoped_lock lock(mutex);
+                sum++;
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / total_ops;
+}
+
+void RunBenchmark() {
+    std::cout << "ns per lock and unlock:\n";
+    for (int num_threads: {1, 4}) {
+        double plain_ns = MeasureNsPerLock<std::mutex>(num_threads);
+        double profiled_ns = MeasureNsPerLock<ProfiledMutex>(num_threads, std::string("benchmark"));
+        std::cout << "  " << num_threads << " threads: std::mutex " << plain_ns << ", ProfiledMutex "
+                  << profiled_ns << "\n";
+    }
+}
+
+int main() {
+    // The programs of mutex.cpp and rwlock.cpp, unchanged apart from the
+    // types of m.
+    // mutex.cpp和rwlock.cpp的程序，除了m的类型以外没有改变。
+    std::thread t1(add_count);
+    std::thread t2(add_count);
+    t1.join();
+    t2.join();
+    std::cout << "Printing count: " << count << std::endl;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 6; i++) {
+        threads.emplace_back(i == 1 || i == 4 ? write_value : read_value);
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+
+    // Four threads share one hot lock that they hold for a while, and each
+    // has a cold lock of its own. The report should point at the hot one.
+    // 四个线程共享一个热锁，并且会持有它一段时间，每个线程还有一个自己的冷锁。报告
+    // 应该指向那个热锁。
+    ProfiledMutex hot("hot");
+    threads.clear();
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&hot] {
+            ProfiledMutex cold("cold");
+            for (int i = 0; i < 2000; i++) {
+                {
+                    std::scoped_lock lock(hot);
+                    std::this_thread::sleep_for(std::chrono::microseconds(10));
+                }
+                std::scoped_lock lock(cold);
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+
+    std::vector<LockReport> reports = LockProfiler::Instance().Report();
+    const LockReport &worst = reports.front();
+    std::cout << "The most waited-for lock is " << worst.name << ": " << worst.contended << " of "
+              << worst.acquisitions << " acquisitions waited, " << worst.total_wait_ns / 1000000 << " ms in total.\n";
+    std::cout << LockProfiler::Instance().ToJson() << "\n";
+
+    RunBenchmark();
+
+    return 0;
+}
@@ -0,0 +1,615 @@
+/**
+ * @file membership_filters.cpp
+ * @brief Tutorial code for Bloom and cuckoo filters in front of sets and maps.
+ * @brief 放在集合和映射前面的布隆过滤器和布谷鸟过滤器的教程代码。
+ */
+
+// In sets.cpp and unordered_maps.cpp we check for keys that are NOT there,
+// for example int_set.count(11) == 0 and map.count("eggs") == 0. If most
+// lookups in a program are misses like these, every one of them still walks
+// the whole container: down a std::set, or along a std::unordered_map bucket
+// chain, hashing and comparing keys on the way.
+// 在sets.cpp和unordered_maps.cpp中，我们检查了一些不存在的键，例如
+// int_set.count(11) == 0和map.count("eggs") == 0。如果一个程序中大多数查找都
+// 是这样的未命中，每一次查找仍然要走完整个容器：沿着std::set向下，或者沿着
+// std::unordered_map的桶链，一路上哈希并比较键。
+
+// A membership filter is a small, approximate summary of a set of keys. It
+// can answer "definitely not present" or "maybe present". A "maybe" can be a
+// false positive, but a "no" is always right. So we ask the filter first and
+// only go to the real container when the filter says "maybe". With a 1% false
+// positive rate, 99% of the misses never touch the container.
+// 成员过滤器是一个键集合的小型近似摘要。它可以回答"肯定不存在"或者"可能存在"。
+// "可能"可能是一个假阳性，但"不"永远是正确的。所以我们先问过滤器，只有当过滤器
+// 说"可能"时才去查真正的容器。在1%的假阳性率下，99%的未命中根本不会碰到容器。
+
+// This file shows two filters:
+//   - A blocked Bloom filter. Each key sets 8 bits, all inside one 32-byte
+//     block, so a probe touches a single cache line. It cannot delete keys.
+//   - A cuckoo filter. It stores a small fingerprint of every key in one of
+//     two candidate buckets, so it can delete keys too.
+// 本文件展示了两种过滤器：
+//   - 分块布隆过滤器。每个键设置8个位，全部位于一个32字节的块中，所以一次探测
+//     只访问一个缓存行。它不能删除键。
+//   - 布谷鸟过滤器。它把每个键的一个小指纹存储在两个候选桶中的一个里，所以它
+//     也可以删除键。
+
+// Includes std::min, std::max and std::clamp.
+// 包含std::min、std::max和std::clamp。
+#include <algorithm>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes std::log2 and std::ceil, used to size the filters.
+// 包含std::log2和std::ceil，用于确定过滤器的大小。
+#include <cmath>
+// Includes fixed width integer types such as uint64_t.
+// 包含uint64_t等定宽整数类型。
+#include <cstdint>
+// Includes std::memcpy.
+// 包含std::memcpy。
+#include <cstring>
+// Includes std::hash.
+// 包含std::hash。
+#include <functional>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes std::unique_ptr.
+// 包含std::unique_ptr。
+#include <memory>
+// Includes the random number library, used by the cuckoo filter and benchmarks.
+// 包含随机数库，由布谷鸟过滤器和基准测试使用。
+#include <random>
+// Includes the set container library header.
+// 包含集合容器库头文件。
+#include <set>
+// Includes the C++ string library.
+// 包含C++字符串库。
+#include <string>
+// Includes the unordered_map container library header.
+// 包含unordered_map容器库头文件。
+#include <unordered_map>
+// Includes std::pair.
+// 包含std::pair。
+#include <utility>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+// Includes the SSE2 intrinsics used to test a Bloom block in two instructions.
+// 包含SSE2内建函数，用于用两条指令测试一个布隆块。
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// std::hash<int> is the identity function in most standard libraries, which
+// is fine for a hash table but terrible for a filter that takes bits out of
+// the hash. So we scramble the result with the MurmurHash3 finalizer.
+// 在大多数标准库中std::hash<int>是恒等函数，这对哈希表来说没问题，但对于从哈希
+// 值中取位的过滤器来说就很糟糕了。所以我们用MurmurHash3的最终混合函数打乱结果。
+template<typename Key>
+uint64_t MixedHash(const Key &key) {
+    uint64_t h = std::hash<Key>()(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// A split block Bloom filter, as used by Impala and Parquet. The filter is an
+// array of 256-bit blocks, each made of eight 32-bit words. A key picks one
+// block with its hash, and then sets exactly one bit in each of the eight
+// words. A probe loads one block and checks all eight bits at once.
+// 分裂块布隆过滤器，Impala和Parquet使用的就是它。过滤器是一个256位块的数组，每个
+// 块由八个32位的字组成。一个键用它的哈希值选择一个块，然后在八个字中的每一个里
+// 恰好设置一位。一次探测加载一个块，并一次性检查全部八个位。
+template<typename Key>
+class BlockedBloomFilter {
+public:
+    static constexpr bool kSupportsErase = false;
+
+    // Sizes the filter for expected_keys keys at the given false positive
+    // rate. An ideal Bloom filter needs 1.44 * log2(1 / fpr) bits per key;
+    // packing the bits of a key into one block costs about 20% more.
+    // 按给定的假阳性率为expected_keys个键确定过滤器的大小。理想的布隆过滤器每个键
+    // 需要1.44 * log2(1 / fpr)位；把一个键的位打包到一个块中大约要多花20%。
+    BlockedBloomFilter(size_t expected_keys, double false_positive_rate) {
+        double bits_per_key = 1.44 * std::log2(1.0 / false_positive_rate) * 1.2;
+        size_t num_blocks = static_cast<size_t>(std::ceil(expected_keys * bits_per_key / 256.0));
+        blocks_.resize(std::max<size_t>(num_blocks, 1));
+    }
+
+    // A Bloom filter never fills up, it only gets less accurate, so Insert
+    // always succeeds. It returns bool to match CuckooFilter::Insert.
+    // 布隆过滤器永远不会满，只会变得不那么准确，所以Insert总是成功。它返回bool是为了
+    // 与CuckooFilter::Insert保持一致。
+    bool Insert(const Key &key) {
+        uint64_t hash = MixedHash(key);
+        Block &block = blocks_[BlockIndex(hash)];
+        uint32_t mask[8];
+        MakeMask(static_cast<uint32_t>(hash), mask);
+        for (int i = 0; i < 8; i++) {
+            block.words[i] |= mask[i];
+        }
+        return true;
+    }
+
+    bool MayContain(const Key &key) const { return MayContainHash(MixedHash(key)); }
+
+    // Probes a batch of keys. All the hashes are computed and their blocks
+    // prefetched first, so the cache misses of the whole batch overlap
+    // instead of being paid one after another.
+    // 探测一批键。首先计算所有的哈希值并预取它们的块，这样整批的缓存未命中会
+    // 重叠起来，而不是一个接一个地付出代价。
+    void MayContainBatch(const Key *keys, size_t n, bool *out) const {
+        constexpr size_t kBatch = 16;
+        uint64_t hashes[kBatch];
+        for (size_t start = 0; start < n; start += kBatch) {
+            size_t count = std::min(kBatch, n - start);
+            for (size_t i = 0; i < count; i++) {
+                hashes[i] = MixedHash(keys[start + i]);
+                __builtin_prefetch(&blocks_[BlockIndex(hashes[i])]);
+            }
+            for (size_t i = 0; i < count; i++) {
+                out[start + i] = MayContainHash(hashes[i]);
+            }
+        }
+    }
+
+    size_t MemoryUsage() const { return blocks_.size() * sizeof(Block); }
+
+private:
+    struct alignas(32) Block {
+        uint32_t words[8] = {};
+    };
+
+    // Uses the high 32 bits of the hash to pick the block. Multiplying and
+    // shifting maps the hash onto [0, num_blocks) without a slow modulo.
+    // 用哈希值的高32位来选择块。乘法加移位把哈希值映射到[0, num_blocks)上，而不
+    // 需要缓慢的取模运算。
+    size_t BlockIndex(uint64_t hash) const { return ((hash >> 32) * blocks_.size()) >> 32; }
+
+    // Each of the eight salts turns the low 32 bits of the hash into a
+    // different bit position (0-31) for its word.
+    // 八个盐值中的每一个都把哈希值的低32位变成其对应字中的一个不同位位置(0-31)。
+    static void MakeMask(uint32_t hash, uint32_t mask[8]) {
+        static constexpr uint32_t kSalts[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                               0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+        for (int i = 0; i < 8; i++) {
+            mask[i] = uint32_t{1} << ((hash * kSalts[i]) >> 27);
+        }
+    }
+
+    bool MayContainHash(uint64_t hash) const {
+        const Block &block = blocks_[BlockIndex(hash)];
+        alignas(16) uint32_t mask[8];
+        MakeMask(static_cast<uint32_t>(hash), mask);
+#if defined(__SSE2__)
+        // A key is present if (mask & ~block) is all zero: two 128-bit and-not
+        // operations check all eight words.
+        // 如果(mask & ~block)全为零，键就存在：两次128位的and-not运算检查全部八个字。
+        __m128i lo = _mm_andnot_si128(_mm_load_si128(reinterpret_cast<const __m128i *>(block.words)),
+                                      _mm_load_si128(reinterpret_cast<const __m128i *>(mask)));
+        __m128i hi = _mm_andnot_si128(_mm_load_si128(reinterpret_cast<const __m128i *>(block.words + 4)),
+                                      _mm_load_si128(reinterpret_cast<const __m128i *>(mask + 4)));
+        __m128i missing = _mm_or_si128(lo, hi);
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(missing, _mm_setzero_si128())) == 0xFFFF;
+#else
+        for (int i = 0; i < 8; i++) {
+            if ((block.words[i] & mask[i]) != mask[i]) {
+                return false;
+            }
+        }
+        return true;
+#endif
+    }
+
+    std::vector<Block> blocks_;
+};
+
+// A cuckoo filter (Fan et al.). Every bucket has four slots, and each slot
+// holds a fingerprint of up to 16 bits. A key can live in bucket i1 or in
+// bucket i2 = i1 ^ hash(fingerprint), so either bucket can be computed from
+// the other plus the fingerprint. That is what lets us move fingerprints
+// around ("cuckoo" them out of their nest) without knowing the original keys,
+// and what lets us delete a key by removing its fingerprint.
+// 布谷鸟过滤器（Fan等人）。每个桶有四个槽，每个槽保存一个最多16位的指纹。一个键
+// 可以位于桶i1或者桶i2 = i1 ^ hash(指纹)中，所以任何一个桶都可以由另一个桶加上
+// 指纹计算出来。这就是为什么我们可以在不知道原始键的情况下移动指纹（把它们像
+// 布谷鸟一样"踢出巢"），也是为什么我们可以通过移除指纹来删除一个键。
+template<typename Key>
+class CuckooFilter {
+public:
+    static constexpr bool kSupportsErase = true;
+
+    // A lookup compares the fingerprint with 8 slots, so the false positive
+    // rate is about 8 / 2^bits. We pick the smallest fingerprint size that
+    // meets the target, and size the table to be about 95% full.
+    // 一次查找把指纹与8个槽进行比较，所以假阳性率大约是8 / 2^bits。我们选择满足
+    // 目标的最小指纹长度，并把表的大小设置为大约95%满。
+    CuckooFilter(size_t expected_keys, double false_positive_rate) {
+        int bits = static_cast<int>(std::ceil(std::log2(8.0 / false_positive_rate)));
+        fingerprint_mask_ = static_cast<uint16_t>((1u << std::clamp(bits, 4, 16)) - 1);
+        size_t num_buckets = 1;
+        while (num_buckets * 4 * 0.95 < expected_keys) {
+            num_buckets *= 2;
+        }
+        buckets_.resize(num_buckets);
+    }
+
+    // Returns false if the filter is too full to take the key. In that case
+    // the filter is unchanged, so every key inserted before is still found.
+    // 如果过滤器太满而无法放入该键，则返回false。这种情况下过滤器没有改变，所以之前
+    // 插入的每个键仍然能被找到。
+    bool Insert(const Key &key) {
+        if (has_victim_) {
+            return false;
+        }
+        uint64_t hash = MixedHash(key);
+        uint16_t fingerprint = Fingerprint(hash);
+        size_t i1 = hash & (buckets_.size() - 1);
+        size_t i2 = AltIndex(i1, fingerprint);
+        if (buckets_[i1].Add(fingerprint) || buckets_[i2].Add(fingerprint)) {
+            return true;
+        }
+        // Both buckets are full. Kick a random fingerprint out of one of them
+        // into its alternate bucket, and repeat. If the chain gets too long,
+        // the fingerprint left in hand belongs to some earlier key, so it
+        // cannot be dropped: it is parked in the victim slot, which lookups
+        // also check. The new key itself is already in the table by then.
+        // 两个桶都满了。把其中一个桶里的一个随机指纹踢到它的备用桶中，然后重复。如果
+        // 这条链太长，手里剩下的指纹属于之前的某个键，所以不能丢掉它：它被停放在受害者
+        // 槽中，查找也会检查这个槽。此时新键本身已经在表中了。
+        size_t index = (rng_() & 1) ? i1 : i2;
+        for (int kicks = 0; kicks < 500; kicks++) {
+            int slot = rng_() % 4;
+            std::swap(fingerprint, buckets_[index].slots[slot]);
+            index = AltIndex(index, fingerprint);
+            if (buckets_[index].Add(fingerprint)) {
+                return true;
+            }
+        }
+        has_victim_ = true;
+        victim_fingerprint_ = fingerprint;
+        victim_index_ = index;
+        return true;
+    }
+
+    bool Erase(const Key &key) {
+        uint64_t hash = MixedHash(key);
+        uint16_t fingerprint = Fingerprint(hash);
+        size_t i1 = hash & (buckets_.size() - 1);
+        size_t i2 = AltIndex(i1, fingerprint);
+        if (has_victim_ && fingerprint == victim_fingerprint_ && (victim_index_ == i1 || victim_index_ == i2)) {
+            has_victim_ = false;
+            return true;
+        }
+        if (!buckets_[i1].Remove(fingerprint) && !buckets_[i2].Remove(fingerprint)) {
+            return false;
+        }
+        // A slot was freed, so the victim may fit back into the table now.
+        // 一个槽被释放了，所以受害者现在也许能放回表中。
+        if (has_victim_ && (buckets_[victim_index_].Add(victim_fingerprint_) ||
+                            buckets_[AltIndex(victim_index_, victim_fingerprint_)].Add(victim_fingerprint_))) {
+            has_victim_ = false;
+        }
+        return true;
+    }
+
+    bool MayContain(const Key &key) const {
+        uint64_t hash = MixedHash(key);
+        uint16_t fingerprint = Fingerprint(hash);
+        size_t i1 = hash & (buckets_.size() - 1);
+        size_t i2 = AltIndex(i1, fingerprint);
+        return buckets_[i1].Contains(fingerprint) || buckets_[i2].Contains(fingerprint) ||
+               VictimMatches(i1, i2, fingerprint);
+    }
+
+    // Like BlockedBloomFilter::MayContainBatch, prefetches both candidate
+    // buckets of every key in the batch before probing any of them.
+    // 与BlockedBloomFilter::MayContainBatch一样，在探测之前预取批次中每个键的两个
+    // 候选桶。
+    void MayContainBatch(const Key *keys, size_t n, bool *out) const {
+        constexpr size_t kBatch = 16;
+        size_t i1s[kBatch];
+        size_t i2s[kBatch];
+        uint16_t fingerprints[kBatch];
+        for (size_t start = 0; start < n; start += kBatch) {
+            size_t count = std::min(kBatch, n - start);
+            for (size_t i = 0; i < count; i++) {
+                uint64_t hash = MixedHash(keys[start + i]);
+                fingerprints[i] = Fingerprint(hash);
+                i1s[i] = hash & (buckets_.size() - 1);
+                i2s[i] = AltIndex(i1s[i], fingerprints[i]);
+                __builtin_prefetch(&buckets_[i1s[i]]);
+                __builtin_prefetch(&buckets_[i2s[i]]);
+            }
+            for (size_t i = 0; i < count; i++) {
+                out[start + i] = buckets_[i1s[i]].Contains(fingerprints[i]) ||
+                                 buckets_[i2s[i]].Contains(fingerprints[i]) ||
+                                 VictimMatches(i1s[i], i2s[i], fingerprints[i]);
+            }
+        }
+    }
+
+    size_t MemoryUsage() const { return buckets_.size() * sizeof(Bucket); }
+
+private:
+    // A bucket is four 16-bit slots, 8 bytes in total. 0 marks an empty slot.
+    // 一个桶是四个16位的槽，总共8字节。0表示空槽。
+    struct alignas(8) Bucket {
+        uint16_t slots[4] = {};
+
+        // Compares the fingerprint with all four slots at once by treating
+        // the bucket as one 64-bit word (SIMD within a register): a lane of
+        // x is zero exactly where the slot matches, and the classic "has a
+        // zero lane" bit trick finds such a lane without branches.
+        // 通过把桶视为一个64位的字（寄存器内SIMD），一次性把指纹与全部四个槽进行
+        // 比较：x的某个通道恰好在槽匹配的地方为零，经典的"存在零通道"位技巧可以
+        // 不用分支地找到这样的通道。
+        bool Contains(uint16_t fingerprint) const {
+            uint64_t word;
+            std::memcpy(&word, slots, sizeof(word));
+            uint64_t x = word ^ (fingerprint * 0x0001000100010001ULL);
+            return ((x - 0x0001000100010001ULL) & ~x & 0x8000800080008000ULL) != 0;
+        }
+
+        bool Add(uint16_t fingerprint) {
+            for (uint16_t &slot: slots) {
+                if (slot == 0) {
+                    slot = fingerprint;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool Remove(uint16_t fingerprint) {
+            for (uint16_t &slot: slots) {
+                if (slot == fingerprint) {
+                    slot = 0;
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    // Fingerprints come from the high bits of the hash, the bucket index from
+    // the low bits. 0 is reserved for empty slots.
+    // 指纹来自哈希值的高位，桶下标来自低位。0被保留给空槽。
+    uint16_t Fingerprint(uint64_t hash) const {
+        uint16_t fingerprint = static_cast<uint16_t>(hash >> 48) & fingerprint_mask_;
+        return fingerprint == 0 ? 1 : fingerprint;
+    }
+
+    size_t AltIndex(size_t index, uint16_t fingerprint) const {
+        return (index ^ (fingerprint * 0x5bd1e995u)) & (buckets_.size() - 1);
+    }
+
+    bool VictimMatches(size_t i1, size_t i2, uint16_t fingerprint) const {
+        return has_victim_ && fingerprint == victim_fingerprint_ && (victim_index_ == i1 || victim_index_ == i2);
+    }
+
+    std::vector<Bucket> buckets_;
+    uint16_t fingerprint_mask_;
+    // The one fingerprint that did not fit after a failed kick chain, and one
+    // of its two buckets. Once it is taken, Insert refuses new keys.
+    // 在一次失败的踢出链之后放不下的那一个指纹，以及它的两个桶之一。一旦它被占用，
+    // Insert就会拒绝新的键。
+    bool has_victim_ = false;
+    uint16_t victim_fingerprint_ = 0;
+    size_t victim_index_ = 0;
+    std::mt19937 rng_{445};
+};
+
+// FilteredContainer puts a filter in front of a std::set or std::unordered_map
+// (or anything with the same insert/count/erase interface). Every inserted key
+// is added to the filter, and count only asks the container when the filter
+// says the key may be there. If the filter supports erase, erased keys are
+// removed from it too; otherwise they stay in the filter, which only raises
+// the false positive rate. If the filter fills up, it is rebuilt from the
+// container at twice the size, so it never reports a stored key as absent.
+// FilteredContainer把一个过滤器放在std::set或std::unordered_map（或任何具有
+// 相同insert/count/erase接口的东西）前面。每个插入的键都会被加入过滤器，并且只有
+// 当过滤器说该键可能存在时，count才会去问容器。如果过滤器支持删除，被删除的键
+// 也会从过滤器中移除；否则它们会留在过滤器中，这只会提高假阳性率。如果过滤器满了，
+// 就会按两倍的大小从容器重建它，所以它永远不会把一个已存储的键报告为不存在。
+template<typename Container, typename Filter>
+class FilteredContainer {
+public:
+    using key_type = typename Container::key_type;
+    using value_type = typename Container::value_type;
+
+    FilteredContainer(size_t expected_keys, double false_positive_rate)
+        : expected_keys_(expected_keys), false_positive_rate_(false_positive_rate),
+          filter_(expected_keys, false_positive_rate) {}
+
+    bool insert(const value_type &value) {
+        bool inserted = container_.insert(value).second;
+        if (inserted && !filter_.Insert(KeyOf(value))) {
+            Rebuild();
+        }
+        return inserted;
+    }
+
+    size_t count(const key_type &key) const {
+        if (!filter_.MayContain(key)) {
+            return 0;
+        }
+        return container_.count(key);
+    }
+
+    size_t erase(const key_type &key) {
+        size_t erased = container_.erase(key);
+        if constexpr (Filter::kSupportsErase) {
+            if (erased != 0) {
+                filter_.Erase(key);
+            }
+        }
+        return erased;
+    }
+
+    const Container &container() const { return container_; }
+    const Filter &filter() const { return filter_; }
+
+private:
+    // Doubles the expected size until every key in the container fits.
+    // 把预期大小加倍，直到容器中的每个键都能放下。
+    void Rebuild() {
+        while (true) {
+            expected_keys_ = std::max<size_t>(expected_keys_ * 2, container_.size());
+            Filter filter(expected_keys_, false_positive_rate_);
+            bool fits = true;
+            for (const value_type &value: container_) {
+                if (!filter.Insert(KeyOf(value))) {
+                    fits = false;
+                    break;
+                }
+            }
+            if (fits) {
+                filter_ = std::move(filter);
+                return;
+            }
+        }
+    }
+
+    // Sets store keys directly, maps store key-value pairs.
+    // 集合直接存储键，映射存储键值对。
+    static const key_type &KeyOf(const key_type &key) { return key; }
+    template<typename Value>
+    static const key_type &KeyOf(const std::pair<const key_type, Value> &pair) {
+        return pair.first;
+    }
+
+    size_t expected_keys_;
+    double false_positive_rate_;
+    Container container_;
+    Filter filter_;
+};
+
+// Runs func once and returns how long it took, in milliseconds.
+// 运行func一次并返回它所花的时间，单位为毫秒。
+template<typename Func>
+double TimeMs(Func func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// Measures the false positive rate of a filter with num_keys keys.
+// 测量一个装有num_keys个键的过滤器的假阳性率。
+template<typename Filter>
+void MeasureFalsePositives(const char *name, double target, int num_keys) {
+    Filter filter(num_keys, target);
+    for (int i = 0; i < num_keys; i++) {
+        filter.Insert(i);
+    }
+    const int num_probes = 200000;
+    std::vector<int> probes(num_probes);
+    for (int i = 0; i < num_probes; i++) {
+        probes[i] = num_keys + i;
+    }
+    std::unique_ptr<bool[]> results(new bool[num_probes]);
+    filter.MayContainBatch(probes.data(), num_probes, results.get());
+    size_t false_positives = 0;
+    for (int i = 0; i < num_probes; i++) {
+        false_positives += results[i];
+    }
+    std::cout << "  " << name << " target " << target * 100 << "%: measured "
+              << 100.0 * false_positives / num_probes << "%, " << 8.0 * filter.MemoryUsage() / num_keys
+              << " bits/key\n";
+}
+
+// Times a lookup workload where 90% of the probes are misses.
+// 对一个90%的探测都是未命中的查找负载计时。
+void RunBenchmark() {
+    const int num_keys = 1 << 17;
+    const int num_probes = 1 << 19;
+    std::mt19937 rng(15445);
+    std::vector<int> probes(num_probes);
+    for (int &probe: probes) {
+        // Keys are the even numbers below 2 * num_keys, so odd numbers and
+        // large numbers miss.
+        // 键是小于2 * num_keys的偶数，所以奇数和大数都会未命中。
+        probe = (rng() % 10 == 0) ? 2 * static_cast<int>(rng() % num_keys) : static_cast<int>(rng() | 1);
+    }
+
+    std::set<int> plain;
+    FilteredContainer<std::set<int>, BlockedBloomFilter<int>> bloom_set(num_keys, 0.01);
+    FilteredContainer<std::set<int>, CuckooFilter<int>> cuckoo_set(num_keys, 0.01);
+    for (int i = 0; i < num_keys; i++) {
+        plain.insert(2 * i);
+        bloom_set.insert(2 * i);
+        cuckoo_set.insert(2 * i);
+    }
+
+    size_t hits[3] = {0, 0, 0};
+    double plain_ms = TimeMs([&] {
+        for (int probe: probes) {
+            hits[0] += plain.count(probe);
+        }
+    });
+    double bloom_ms = TimeMs([&] {
+        for (int probe: probes) {
+            hits[1] += bloom_set.count(probe);
+        }
+    });
+    double cuckoo_ms = TimeMs([&] {
+        for (int probe: probes) {
+            hits[2] += cuckoo_set.count(probe);
+        }
+    });
+    std::cout << "Benchmark: " << num_probes << " std::set<int> probes, 90% misses:\n";
+    std::cout << "  std::set:                " << plain_ms << " ms, " << hits[0] << " hits\n";
+    std::cout << "  Bloom filter + std::set:  " << bloom_ms << " ms, " << hits[1] << " hits\n";
+    std::cout << "  cuckoo filter + std::set: " << cuckoo_ms << " ms, " << hits[2] << " hits\n";
+
+    std::cout << "False positive rates with " << num_keys << " keys:\n";
+    MeasureFalsePositives<BlockedBloomFilter<int>>("Bloom ", 0.01, num_keys);
+    MeasureFalsePositives<BlockedBloomFilter<int>>("Bloom ", 0.001, num_keys);
+    MeasureFalsePositives<CuckooFilter<int>>("cuckoo", 0.01, num_keys);
+    MeasureFalsePositives<CuckooFilter<int>>("cuckoo", 0.001, num_keys);
+}
+
+int main() {
+    // A set with a Bloom filter in front, used like the set in sets.cpp.
+    // 一个前面放了布隆过滤器的集合，用法与sets.cpp中的集合一样。
+    FilteredContainer<std::set<int>, BlockedBloomFilter<int>> int_set(100, 0.01);
+    for (int i = 1; i <= 10; ++i) {
+        int_set.insert(i);
+    }
+    if (int_set.count(11) == 0) {
+        std::cout << "Element 11 is not in the set.\n";
+    }
+    if (int_set.count(3) == 1) {
+        std::cout << "Element 3 is in the set.\n";
+    }
+
+    // A map with a cuckoo filter in front, used like the map in
+    // unordered_maps.cpp. Since the cuckoo filter supports deletes, erasing
+    // "eggs" also removes it from the filter.
+    // 一个前面放了布谷鸟过滤器的映射，用法与unordered_maps.cpp中的映射一样。由于
+    // 布谷鸟过滤器支持删除，删除"eggs"也会把它从过滤器中移除。
+    FilteredContainer<std::unordered_map<std::string, int>, CuckooFilter<std::string>> map(100, 0.01);
+    map.insert({"foo", 2});
+    map.insert({"spam", 1});
+    map.insert({"eggs", 2});
+    map.erase("eggs");
+    if (map.count("eggs") == 0) {
+        std::cout << "Key-value pair with key eggs does not exist in the unordered map.\n";
+    }
+    if (!map.filter().MayContain("eggs")) {
+        std::cout << "The cuckoo filter answered the eggs probe on its own.\n";
+    }
+    if (map.count("spam") == 1) {
+        std::cout << "A key-value pair with key spam exists in the unordered map.\n";
+    }
+
+    RunBenchmark();
+
+    return 0;
+}
@@ -0,0 +1,548 @@
+/**
+ * @file perfect_hash_map.cpp
+ * @brief Tutorial code for read-only maps built on a minimal perfect hash.
+ * @brief 基于最小完美哈希的只读映射的教程代码。
+ */
+
+// Many maps are filled once, for example from a config file or a list of SQL
+// keywords, and then only read. A std::unordered_map (unordered_maps.cpp) does
+// not know that: every lookup walks a bucket chain, and the table keeps spare
+// buckets and per-node pointers around for inserts that never come.
+// 许多映射只被填充一次，例如从配置文件或者SQL关键字列表中填充，之后就只被读取。
+// std::unordered_map（unordered_maps.cpp）并不知道这一点：每次查找都要遍历一条桶
+// 链，而且表会为永远不会到来的插入保留空闲的桶和每个节点的指针。
+
+// When all keys are known up front, we can instead find a "perfect" hash
+// function that sends each of the n keys to its own slot in an array of
+// exactly n slots ("minimal"). A lookup then computes the slot and does a
+// single key comparison: there are no collisions to resolve.
+// 当所有的键都预先已知时，我们可以改为寻找一个"完美"哈希函数，它把n个键中的每一个
+// 都送到一个恰好有n个槽的数组（"最小"）中属于它自己的槽里。这样一次查找只需要计算
+// 出槽并做一次键比较：没有需要解决的冲突。
+
+// We use the CHD ("compress, hash, displace") algorithm of Belazzougui,
+// Botelho and Dietzfelbinger:
+//   1. Split the keys into about n / 4 small buckets by one hash.
+//   2. Handle the buckets from largest to smallest. For each bucket, try
+//      displacements d = 0, 1, 2, ... until the hash Slot(key, d) sends every
+//      key of the bucket to a slot that is still free, then take those slots.
+//   3. Store d for every bucket. A lookup computes
+//      Slot(key, displacement[Bucket(key)]).
+// Most displacements are small, so they are stored in 16 bits, which is half
+// a byte per key and small enough to stay in the cache; the few large ones
+// live in a short overflow list. For a big table the only access that misses
+// is then the slot itself.
+// 我们使用Belazzougui、Botelho和Dietzfelbinger的CHD（"压缩、哈希、置换"）算法：
+//   1. 用一个哈希把键分到大约n / 4个小桶中。
+//   2. 从大到小处理这些桶。对每个桶，依次尝试置换值d = 0, 1, 2, ...，直到哈希
+//      Slot(key, d)把桶中每个键都送到一个仍然空闲的槽中，然后占用这些槽。
+//   3. 为每个桶存储d。查找时计算Slot(key, displacement[Bucket(key)])。
+// 大多数置换值都很小，所以它们用16位存储，即每个键半个字节，小到足以留在缓存中；
+// 少数很大的置换值放在一个很短的溢出列表里。这样对大表来说唯一会缓存未命中的访问
+// 就是槽本身。
+
+// Includes std::lower_bound.
+// 包含std::lower_bound。
+#include <algorithm>
+// Includes std::array, used by the compile-time map.
+// 包含std::array，供编译期映射使用。
+#include <array>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as uint64_t.
+// 包含uint64_t等定宽整数类型。
+#include <cstdint>
+// Includes std::equal_to and std::hash.
+// 包含std::equal_to和std::hash。
+#include <functional>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes std::allocator.
+// 包含std::allocator。
+#include <memory>
+// Includes std::invalid_argument and std::runtime_error.
+// 包含std::invalid_argument和std::runtime_error。
+#include <stdexcept>
+// Includes the C++ string library.
+// 包含C++字符串库。
+#include <string>
+// Includes std::string_view.
+// 包含std::string_view。
+#include <string_view>
+// Includes std::enable_if_t and std::is_integral.
+// 包含std::enable_if_t和std::is_integral。
+#include <type_traits>
+// Includes the unordered_map container library header, for comparison.
+// 包含unordered_map容器库头文件，用于对比。
+#include <unordered_map>
+// Includes std::pair and std::move.
+// 包含std::pair和std::move。
+#include <utility>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+
+// std::hash cannot run at compile time, so both maps use this hash: 64-bit
+// FNV-1a for strings and a MurmurHash3 finalizer for integers. Using the same
+// function everywhere means a table built at compile time agrees with one
+// built at run time.
+// std::hash不能在编译期运行，所以两种映射都使用这个哈希：字符串用64位FNV-1a，整数用
+// MurmurHash3的最终混合函数。在所有地方使用同一个函数意味着在编译期构建的表与在
+// 运行时构建的表是一致的。
+struct PerfectHash {
+    constexpr uint64_t operator()(std::string_view s) const {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (char c: s) {
+            h = (h ^ static_cast<uint8_t>(c)) * 0x100000001b3ULL;
+        }
+        return Mix(h);
+    }
+
+    template<typename T, std::enable_if_t<std::is_integral<T>::value, int> = 0>
+    constexpr uint64_t operator()(T x) const {
+        return Mix(static_cast<uint64_t>(x));
+    }
+
+    static constexpr uint64_t Mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+// Maps the top 32 bits of hash to one of num_buckets buckets. Multiplying and
+// keeping the high half avoids a division ("fast range").
+// 把hash的高32位映射到num_buckets个桶中的一个。相乘并保留高半部分可以避免一次除法
+// （"快速区间映射"）。
+constexpr uint32_t BucketOf(uint64_t hash, size_t num_buckets) {
+    return static_cast<uint32_t>(((hash >> 32) * num_buckets) >> 32);
+}
+
+// Maps hash, perturbed by the bucket's displacement and the table's seed, to
+// one of num_slots slots. hash is already well mixed, so one multiplication
+// is enough to spread the low bits, which pick the slot, into the high half.
+// 把经过桶的置换值和表的种子扰动后的hash映射到num_slots个槽中的一个。hash已经被
+// 充分混合过了，所以一次乘法就足以把决定槽的低位扩散到高半部分。
+constexpr uint32_t SlotOf(uint64_t hash, uint32_t displacement, uint32_t seed, size_t num_slots) {
+    uint64_t h = (hash ^ ((uint64_t{seed} << 32 | displacement) * 0x9e3779b97f4a7c15ULL)) * 0xbf58476d1ce4e5b9ULL;
+    return static_cast<uint32_t>(((h >> 32) * num_slots) >> 32);
+}
+
+// About four keys per bucket keeps the displacement array small while the
+// search for displacements stays fast.
+// 每个桶大约四个键，既能让置换数组保持很小，又能让置换值的搜索保持很快。
+constexpr size_t NumBuckets(size_t num_keys) { return (num_keys + 3) / 4; }
+
+// The outcome of one attempt to build a perfect hash function.
+// 一次构建完美哈希函数的尝试的结果。
+enum class BuildResult { kOk, kDuplicateHashes, kGaveUp };
+
+// Runs CHD on the hashes of n keys with the given seed. On success,
+// displacements[b] holds the displacement of bucket b and slot_of[i] the slot
+// of key i. Returns kDuplicateHashes if two keys have the same hash (usually
+// because they are equal), since no displacement can separate them. Returns
+// kGaveUp if some bucket found no free slots within 16 * n + 65536 tries;
+// the caller then tries again with another seed.
+//
+// The function is constexpr and takes its arrays as template parameters, so
+// the run-time map calls it with std::vectors and the compile-time map with
+// std::arrays. Every array must have room for n + 1 entries; C++17 has no
+// memory allocation at compile time, so the scratch space comes from the
+// caller too.
+// 用给定的种子对n个键的哈希值运行CHD。成功时，displacements[b]保存桶b的置换值，
+// slot_of[i]保存键i的槽。如果两个键的哈希值相同（通常是因为它们相等），则返回
+// kDuplicateHashes，因为任何置换值都无法把它们分开。如果某个桶在16 * n + 65536次
+// 尝试内都没有找到空闲的槽，则返回kGaveUp；调用者随后用另一个种子重试。
+//
+// 这个函数是constexpr的，并把它的数组作为模板参数，所以运行时映射用std::vector
+// 调用它，而编译期映射用std::array调用它。每个数组都必须能容纳n + 1个项；C++17
+// 在编译期不能分配内存，所以临时空间也由调用者提供。
+template<typename HashArray, typename IndexArray>
+constexpr BuildResult BuildPerfectHash(const HashArray &hashes, size_t n, uint32_t seed, IndexArray &displacements,
+                                       IndexArray &slot_of, IndexArray &bucket_start, IndexArray &members,
+                                       IndexArray &taken) {
+    size_t num_buckets = NumBuckets(n);
+    // The last buckets are placed when only a few slots are still free, so
+    // they need about n tries. The limit also stops d from wrapping around.
+    // 最后的那些桶被放置时只剩下很少的空闲槽，所以它们需要大约n次尝试。这个上限
+    // 也能防止d回绕。
+    const uint64_t max_tries = std::min<uint64_t>(16 * uint64_t{n} + 65536, UINT32_MAX);
+
+    // Group the keys by bucket with a counting sort: members holds the keys
+    // of bucket b at positions bucket_start[b] to bucket_start[b + 1].
+    // 用计数排序按桶对键分组：members在位置bucket_start[b]到bucket_start[b + 1]处
+    // 保存桶b的键。
+    for (size_t b = 0; b <= num_buckets; b++) {
+        bucket_start[b] = 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        bucket_start[BucketOf(hashes[i], num_buckets) + 1]++;
+    }
+    uint32_t max_size = 0;
+    for (size_t b = 0; b < num_buckets; b++) {
+        max_size = max_size > bucket_start[b + 1] ? max_size : bucket_start[b + 1];
+        bucket_start[b + 1] += bucket_start[b];
+    }
+    for (size_t i = 0; i < n; i++) {
+        taken[i] = 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        uint32_t b = BucketOf(hashes[i], num_buckets);
+        members[bucket_start[b] + taken[b]++] = static_cast<uint32_t>(i);
+    }
+    for (size_t i = 0; i < n; i++) {
+        taken[i] = 0;
+    }
+
+    // Place the largest buckets first, while most slots are still free.
+    // 先放置最大的桶，这时大多数槽仍然是空闲的。
+    for (uint32_t size = max_size; size > 0; size--) {
+        for (size_t b = 0; b < num_buckets; b++) {
+            uint32_t begin = bucket_start[b];
+            uint32_t end = bucket_start[b + 1];
+            if (end - begin != size) {
+                continue;
+            }
+            for (uint32_t i = begin; i < end; i++) {
+                for (uint32_t j = begin; j < i; j++) {
+                    if (hashes[members[i]] == hashes[members[j]]) {
+                        return BuildResult::kDuplicateHashes;
+                    }
+                }
+            }
+            for (uint32_t d = 0;; d++) {
+                if (d == max_tries) {
+                    return BuildResult::kGaveUp;
+                }
+                // Claim slots one key at a time, and give them back if a later
+                // key of the bucket collides.
+                // 一次为一个键占用槽，如果桶中后面的键发生冲突，就把它们还回去。
+                uint32_t placed = begin;
+                while (placed < end) {
+                    uint32_t slot = SlotOf(hashes[members[placed]], d, seed, n);
+                    if (taken[slot] != 0) {
+                        break;
+                    }
+                    taken[slot] = 1;
+                    slot_of[members[placed]] = slot;
+                    placed++;
+                }
+                if (placed == end) {
+                    displacements[b] = d;
+                    break;
+                }
+                for (uint32_t i = begin; i < placed; i++) {
+                    taken[slot_of[members[i]]] = 0;
+                }
+            }
+        }
+    }
+    return BuildResult::kOk;
+}
+
+// The number of seeds a map tries before giving up. A failure needs a bucket
+// that collides for millions of displacements, so a second seed is already
+// very unlikely to be needed.
+// 映射在放弃之前尝试的种子数量。失败需要一个桶在数百万个置换值下都发生冲突，所以
+// 已经很不可能需要第二个种子了。
+constexpr uint32_t kMaxSeeds = 8;
+
+// PerfectHashMap is built once from all of its pairs, and then only supports
+// lookups and iteration. It stores exactly n pairs, n / 4 16-bit
+// displacements and the overflow list.
+// PerfectHashMap从它的所有键值对一次性构建，之后只支持查找和遍历。它恰好存储n个
+// 键值对、n / 4个16位置换值以及溢出列表。
+template<typename Key, typename Value, typename Hash = PerfectHash>
+class PerfectHashMap {
+public:
+    using value_type = std::pair<Key, Value>;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    // Builds the map. Throws std::invalid_argument if two keys are equal or
+    // have the same 64-bit hash, and std::runtime_error if no seed works.
+    // 构建映射。如果两个键相等或者具有相同的64位哈希值，则抛出std::invalid_argument；
+    // 如果没有任何种子可行，则抛出std::runtime_error。
+    explicit PerfectHashMap(std::vector<value_type> pairs) {
+        size_t n = pairs.size();
+        std::vector<uint64_t> hashes(n);
+        for (size_t i = 0; i < n; i++) {
+            hashes[i] = hasher_(pairs[i].first);
+        }
+        std::vector<uint32_t> displacements(n + 1);
+        std::vector<uint32_t> slot_of(n + 1);
+        std::vector<uint32_t> bucket_start(n + 1);
+        std::vector<uint32_t> members(n + 1);
+        std::vector<uint32_t> taken(n + 1);
+        BuildResult result = BuildResult::kGaveUp;
+        for (seed_ = 0; seed_ < kMaxSeeds && result == BuildResult::kGaveUp; seed_++) {
+            result = BuildPerfectHash(hashes, n, seed_, displacements, slot_of, bucket_start, members, taken);
+        }
+        seed_--;
+        if (result == BuildResult::kDuplicateHashes) {
+            throw std::invalid_argument("PerfectHashMap keys must be distinct");
+        }
+        if (result == BuildResult::kGaveUp) {
+            throw std::runtime_error("PerfectHashMap found no perfect hash function");
+        }
+
+        displacements_.resize(NumBuckets(n));
+        for (size_t b = 0; b < displacements_.size(); b++) {
+            if (displacements[b] < kOverflow) {
+                displacements_[b] = static_cast<uint16_t>(displacements[b]);
+            } else {
+                displacements_[b] = kOverflow;
+                overflow_.emplace_back(static_cast<uint32_t>(b), displacements[b]);
+            }
+        }
+        slots_.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            slots_[slot_of[i]] = std::move(pairs[i]);
+        }
+    }
+
+    const_iterator begin() const { return slots_.begin(); }
+    const_iterator end() const { return slots_.end(); }
+
+    size_t size() const { return slots_.size(); }
+    bool empty() const { return slots_.empty(); }
+
+    // A perfect hash sends keys that are not in the map to some slot too, so
+    // we still compare the key once.
+    // 完美哈希也会把不在映射中的键送到某个槽，所以我们仍然要比较一次键。
+    const_iterator find(const Key &key) const {
+        if (slots_.empty()) {
+            return end();
+        }
+        uint64_t hash = hasher_(key);
+        uint32_t slot = SlotOf(hash, Displacement(BucketOf(hash, displacements_.size())), seed_, slots_.size());
+        return slots_[slot].first == key ? begin() + slot : end();
+    }
+
+    size_t count(const Key &key) const { return find(key) == end() ? 0 : 1; }
+
+    size_t MemoryUsage() const {
+        return slots_.size() * sizeof(value_type) + displacements_.size() * sizeof(uint16_t) +
+               overflow_.size() * sizeof(overflow_[0]);
+    }
+
+private:
+    // Displacements of kOverflow or more are looked up in overflow_, which is
+    // sorted by bucket. Only the last few buckets to be placed end up there.
+    // 大于等于kOverflow的置换值要在overflow_中查找，它按桶排序。只有最后被放置的
+    // 少数几个桶会进入那里。
+    static constexpr uint16_t kOverflow = 0xffff;
+
+    uint32_t Displacement(uint32_t bucket) const {
+        uint16_t displacement = displacements_[bucket];
+        if (displacement != kOverflow) {
+            return displacement;
+        }
+        auto it = std::lower_bound(overflow_.begin(), overflow_.end(), std::make_pair(bucket, uint32_t{0}));
+        return it->second;
+    }
+
+    Hash hasher_;
+    uint32_t seed_ = 0;
+    std::vector<uint16_t> displacements_;
+    std::vector<std::pair<uint32_t, uint32_t>> overflow_;
+    std::vector<value_type> slots_;
+};
+
+// The compile-time variant, for maps from string literals to values. A
+// constexpr StaticPerfectHashMap is built entirely by the compiler and lives
+// in the read-only data of the program, so it costs nothing at startup. These
+// tables are small, so they keep plain 32-bit displacements.
+// 编译期变体，用于从字符串字面量到值的映射。一个constexpr的StaticPerfectHashMap完全
+// 由编译器构建，并存放在程序的只读数据中，所以在启动时没有任何开销。这些表很小，
+// 所以它们直接保存32位的置换值。
+template<typename Value>
+struct StaticEntry {
+    std::string_view key;
+    Value value;
+};
+
+template<typename Value, size_t N>
+class StaticPerfectHashMap {
+public:
+    constexpr explicit StaticPerfectHashMap(const StaticEntry<Value> (&entries)[N]) {
+        std::array<uint64_t, N + 1> hashes{};
+        for (size_t i = 0; i < N; i++) {
+            hashes[i] = PerfectHash()(entries[i].key);
+        }
+        std::array<uint32_t, N + 1> displacements{};
+        std::array<uint32_t, N + 1> slot_of{};
+        std::array<uint32_t, N + 1> bucket_start{};
+        std::array<uint32_t, N + 1> members{};
+        std::array<uint32_t, N + 1> taken{};
+        // Throwing in a constant expression is a compile error, which is what
+        // we want for duplicate keys.
+        // 在常量表达式中抛出异常是一个编译错误，这正是我们对重复键想要的效果。
+        BuildResult result = BuildResult::kGaveUp;
+        for (seed_ = 0; seed_ < kMaxSeeds && result == BuildResult::kGaveUp; seed_++) {
+            result = BuildPerfectHash(hashes, N, seed_, displacements, slot_of, bucket_start, members, taken);
+        }
+        seed_--;
+        if (result == BuildResult::kDuplicateHashes) {
+            throw std::invalid_argument("StaticPerfectHashMap keys must be distinct");
+        }
+        if (result == BuildResult::kGaveUp) {
+            throw std::runtime_error("StaticPerfectHashMap found no perfect hash function");
+        }
+        for (size_t b = 0; b < NumBuckets(N); b++) {
+            displacements_[b] = displacements[b];
+        }
+        for (size_t i = 0; i < N; i++) {
+            slots_[slot_of[i]] = entries[i];
+        }
+    }
+
+    constexpr size_t size() const { return N; }
+
+    // Returns a pointer to the value for key, or nullptr if key is absent.
+    // 返回指向key对应值的指针，如果key不存在则返回nullptr。
+    constexpr const Value *find(std::string_view key) const {
+        uint64_t hash = PerfectHash()(key);
+        uint32_t slot = SlotOf(hash, displacements_[BucketOf(hash, NumBuckets(N))], seed_, N);
+        return slots_[slot].key == key ? &slots_[slot].value : nullptr;
+    }
+
+    constexpr size_t count(std::string_view key) const { return find(key) == nullptr ? 0 : 1; }
+
+private:
+    uint32_t seed_ = 0;
+    std::array<uint32_t, NumBuckets(N)> displacements_{};
+    std::array<StaticEntry<Value>, N> slots_{};
+};
+
+// Deduces N from the number of entries, so callers only name the value type.
+// 从项的数量推导出N，这样调用者只需要写出值的类型。
+template<typename Value, size_t N>
+constexpr StaticPerfectHashMap<Value, N> MakeStaticPerfectHashMap(const StaticEntry<Value> (&entries)[N]) {
+    return StaticPerfectHashMap<Value, N>(entries);
+}
+
+// Built at compile time. The static_asserts below are checked by the compiler,
+// which proves that no run-time code is involved.
+// 在编译期构建。下面的static_assert由编译器检查，这证明了不涉及任何运行时代码。
+constexpr auto kKeywords = MakeStaticPerfectHashMap<int>({{"select", 1}, {"from", 2}, {"where", 3}, {"group", 4},
+                                                          {"by", 5}, {"order", 6}, {"limit", 7}, {"join", 8}});
+static_assert(*kKeywords.find("where") == 3, "where is keyword 3");
+static_assert(kKeywords.find("having") == nullptr, "having is not in the table");
+
+// CountingAllocator is the one from flat_set.cpp. It adds every allocation to
+// a global byte counter, so we can measure the memory of std::unordered_map.
+// CountingAllocator就是flat_set.cpp中的那个。它会把每次分配的字节数累加到一个全局
+// 计数器中，这样我们就能测量std::unordered_map占用的内存。
+size_t allocated_bytes = 0;
+
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        allocated_bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T *p, size_t n) {
+        allocated_bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const CountingAllocator<U> &) const { return true; }
+    template<typename U>
+    bool operator!=(const CountingAllocator<U> &) const { return false; }
+};
+
+// Compares building and probing a 1M-key PerfectHashMap with a
+// std::unordered_map holding the same pairs.
+// 比较构建和探测一个1M个键的PerfectHashMap与一个保存相同键值对的std::unordered_map。
+void RunBenchmark() {
+    constexpr size_t kNumKeys = 1'000'000;
+    std::vector<std::pair<uint64_t, uint64_t>> pairs;
+    for (uint64_t i = 0; i < kNumKeys; i++) {
+        pairs.emplace_back(i * 0x9e3779b97f4a7c15ULL, i);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    PerfectHashMap<uint64_t, uint64_t> perfect_map(pairs);
+    auto middle = std::chrono::steady_clock::now();
+    std::unordered_map<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                       CountingAllocator<std::pair<const uint64_t, uint64_t>>>
+            std_map(pairs.begin(), pairs.end());
+    auto stop = std::chrono::steady_clock::now();
+    std::cout << "Build ms: PerfectHashMap " << std::chrono::duration<double, std::milli>(middle - start).count()
+              << ", std::unordered_map " << std::chrono::duration<double, std::milli>(stop - middle).count() << "\n";
+    std::cout << "PerfectHashMap bytes/key: " << static_cast<double>(perfect_map.MemoryUsage()) / kNumKeys
+              << ", std::unordered_map " << static_cast<double>(allocated_bytes) / kNumKeys
+              << " (before malloc overhead)\n";
+
+    uint64_t sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kNumKeys; i++) {
+        sum += perfect_map.find(pairs[(i * 7919) % kNumKeys].first)->second;
+    }
+    middle = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kNumKeys; i++) {
+        sum -= std_map.find(pairs[(i * 7919) % kNumKeys].first)->second;
+    }
+    stop = std::chrono::steady_clock::now();
+    std::cout << "Lookup ns/op: PerfectHashMap "
+              << std::chrono::duration<double, std::nano>(middle - start).count() / kNumKeys
+              << ", std::unordered_map " << std::chrono::duration<double, std::nano>(stop - middle).count() / kNumKeys
+              << "\n";
+    if (sum != 0) {
+        std::cout << "The maps disagree!\n";
+    }
+}
+
+int main() {
+    // A PerfectHashMap is built from all of its pairs at once.
+    // PerfectHashMap一次性从它的所有键值对构建。
+    PerfectHashMap<std::string, int> map(
+            {{"foo", 2}, {"jignesh", 445}, {"spam", 1}, {"eggs", 2}, {"garlic rice", 3}, {"bacon", 5}});
+
+    PerfectHashMap<std::string, int>::const_iterator result = map.find("jignesh");
+    if (result != map.end()) {
+        std::cout << "Found key " << result->first << " with value " << result->second << std::endl;
+    }
+    if (map.count("tofu") == 0) {
+        std::cout << "Key tofu does not exist in the map.\n";
+    }
+
+    // The slots hold exactly one pair each, in hash order.
+    // 每个槽恰好保存一个键值对，按哈希顺序排列。
+    std::cout << "Printing the " << map.size() << " elements of the map:\n";
+    for (const std::pair<std::string, int> &elem: map) {
+        std::cout << "(" << elem.first << ", " << elem.second << "), ";
+    }
+    std::cout << "\n";
+
+    try {
+        PerfectHashMap<std::string, int> duplicates({{"spam", 1}, {"spam", 2}});
+    } catch (const std::invalid_argument &e) {
+        std::cout << "Building a map with duplicate keys failed: " << e.what() << "\n";
+    }
+
+    // kKeywords was built by the compiler. Lookups can also run at compile
+    // time, as in the static_asserts above, or at run time as usual.
+    // kKeywords是由编译器构建的。查找也可以在编译期运行（如上面的static_assert），
+    // 或者像往常一样在运行时运行。
+    std::string word = "order";
+    if (const int *id = kKeywords.find(word)) {
+        std::cout << "Keyword " << word << " has ID " << *id << " in a table of " << kKeywords.size() << ".\n";
+    }
+
+    RunBenchmark();
+
+    return 0;
+}
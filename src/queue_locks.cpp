@@ -0,0 +1,340 @@
+/**
+ * @file queue_locks.cpp
+ * @brief Tutorial code for the MCS and CLH queue locks.
+ * @brief MCS和CLH队列锁的教程代码。
+ */
+
+// When many threads lock the same std::mutex, as in scoped_lock.cpp scaled up
+// to dozens of threads, they all read and write one lock word. Every attempt
+// to take the lock pulls that word's cache line to the attempting core, so
+// the line bounces between cores and throughput drops as threads are added.
+// The lock is also unfair: whichever thread happens to win the race gets the
+// lock, and an unlucky thread can wait for a long time.
+// 当许多线程锁住同一个std::mutex时（比如把scoped_lock.cpp扩大到几十个线程），它们
+// 都在读写同一个锁字。每次尝试获取锁都会把这个字所在的缓存行拉到尝试的核心上，所以
+// 缓存行在核心之间来回传递，吞吐量随着线程的增加而下降。这个锁也是不公平的：碰巧
+// 赢得竞争的线程获得锁，而一个不走运的线程可能要等很长时间。
+
+// Queue locks line the waiting threads up in a linked list, in arrival order.
+// Each waiter spins on a flag in its own list node, on its own cache line, and
+// the thread releasing the lock flips only its successor's flag. Taking the
+// lock touches the shared tail pointer exactly once, and the lock is handed
+// over in FIFO order, so every waiter gets its turn.
+// 队列锁把等待的线程按到达顺序排成一个链表。每个等待者在它自己的链表节点中、在它
+// 自己的缓存行上的一个标志上自旋，释放锁的线程只翻转它后继者的标志。获取锁只会访问
+// 共享的尾指针一次，并且锁按先进先出的顺序交接，所以每个等待者都会轮到。
+
+// The MCS lock (Mellor-Crummey and Scott) spins on the waiter's own node and
+// needs the releasing thread to find its successor through a next pointer.
+// The CLH lock (Craig, Landin and Hagersten) spins on the predecessor's node
+// instead, so it needs no next pointer, and after unlocking a thread takes
+// over its predecessor's node for later use.
+// MCS锁（Mellor-Crummey和Scott）在等待者自己的节点上自旋，并且需要释放锁的线程通过
+// next指针找到它的后继者。CLH锁（Craig、Landin和Hagersten）则在前驱的节点上自旋，
+// 所以它不需要next指针，并且线程在解锁之后会接管它前驱的节点以供以后使用。
+
+// Includes std::atomic.
+// 包含std::atomic。
+#include <atomic>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as uint64_t.
+// 包含uint64_t等定宽整数类型。
+#include <cstdint>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes the mutex library header.
+// 包含互斥锁库头文件。
+#include <mutex>
+// Includes the C++ string library.
+// 包含C++字符串库。
+#include <string>
+// Includes the thread library header.
+// 包含线程库头文件。
+#include <thread>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+
+// The size of a cache line on x86 and most ARM cores. C++17 has
+// std::hardware_destructive_interference_size for this, but not every
+// compiler provides it yet.
+// x86和大多数ARM核心上缓存行的大小。C++17为此提供了
+// std::hardware_destructive_interference_size，但并不是每个编译器都已经支持它。
+constexpr size_t kCacheLineSize = 64;
+
+// Tells the CPU that this is a spin-wait loop (see adaptive_mutex.cpp).
+// 告诉CPU这是一个自旋等待循环（参见adaptive_mutex.cpp）。
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Spins until done() returns true. A FIFO lock must hand the lock to the next
+// waiter even if that thread is not running right now, and then everyone
+// waits until the scheduler runs it again. After a short spin we therefore
+// yield the CPU, so that with more threads than cores the waiter next in line
+// gets a chance to run.
+// 自旋直到done()返回true。先进先出的锁必须把锁交给下一个等待者，即使那个线程此刻
+// 没有在运行，然后所有线程都要等到调度器再次运行它。因此在短暂的自旋之后我们会让出
+// CPU，这样当线程多于核心时，排在下一个的等待者也有机会运行。
+template<typename Done>
+void SpinUntil(Done done) {
+    constexpr int kSpinsBeforeYield = 128;
+    for (int spins = 0; !done(); spins++) {
+        if (spins < kSpinsBeforeYield) {
+            CpuRelax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Queue locks need one list node per waiting thread. To keep lock() and
+// unlock() argument-free (so that std::scoped_lock works), each thread keeps a
+// free list of nodes, and a lock takes its node from there. After warm-up no
+// lock call allocates memory. The nodes left on a thread's list are deleted
+// when the thread exits.
+// 队列锁需要每个等待的线程一个链表节点。为了让lock()和unlock()不需要参数（这样
+// std::scoped_lock才能使用），每个线程保留一个节点的空闲链表，锁从那里取节点。
+// 预热之后，任何加锁调用都不会分配内存。线程退出时，留在它链表上的节点会被删除。
+template<typename Node>
+class ThreadNodePool {
+public:
+    static Node *Get() {
+        std::vector<Node *> &free_nodes = FreeNodes();
+        if (free_nodes.empty()) {
+            return new Node;
+        }
+        Node *node = free_nodes.back();
+        free_nodes.pop_back();
+        return node;
+    }
+
+    static void Put(Node *node) { FreeNodes().push_back(node); }
+
+private:
+    struct FreeList {
+        ~FreeList() {
+            for (Node *node: nodes) {
+                delete node;
+            }
+        }
+        std::vector<Node *> nodes;
+    };
+
+    static std::vector<Node *> &FreeNodes() {
+        thread_local FreeList free_list;
+        return free_list.nodes;
+    }
+};
+
+// McsLock satisfies BasicLockable, so std::scoped_lock, std::unique_lock and
+// std::lock_guard can hold it.
+// McsLock满足BasicLockable，所以std::scoped_lock、std::unique_lock和
+// std::lock_guard都可以持有它。
+class McsLock {
+public:
+    McsLock() = default;
+    McsLock(const McsLock &) = delete;
+    McsLock &operator=(const McsLock &) = delete;
+
+    void lock() {
+        Node *node = ThreadNodePool<Node>::Get();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->locked.store(true, std::memory_order_relaxed);
+        // Swapping ourselves in as the tail is the only write to shared
+        // state. If there was a previous tail, we link ourselves behind it and
+        // wait until it hands the lock to us.
+        // 把自己交换为尾节点是唯一一次对共享状态的写入。如果原来有尾节点，我们就把自己
+        // 链接到它后面，并等待它把锁交给我们。
+        Node *pred = tail_.exchange(node, std::memory_order_acq_rel);
+        if (pred != nullptr) {
+            pred->next.store(node, std::memory_order_release);
+            SpinUntil([node] { return !node->locked.load(std::memory_order_acquire); });
+        }
+        holder_ = node;
+    }
+
+    void unlock() {
+        Node *node = holder_;
+        Node *succ = node->next.load(std::memory_order_acquire);
+        if (succ == nullptr) {
+            // No successor has linked itself yet. If we are still the tail,
+            // nobody is waiting and the lock becomes free. Otherwise a thread
+            // has swapped itself in but not set our next pointer yet, so we
+            // wait for it.
+            // 还没有后继者把自己链接进来。如果我们仍然是尾节点，就没有人在等待，锁变为
+            // 空闲。否则有一个线程已经把自己交换进来，但还没有设置我们的next指针，所以
+            // 我们等待它。
+            Node *expected = node;
+            if (tail_.compare_exchange_strong(expected, nullptr, std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+                ThreadNodePool<Node>::Put(node);
+                return;
+            }
+            SpinUntil([node, &succ] { return (succ = node->next.load(std::memory_order_acquire)) != nullptr; });
+        }
+        succ->locked.store(false, std::memory_order_release);
+        ThreadNodePool<Node>::Put(node);
+    }
+
+private:
+    // Each node fills a whole cache line, so that a waiter spinning on its
+    // flag shares its cache line with nobody.
+    // 每个节点占满一整个缓存行，这样在自己的标志上自旋的等待者不会与任何人共享缓存行。
+    struct alignas(kCacheLineSize) Node {
+        std::atomic<Node *> next{nullptr};
+        std::atomic<bool> locked{false};
+    };
+
+    alignas(kCacheLineSize) std::atomic<Node *> tail_{nullptr};
+    // Only the thread holding the lock reads or writes holder_, so the lock
+    // itself protects it.
+    // 只有持有锁的线程才会读写holder_，所以锁本身保护着它。
+    Node *holder_ = nullptr;
+};
+
+// ClhLock satisfies BasicLockable as well. The queue always ends in a node,
+// starting with one unlocked node owned by the lock, so a thread always has a
+// predecessor to spin on.
+// ClhLock同样满足BasicLockable。队列总是以一个节点结尾，最初是锁自己拥有的一个
+// 未锁定节点，所以线程总有一个前驱可以在上面自旋。
+class ClhLock {
+public:
+    ClhLock() : tail_(new Node) {}
+    ClhLock(const ClhLock &) = delete;
+    ClhLock &operator=(const ClhLock &) = delete;
+
+    // The tail node is no longer referenced by any thread once the lock is
+    // free.
+    // 一旦锁空闲，尾节点就不再被任何线程引用。
+    ~ClhLock() { delete tail_.load(std::memory_order_relaxed); }
+
+    void lock() {
+        Node *node = ThreadNodePool<Node>::Get();
+        node->locked.store(true, std::memory_order_relaxed);
+        Node *pred = tail_.exchange(node, std::memory_order_acq_rel);
+        SpinUntil([pred] { return !pred->locked.load(std::memory_order_acquire); });
+        holder_ = node;
+        holder_pred_ = pred;
+    }
+
+    // Clearing our flag releases the lock to our successor, which spins on
+    // our node from now on. Our predecessor's node, however, nobody looks at
+    // any more, so we take it as our own.
+    // 清除我们的标志就把锁释放给了后继者，从现在起它在我们的节点上自旋。而我们前驱的
+    // 节点已经没有人再看了，所以我们把它拿来作为自己的节点。
+    void unlock() {
+        Node *pred = holder_pred_;
+        holder_->locked.store(false, std::memory_order_release);
+        ThreadNodePool<Node>::Put(pred);
+    }
+
+private:
+    struct alignas(kCacheLineSize) Node {
+        std::atomic<bool> locked{false};
+    };
+
+    alignas(kCacheLineSize) std::atomic<Node *> tail_;
+    Node *holder_ = nullptr;
+    Node *holder_pred_ = nullptr;
+};
+
+// Defining a global count variable and an MCS lock to be used by both
+// threads, as in scoped_lock.cpp.
+// 与scoped_lock.cpp中一样，定义一个全局计数变量和一个MCS锁，供两个线程使用。
+int count = 0;
+McsLock m;
+
+// The add_count function is the one from scoped_lock.cpp, with m now an MCS
+// lock.
+// add_count函数就是scoped_lock.cpp中的那个，只是m现在是一个MCS锁。
+void add_count() {
+    std::scoped_lock slk(m);
+    count += 1;
+}
+
+// Runs num_threads threads that lock the same lock in a loop for duration_ms,
+// each incrementing a shared counter and its own tally. Prints throughput and
+// Jain's fairness index over the per-thread tallies: 1 means every thread got
+// the lock equally often, and 1 / num_threads means one thread got it every
+// time.
+// 运行num_threads个线程，它们在duration_ms时间内循环锁住同一个锁，每次增加一个共享
+// 计数器和自己的计数。打印吞吐量和基于每个线程计数的Jain公平性指数：1表示每个线程
+// 获得锁的次数相同，1 / num_threads表示每次都是同一个线程获得锁。
+template<typename Lock>
+void RunContention(const std::string &name, int num_threads, int duration_ms) {
+    Lock lock;
+    uint64_t shared_count = 0;
+    std::atomic<bool> stop{false};
+    std::vector<uint64_t> tallies(num_threads, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&lock, &shared_count, &stop, &tallies, t] {
+            uint64_t tally = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::scoped_lock guard(lock);
+                shared_count++;
+                tally++;
+            }
+            tallies[t] = tally;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+
+    double sum = 0;
+    double sum_of_squares = 0;
+    for (uint64_t tally: tallies) {
+        sum += tally;
+        sum_of_squares += static_cast<double>(tally) * tally;
+    }
+    if (sum != shared_count) {
+        std::cout << "    Lost updates with " << name << "!\n";
+    }
+    std::cout << "    " << name << ": " << sum / (duration_ms * 1000.0) << " Mops/s, fairness "
+              << sum * sum / (num_threads * sum_of_squares) << "\n";
+}
+
+// Compares std::mutex with the MCS and CLH locks from 1 to 64 threads. On a
+// machine with few cores the FIFO handoff can cost throughput, since the next
+// waiter in line may not be running; the queue locks shine once many cores
+// spin at the same time.
+// 在1到64个线程下比较std::mutex与MCS锁和CLH锁。在核心很少的机器上，先进先出的交接
+// 可能会损失吞吐量，因为排在下一个的等待者可能没有在运行；当许多核心同时自旋时，
+// 队列锁才会大放异彩。
+void RunBenchmark() {
+    const int duration_ms = 100;
+    std::cout << "Throughput and fairness (" << std::thread::hardware_concurrency() << " hardware threads):\n";
+    for (int num_threads = 1; num_threads <= 64; num_threads *= 4) {
+        std::cout << "  " << num_threads << " threads:\n";
+        RunContention<std::mutex>("std::mutex", num_threads, duration_ms);
+        RunContention<McsLock>("McsLock", num_threads, duration_ms);
+        RunContention<ClhLock>("ClhLock", num_threads, duration_ms);
+    }
+}
+
+// The main method is identical to the one in scoped_lock.cpp, followed by the
+// benchmark.
+// main方法与scoped_lock.cpp中的相同，之后运行基准测试。
+int main() {
+    std::thread t1(add_count);
+    std::thread t2(add_count);
+    t1.join();
+    t2.join();
+
+    std::cout << "Printing count: " << count << std::endl;
+
+    RunBenchmark();
+
+    return 0;
+}
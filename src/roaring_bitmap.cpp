@@ -0,0 +1,937 @@
+/**
+ * @file roaring_bitmap.cpp
+ * @brief Tutorial code for a Roaring-style compressed bitmap of 32-bit integers.
+ * @brief Roaring风格的32位整数压缩位图的教程代码。
+ */
+
+// When a set holds millions of dense integer IDs, a std::set<int> is very
+// wasteful: every 4-byte ID costs a 40-byte tree node. A plain bitmap with one
+// bit per possible ID is tiny for dense data, but it needs 512MB to cover the
+// whole 32-bit range no matter how few IDs there are.
+// 当一个集合保存数百万个密集的整数ID时，std::set<int>非常浪费：每个4字节的ID
+// 都要花费一个40字节的树节点。每个可能的ID占一位的普通位图对于密集数据来说
+// 非常小，但不管ID有多少，它都需要512MB才能覆盖整个32位范围。
+
+// Roaring bitmaps (Chambi, Lemire et al.) get the best of both. A 32-bit value
+// is split into its high 16 bits, which pick a "container", and its low 16
+// bits, which are stored inside that container. A container that holds at
+// most 4096 values is a sorted array of uint16_t (at most 8KB). A container
+// with more values is a 65536-bit bitmap, which is always exactly 8KB. So a
+// value never costs more than 2 bytes, plus a small per-container overhead.
+// Set operations work container by container, and bitmap containers are
+// combined 64 bits at a time with plain AND/OR/AND-NOT instructions.
+// Roaring位图（Chambi、Lemire等人）兼具两者的优点。一个32位的值被拆成高16位
+// 和低16位，高16位选择一个"容器"，低16位存储在该容器中。最多保存4096个值的
+// 容器是一个有序的uint16_t数组（最多8KB）。值更多的容器是一个65536位的位图，
+// 它总是恰好8KB。所以一个值的开销永远不会超过2字节，再加上少量的每个容器的
+// 开销。集合运算按容器逐个进行，位图容器用普通的AND/OR/AND-NOT指令一次组合
+// 64位。
+
+// Real Roaring implementations also have run-length encoded containers, which
+// we leave out to keep this file short.
+// 真正的Roaring实现还有游程编码的容器，为了保持本文件简短我们省略了它。
+
+// Includes std::lower_bound and std::set_intersection.
+// 包含std::lower_bound和std::set_intersection。
+#include <algorithm>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as uint16_t.
+// 包含uint16_t等定宽整数类型。
+#include <cstdint>
+// Includes std::memcmp.
+// 包含std::memcmp。
+#include <cstring>
+// Includes std::ofstream, used to write the serialized bitmap to a file.
+// 包含std::ofstream，用于把序列化后的位图写入文件。
+#include <fstream>
+// Includes std::less.
+// 包含std::less。
+#include <functional>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes std::back_inserter.
+// 包含std::back_inserter。
+#include <iterator>
+// Includes std::allocator.
+// 包含std::allocator。
+#include <memory>
+// Includes the set container library header, for comparison.
+// 包含集合容器库头文件，用于对比。
+#include <set>
+// Includes std::move.
+// 包含std::move。
+#include <utility>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+// Includes the POSIX mmap API, used to query a serialized bitmap in place.
+// 包含POSIX mmap API，用于就地查询序列化后的位图。
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A container holds the low 16 bits of all values that share the same high
+// 16 bits. It is either a sorted array or a bitmap, depending on how many
+// values it holds.
+// 容器保存所有高16位相同的值的低16位。根据它保存的值的数量，它要么是一个有序
+// 数组，要么是一个位图。
+class Container {
+public:
+    // Containers with more values than this are stored as bitmaps. At 4096
+    // values both representations take 8KB.
+    // 值的数量超过这个数的容器以位图形式存储。在4096个值时两种表示都占8KB。
+    static constexpr size_t kMaxArraySize = 4096;
+    static constexpr size_t kBitmapWords = 65536 / 64;
+
+    bool IsBitmap() const { return !bitmap_.empty(); }
+    size_t Cardinality() const { return cardinality_; }
+    const std::vector<uint16_t> &Array() const { return array_; }
+    const std::vector<uint64_t> &Bitmap() const { return bitmap_; }
+
+    size_t MemoryUsage() const { return array_.capacity() * sizeof(uint16_t) + bitmap_.capacity() * sizeof(uint64_t); }
+
+    bool Contains(uint16_t low) const {
+        if (IsBitmap()) {
+            return (bitmap_[low / 64] >> (low % 64)) & 1;
+        }
+        return std::binary_search(array_.begin(), array_.end(), low);
+    }
+
+    // Returns true if low was not in the container before.
+    // 如果low之前不在容器中则返回true。
+    bool Add(uint16_t low) {
+        if (IsBitmap()) {
+            uint64_t bit = uint64_t{1} << (low % 64);
+            if (bitmap_[low / 64] & bit) {
+                return false;
+            }
+            bitmap_[low / 64] |= bit;
+            cardinality_++;
+            return true;
+        }
+        auto it = std::lower_bound(array_.begin(), array_.end(), low);
+        if (it != array_.end() && *it == low) {
+            return false;
+        }
+        array_.insert(it, low);
+        cardinality_++;
+        Normalize();
+        return true;
+    }
+
+    // Returns true if low was in the container.
+    // 如果low在容器中则返回true。
+    bool Remove(uint16_t low) {
+        if (IsBitmap()) {
+            uint64_t bit = uint64_t{1} << (low % 64);
+            if (!(bitmap_[low / 64] & bit)) {
+                return false;
+            }
+            bitmap_[low / 64] &= ~bit;
+            cardinality_--;
+            Normalize();
+            return true;
+        }
+        auto it = std::lower_bound(array_.begin(), array_.end(), low);
+        if (it == array_.end() || *it != low) {
+            return false;
+        }
+        array_.erase(it);
+        cardinality_--;
+        return true;
+    }
+
+    // Removes every value in [lo, hi), where hi may be 65536.
+    // 删除[lo, hi)中的所有值，其中hi可以是65536。
+    void RemoveRange(uint32_t lo, uint32_t hi) {
+        if (IsBitmap()) {
+            for (uint32_t v = lo; v < hi; v++) {
+                bitmap_[v / 64] &= ~(uint64_t{1} << (v % 64));
+            }
+            Recount();
+        } else {
+            auto first = std::lower_bound(array_.begin(), array_.end(), lo);
+            auto last = std::lower_bound(array_.begin(), array_.end(), hi);
+            array_.erase(first, last);
+            cardinality_ = array_.size();
+        }
+        Normalize();
+    }
+
+    // The container is walked with a position: an index into the array, or a
+    // bit number in the bitmap. End() is one past the last position.
+    // 容器通过一个位置来遍历：数组中的下标，或者位图中的位号。End()是最后一个
+    // 位置之后的位置。
+    uint32_t End() const { return IsBitmap() ? 65536 : static_cast<uint32_t>(array_.size()); }
+
+    uint16_t ValueAt(uint32_t pos) const { return IsBitmap() ? static_cast<uint16_t>(pos) : array_[pos]; }
+
+    // Returns the first position at or after pos that holds a value.
+    // 返回在pos处或pos之后第一个保存了值的位置。
+    uint32_t NextFrom(uint32_t pos) const {
+        if (!IsBitmap()) {
+            return pos;
+        }
+        while (pos < 65536) {
+            uint64_t word = bitmap_[pos / 64] >> (pos % 64);
+            if (word != 0) {
+                return pos + __builtin_ctzll(word);
+            }
+            pos = (pos / 64 + 1) * 64;
+        }
+        return 65536;
+    }
+
+    // Container-level intersection, union and difference. Each pair of
+    // representations gets the cheapest algorithm: a merge for two arrays, a
+    // filter when one side is a bitmap, and word-wise logic for two bitmaps.
+    // 容器级别的交集、并集和差集。每种表示组合都使用最便宜的算法：两个数组用
+    // 归并，一边是位图时用过滤，两个位图用按字的逻辑运算。
+    static Container And(const Container &a, const Container &b) {
+        Container out;
+        if (a.IsBitmap() && b.IsBitmap()) {
+            out.bitmap_.resize(kBitmapWords);
+            for (size_t i = 0; i < kBitmapWords; i++) {
+                out.bitmap_[i] = a.bitmap_[i] & b.bitmap_[i];
+            }
+            out.Recount();
+        } else if (a.IsBitmap() || b.IsBitmap()) {
+            const Container &array = a.IsBitmap() ? b : a;
+            const Container &bitmap = a.IsBitmap() ? a : b;
+            for (uint16_t low: array.array_) {
+                if (bitmap.Contains(low)) {
+                    out.array_.push_back(low);
+                }
+            }
+            out.cardinality_ = out.array_.size();
+        } else {
+            std::set_intersection(a.array_.begin(), a.array_.end(), b.array_.begin(), b.array_.end(),
+                                  std::back_inserter(out.array_));
+            out.cardinality_ = out.array_.size();
+        }
+        out.Normalize();
+        return out;
+    }
+
+    static Container Or(const Container &a, const Container &b) {
+        Container out;
+        if (a.IsBitmap() || b.IsBitmap()) {
+            out.bitmap_ = a.IsBitmap() ? a.bitmap_ : b.bitmap_;
+            const Container &other = a.IsBitmap() ? b : a;
+            if (other.IsBitmap()) {
+                for (size_t i = 0; i < kBitmapWords; i++) {
+                    out.bitmap_[i] |= other.bitmap_[i];
+                }
+            } else {
+                for (uint16_t low: other.array_) {
+                    out.bitmap_[low / 64] |= uint64_t{1} << (low % 64);
+                }
+            }
+            out.Recount();
+        } else {
+            std::set_union(a.array_.begin(), a.array_.end(), b.array_.begin(), b.array_.end(),
+                           std::back_inserter(out.array_));
+            out.cardinality_ = out.array_.size();
+        }
+        out.Normalize();
+        return out;
+    }
+
+    static Container AndNot(const Container &a, const Container &b) {
+        Container out;
+        if (a.IsBitmap()) {
+            out.bitmap_ = a.bitmap_;
+            if (b.IsBitmap()) {
+                for (size_t i = 0; i < kBitmapWords; i++) {
+                    out.bitmap_[i] &= ~b.bitmap_[i];
+                }
+            } else {
+                for (uint16_t low: b.array_) {
+                    out.bitmap_[low / 64] &= ~(uint64_t{1} << (low % 64));
+                }
+            }
+            out.Recount();
+        } else if (b.IsBitmap()) {
+            for (uint16_t low: a.array_) {
+                if (!b.Contains(low)) {
+                    out.array_.push_back(low);
+                }
+            }
+            out.cardinality_ = out.array_.size();
+        } else {
+            std::set_difference(a.array_.begin(), a.array_.end(), b.array_.begin(), b.array_.end(),
+                                std::back_inserter(out.array_));
+            out.cardinality_ = out.array_.size();
+        }
+        out.Normalize();
+        return out;
+    }
+
+    // Builds a container from the raw serialized representation.
+    // 从原始的序列化表示构建容器。
+    static Container FromParts(std::vector<uint16_t> array, std::vector<uint64_t> bitmap, size_t cardinality) {
+        Container out;
+        out.array_ = std::move(array);
+        out.bitmap_ = std::move(bitmap);
+        out.cardinality_ = cardinality;
+        return out;
+    }
+
+private:
+    void Recount() {
+        cardinality_ = 0;
+        for (uint64_t word: bitmap_) {
+            cardinality_ += __builtin_popcountll(word);
+        }
+    }
+
+    // Switches to the representation that fits the current cardinality.
+    // 切换到适合当前基数的表示。
+    void Normalize() {
+        if (!IsBitmap() && cardinality_ > kMaxArraySize) {
+            bitmap_.assign(kBitmapWords, 0);
+            for (uint16_t low: array_) {
+                bitmap_[low / 64] |= uint64_t{1} << (low % 64);
+            }
+            std::vector<uint16_t>().swap(array_);
+        } else if (IsBitmap() && cardinality_ <= kMaxArraySize) {
+            array_.reserve(cardinality_);
+            for (uint32_t pos = NextFrom(0); pos < 65536; pos = NextFrom(pos + 1)) {
+                array_.push_back(static_cast<uint16_t>(pos));
+            }
+            std::vector<uint64_t>().swap(bitmap_);
+        }
+    }
+
+    std::vector<uint16_t> array_;
+    std::vector<uint64_t> bitmap_;
+    size_t cardinality_{0};
+};
+
+// RoaringBitmap is a set of uint32_t with the std::set interface used in
+// sets.cpp, plus bulk set operations and serialization. The containers are
+// kept sorted by their high 16 bits ("key").
+// RoaringBitmap是一个uint32_t的集合，具有sets.cpp中使用的std::set接口，外加
+// 批量集合运算和序列化。容器按它们的高16位（"键"）保持有序。
+class RoaringBitmap {
+public:
+    class Iterator {
+    public:
+        Iterator(const RoaringBitmap *bitmap, size_t index, uint32_t pos) : bitmap_(bitmap), index_(index), pos_(pos) {
+            Settle();
+        }
+
+        uint32_t operator*() const {
+            return (uint32_t{bitmap_->keys_[index_]} << 16) | bitmap_->containers_[index_].ValueAt(pos_);
+        }
+
+        Iterator &operator++() {
+            pos_++;
+            Settle();
+            return *this;
+        }
+
+        bool operator==(const Iterator &other) const { return index_ == other.index_ && pos_ == other.pos_; }
+        bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+    private:
+        // Moves pos_ forward to the next value, going to the next container if
+        // this one has no more values.
+        // 把pos_向前移动到下一个值，如果当前容器没有更多的值就去下一个容器。
+        void Settle() {
+            while (index_ < bitmap_->containers_.size()) {
+                pos_ = bitmap_->containers_[index_].NextFrom(pos_);
+                if (pos_ < bitmap_->containers_[index_].End()) {
+                    return;
+                }
+                index_++;
+                pos_ = 0;
+            }
+            pos_ = 0;
+        }
+
+        const RoaringBitmap *bitmap_;
+        size_t index_;
+        uint32_t pos_;
+    };
+
+    using iterator = Iterator;
+
+    Iterator begin() const { return Iterator(this, 0, 0); }
+    Iterator end() const { return Iterator(this, containers_.size(), 0); }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const Container &container: containers_) {
+            total += container.Cardinality();
+        }
+        return total;
+    }
+
+    bool empty() const { return containers_.empty(); }
+
+    size_t MemoryUsage() const {
+        size_t bytes = keys_.capacity() * sizeof(uint16_t) + containers_.capacity() * sizeof(Container);
+        for (const Container &container: containers_) {
+            bytes += container.MemoryUsage();
+        }
+        return bytes;
+    }
+
+    bool insert(uint32_t value) {
+        size_t index = FindContainer(value >> 16);
+        if (index == containers_.size() || keys_[index] != (value >> 16)) {
+            keys_.insert(keys_.begin() + index, static_cast<uint16_t>(value >> 16));
+            containers_.insert(containers_.begin() + index, Container());
+        }
+        return containers_[index].Add(static_cast<uint16_t>(value));
+    }
+
+    bool emplace(uint32_t value) { return insert(value); }
+
+    size_t count(uint32_t value) const {
+        size_t index = FindContainer(value >> 16);
+        if (index == containers_.size() || keys_[index] != (value >> 16)) {
+            return 0;
+        }
+        return containers_[index].Contains(static_cast<uint16_t>(value)) ? 1 : 0;
+    }
+
+    Iterator find(uint32_t value) const {
+        if (count(value) == 0) {
+            return end();
+        }
+        return lower_bound(value);
+    }
+
+    // Returns an iterator to the first value that is >= value.
+    // 返回指向第一个 >= value 的值的迭代器。
+    Iterator lower_bound(uint32_t value) const {
+        size_t index = FindContainer(value >> 16);
+        if (index == containers_.size()) {
+            return end();
+        }
+        if (keys_[index] != (value >> 16)) {
+            return Iterator(this, index, 0);
+        }
+        const Container &container = containers_[index];
+        uint16_t low = static_cast<uint16_t>(value);
+        if (container.IsBitmap()) {
+            return Iterator(this, index, low);
+        }
+        const std::vector<uint16_t> &array = container.Array();
+        return Iterator(this, index, std::lower_bound(array.begin(), array.end(), low) - array.begin());
+    }
+
+    size_t erase(uint32_t value) {
+        size_t index = FindContainer(value >> 16);
+        if (index == containers_.size() || keys_[index] != (value >> 16)) {
+            return 0;
+        }
+        bool removed = containers_[index].Remove(static_cast<uint16_t>(value));
+        DropIfEmpty(index);
+        return removed ? 1 : 0;
+    }
+
+    void erase(Iterator pos) { erase(*pos); }
+
+    // Erases every value in [*first, *last). Containers that are entirely
+    // inside the range are dropped without looking at their contents.
+    // 删除[*first, *last)中的所有值。完全在范围内的容器会被直接丢弃，而不用
+    // 查看它们的内容。
+    void erase(Iterator first, Iterator last) {
+        if (first == end()) {
+            return;
+        }
+        uint64_t lo = *first;
+        uint64_t hi = last == end() ? (uint64_t{1} << 32) : *last;
+        EraseRange(lo, hi);
+    }
+
+    void EraseRange(uint64_t lo, uint64_t hi) {
+        size_t index = FindContainer(static_cast<uint16_t>(lo >> 16));
+        while (index < containers_.size()) {
+            uint64_t base = uint64_t{keys_[index]} << 16;
+            if (base >= hi) {
+                break;
+            }
+            uint32_t from = lo > base ? static_cast<uint32_t>(lo - base) : 0;
+            uint32_t to = static_cast<uint32_t>(std::min<uint64_t>(hi - base, 65536));
+            if (from == 0 && to == 65536) {
+                keys_.erase(keys_.begin() + index);
+                containers_.erase(containers_.begin() + index);
+                continue;
+            }
+            containers_[index].RemoveRange(from, to);
+            if (!DropIfEmpty(index)) {
+                index++;
+            }
+        }
+    }
+
+    // Bulk set operations. They merge the two sorted lists of containers and
+    // combine the containers whose keys match.
+    // 批量集合运算。它们归并两个有序的容器列表，并组合键相同的容器。
+    friend RoaringBitmap operator&(const RoaringBitmap &a, const RoaringBitmap &b) {
+        RoaringBitmap out;
+        size_t i = 0;
+        size_t j = 0;
+        while (i < a.keys_.size() && j < b.keys_.size()) {
+            if (a.keys_[i] < b.keys_[j]) {
+                i++;
+            } else if (b.keys_[j] < a.keys_[i]) {
+                j++;
+            } else {
+                out.Append(a.keys_[i], Container::And(a.containers_[i], b.containers_[j]));
+                i++;
+                j++;
+            }
+        }
+        return out;
+    }
+
+    friend RoaringBitmap operator|(const RoaringBitmap &a, const RoaringBitmap &b) {
+        RoaringBitmap out;
+        size_t i = 0;
+        size_t j = 0;
+        while (i < a.keys_.size() || j < b.keys_.size()) {
+            if (j == b.keys_.size() || (i < a.keys_.size() && a.keys_[i] < b.keys_[j])) {
+                out.Append(a.keys_[i], a.containers_[i]);
+                i++;
+            } else if (i == a.keys_.size() || b.keys_[j] < a.keys_[i]) {
+                out.Append(b.keys_[j], b.containers_[j]);
+                j++;
+            } else {
+                out.Append(a.keys_[i], Container::Or(a.containers_[i], b.containers_[j]));
+                i++;
+                j++;
+            }
+        }
+        return out;
+    }
+
+    friend RoaringBitmap operator-(const RoaringBitmap &a, const RoaringBitmap &b) {
+        RoaringBitmap out;
+        size_t j = 0;
+        for (size_t i = 0; i < a.keys_.size(); i++) {
+            while (j < b.keys_.size() && b.keys_[j] < a.keys_[i]) {
+                j++;
+            }
+            if (j < b.keys_.size() && b.keys_[j] == a.keys_[i]) {
+                out.Append(a.keys_[i], Container::AndNot(a.containers_[i], b.containers_[j]));
+            } else {
+                out.Append(a.keys_[i], a.containers_[i]);
+            }
+        }
+        return out;
+    }
+
+    // Serialization. The format is little endian no matter what machine
+    // writes it, and every payload is 8-byte aligned, so the bytes can be
+    // memory-mapped and queried in place by RoaringView:
+    //   "RBM1"                      4-byte magic
+    //   uint32 n                    number of containers
+    //   n x {uint16 key, uint16 type, uint32 cardinality, uint32 offset}
+    //   payloads                    uint16 arrays or 1024 x uint64 bitmaps
+    // 序列化。不管是什么机器写的，格式都是小端序的，并且每个载荷都是8字节对齐的，
+    // 所以这些字节可以被内存映射并由RoaringView就地查询：
+    //   "RBM1"                      4字节魔数
+    //   uint32 n                    容器数量
+    //   n x {uint16 key, uint16 type, uint32 cardinality, uint32 offset}
+    //   载荷                         uint16数组或1024个uint64的位图
+    std::vector<uint8_t> Serialize() const {
+        std::vector<uint8_t> out = {'R', 'B', 'M', '1'};
+        PutLE(out, containers_.size(), 4);
+        size_t offset = Align8(8 + containers_.size() * 12);
+        for (size_t i = 0; i < containers_.size(); i++) {
+            const Container &container = containers_[i];
+            PutLE(out, keys_[i], 2);
+            PutLE(out, container.IsBitmap() ? 1 : 0, 2);
+            PutLE(out, container.Cardinality(), 4);
+            PutLE(out, offset, 4);
+            offset = Align8(offset + (container.IsBitmap() ? 8192 : container.Cardinality() * 2));
+        }
+        for (const Container &container: containers_) {
+            out.resize(Align8(out.size()), 0);
+            if (container.IsBitmap()) {
+                for (uint64_t word: container.Bitmap()) {
+                    PutLE(out, word, 8);
+                }
+            } else {
+                for (uint16_t low: container.Array()) {
+                    PutLE(out, low, 2);
+                }
+            }
+        }
+        return out;
+    }
+
+    static RoaringBitmap Deserialize(const uint8_t *data, size_t size);
+
+private:
+    friend class RoaringView;
+
+    static size_t Align8(size_t n) { return (n + 7) & ~size_t{7}; }
+
+    static void PutLE(std::vector<uint8_t> &out, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    // Returns the index of the first container whose key is >= key.
+    // 返回第一个键 >= key 的容器的下标。
+    size_t FindContainer(uint32_t key) const {
+        return std::lower_bound(keys_.begin(), keys_.end(), key) - keys_.begin();
+    }
+
+    bool DropIfEmpty(size_t index) {
+        if (containers_[index].Cardinality() != 0) {
+            return false;
+        }
+        keys_.erase(keys_.begin() + index);
+        containers_.erase(containers_.begin() + index);
+        return true;
+    }
+
+    void Append(uint16_t key, Container container) {
+        if (container.Cardinality() != 0) {
+            keys_.push_back(key);
+            containers_.push_back(std::move(container));
+        }
+    }
+
+    std::vector<uint16_t> keys_;
+    std::vector<Container> containers_;
+};
+
+// RoaringView answers queries directly on serialized bytes, for example a
+// file mapped with mmap. Nothing is copied or decoded, so opening a huge
+// bitmap only costs one sequential pass to validate it.
+// RoaringView直接在序列化后的字节上回答查询，例如一个用mmap映射的文件。不会复制或
+// 解码任何内容，所以打开一个巨大的位图只需要一次顺序遍历来验证它。
+class RoaringView {
+public:
+    // Checks the whole file before trusting it, so that a truncated or
+    // corrupt file gives an invalid, empty view instead of reads past the end
+    // of the mapping or wrong answers. Keys and array payloads must be
+    // strictly increasing for the binary searches in count, and every
+    // container must satisfy the invariants of Container: a bitmap stores
+    // more than kMaxArraySize values and its cardinality is its popcount.
+    // 在信任整个文件之前先检查它，这样一个被截断或损坏的文件会得到一个无效的空视图，
+    // 而不是越过映射末尾的读取或错误的答案。键和数组负载必须严格递增，count中的二分
+    // 查找才能工作，并且每个容器都必须满足Container的不变式：位图存储多于
+    // kMaxArraySize个值，并且它的基数等于它的popcount。
+    RoaringView(const uint8_t *data, size_t size) : data_(data), size_(size) {
+        valid_ = size >= 8 && std::memcmp(data, "RBM1", 4) == 0;
+        num_containers_ = valid_ ? GetLE(4, 4) : 0;
+        valid_ = valid_ && num_containers_ <= (size - 8) / 12;
+        for (size_t i = 0; valid_ && i < num_containers_; i++) {
+            uint64_t type = GetLE(8 + i * 12 + 2, 2);
+            size_t cardinality = Cardinality(i);
+            size_t bytes = type == 1 ? Container::kBitmapWords * 8 : cardinality * 2;
+            valid_ = type <= 1 && cardinality != 0 && cardinality <= (type == 1 ? 65536 : Container::kMaxArraySize) &&
+                     Offset(i) <= size && bytes <= size - Offset(i) && (i == 0 || Key(i - 1) < Key(i)) &&
+                     PayloadIsValid(i);
+        }
+        if (!valid_) {
+            num_containers_ = 0;
+        }
+    }
+
+    bool IsValid() const { return valid_; }
+    size_t NumContainers() const { return num_containers_; }
+
+    uint16_t Key(size_t i) const { return static_cast<uint16_t>(GetLE(8 + i * 12, 2)); }
+    bool IsBitmap(size_t i) const { return GetLE(8 + i * 12 + 2, 2) == 1; }
+    size_t Cardinality(size_t i) const { return GetLE(8 + i * 12 + 4, 4); }
+    size_t Offset(size_t i) const { return GetLE(8 + i * 12 + 8, 4); }
+
+    size_t size() const {
+        size_t total = 0;
+        for (size_t i = 0; i < num_containers_; i++) {
+            total += Cardinality(i);
+        }
+        return total;
+    }
+
+    size_t count(uint32_t value) const {
+        uint16_t key = static_cast<uint16_t>(value >> 16);
+        uint16_t low = static_cast<uint16_t>(value);
+        // Binary search over the container descriptors.
+        // 在容器描述符上进行二分查找。
+        size_t lo = 0;
+        size_t hi = num_containers_;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (Key(mid) < key) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo == num_containers_ || Key(lo) != key) {
+            return 0;
+        }
+        size_t offset = Offset(lo);
+        if (IsBitmap(lo)) {
+            return (GetLE(offset + (low / 64) * 8, 8) >> (low % 64)) & 1;
+        }
+        size_t first = 0;
+        size_t last = Cardinality(lo);
+        while (first < last) {
+            size_t mid = (first + last) / 2;
+            if (GetLE(offset + mid * 2, 2) < low) {
+                first = mid + 1;
+            } else {
+                last = mid;
+            }
+        }
+        return first < Cardinality(lo) && GetLE(offset + first * 2, 2) == low ? 1 : 0;
+    }
+
+private:
+    // Checks the payload of container i, whose bytes are known to be in
+    // bounds.
+    // 检查容器i的负载，它的字节已知都在边界之内。
+    bool PayloadIsValid(size_t i) const {
+        size_t offset = Offset(i);
+        size_t cardinality = Cardinality(i);
+        if (IsBitmap(i)) {
+            size_t popcount = 0;
+            for (size_t w = 0; w < Container::kBitmapWords; w++) {
+                popcount += __builtin_popcountll(GetLE(offset + w * 8, 8));
+            }
+            return cardinality > Container::kMaxArraySize && popcount == cardinality;
+        }
+        for (size_t j = 1; j < cardinality; j++) {
+            if (GetLE(offset + (j - 1) * 2, 2) >= GetLE(offset + j * 2, 2)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Reads a little endian integer byte by byte, so this works on any
+    // machine and does not care about alignment.
+    // 逐字节读取一个小端序整数，所以它在任何机器上都能工作，也不关心对齐。
+    uint64_t GetLE(size_t offset, int bytes) const {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value |= uint64_t{data_[offset + i]} << (8 * i);
+        }
+        return value;
+    }
+
+    const uint8_t *data_;
+    size_t size_;
+    size_t num_containers_{0};
+    bool valid_{false};
+};
+
+// Deserialize copies a serialized bitmap back into a mutable RoaringBitmap.
+// Invalid bytes give an empty bitmap, since RoaringView rejects them.
+// Deserialize把一个序列化的位图复制回一个可修改的RoaringBitmap。无效的字节会得到
+// 一个空位图，因为RoaringView会拒绝它们。
+RoaringBitmap RoaringBitmap::Deserialize(const uint8_t *data, size_t size) {
+    RoaringView view(data, size);
+    RoaringBitmap out;
+    for (size_t i = 0; i < view.NumContainers(); i++) {
+        std::vector<uint16_t> array;
+        std::vector<uint64_t> bitmap;
+        size_t offset = view.Offset(i);
+        if (view.IsBitmap(i)) {
+            bitmap.resize(Container::kBitmapWords);
+            for (size_t w = 0; w < Container::kBitmapWords; w++) {
+                for (int b = 0; b < 8; b++) {
+                    bitmap[w] |= uint64_t{data[offset + w * 8 + b]} << (8 * b);
+                }
+            }
+        } else {
+            for (size_t j = 0; j < view.Cardinality(i); j++) {
+                array.push_back(static_cast<uint16_t>(data[offset + j * 2] | (data[offset + j * 2 + 1] << 8)));
+            }
+        }
+        out.Append(view.Key(i), Container::FromParts(std::move(array), std::move(bitmap), view.Cardinality(i)));
+    }
+    return out;
+}
+
+// Runs func once and returns how long it took, in milliseconds.
+// 运行func一次并返回它所花的时间，单位为毫秒。
+template<typename Func>
+double TimeMs(Func func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// CountingAllocator is the one from flat_set.cpp. It adds every allocation to
+// a global byte counter, so we can measure the memory of std::set's tree nodes.
+// CountingAllocator就是flat_set.cpp中的那个。它会把每次分配的字节数累加到一个全局
+// 计数器中，这样我们就能测量std::set的树节点占用的内存。
+size_t allocated_bytes = 0;
+
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        allocated_bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T *p, size_t n) {
+        allocated_bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const CountingAllocator<U> &) const { return true; }
+    template<typename U>
+    bool operator!=(const CountingAllocator<U> &) const { return false; }
+};
+
+// Compares memory and intersection speed against std::set on two sets of
+// dense IDs.
+// 在两个密集ID集合上比较内存和求交集的速度与std::set的表现。
+void RunBenchmark() {
+    const uint32_t universe = 1 << 20;
+    RoaringBitmap a;
+    RoaringBitmap b;
+    std::set<uint32_t, std::less<uint32_t>, CountingAllocator<uint32_t>> set_a;
+    std::set<uint32_t, std::less<uint32_t>, CountingAllocator<uint32_t>> set_b;
+    for (uint32_t i = 0; i < universe; i++) {
+        // Pseudo-random membership, about half of the IDs in each set.
+        // 伪随机的成员关系，每个集合中大约有一半的ID。
+        if ((i * 2654435761u) >> 31) {
+            a.insert(i);
+            set_a.insert(i);
+        }
+        if ((i * 40503u + 7) % 3 == 0) {
+            b.insert(i);
+            set_b.insert(i);
+        }
+    }
+
+    std::vector<uint32_t> tree_result;
+    double tree_ms = TimeMs([&] {
+        std::set_intersection(set_a.begin(), set_a.end(), set_b.begin(), set_b.end(),
+                              std::back_inserter(tree_result));
+    });
+    RoaringBitmap roaring_result;
+    double roaring_ms = TimeMs([&] { roaring_result = a & b; });
+
+    std::cout << "Benchmark with " << a.size() << " and " << b.size() << " dense IDs:\n";
+    std::cout << "  RoaringBitmap: " << static_cast<double>(a.MemoryUsage()) / a.size() << " bytes/ID, intersection "
+              << roaring_ms << " ms, " << roaring_result.size() << " results\n";
+    std::cout << "  std::set:      " << static_cast<double>(allocated_bytes) / (set_a.size() + set_b.size())
+              << " bytes/ID, intersection " << tree_ms << " ms, "
+              << tree_result.size() << " results\n";
+    std::cout << "  Union has " << (a | b).size() << " IDs, difference has " << (a - b).size() << " IDs\n";
+}
+
+// Writes the bitmap to a file, maps the file with mmap and queries it in
+// place without deserializing it.
+// 把位图写入一个文件，用mmap映射该文件，并在不反序列化的情况下就地查询它。
+void RunMmapDemo(const RoaringBitmap &bitmap) {
+    const char *path = "roaring_bitmap.bin";
+    std::vector<uint8_t> bytes = bitmap.Serialize();
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        std::cout << "Could not open " << path << "\n";
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        std::cout << "Could not stat " << path << "\n";
+        close(fd);
+        return;
+    }
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        std::cout << "Could not mmap " << path << "\n";
+        return;
+    }
+
+    RoaringView view(static_cast<const uint8_t *>(addr), st.st_size);
+    if (!view.IsValid()) {
+        std::cout << path << " is not a valid serialized bitmap\n";
+        munmap(addr, st.st_size);
+        unlink(path);
+        return;
+    }
+    std::cout << "Mapped " << st.st_size << " bytes holding " << view.size() << " values. ";
+    std::cout << "Contains 70000? " << view.count(70000) << ", contains 3? " << view.count(3) << "\n";
+
+    RoaringBitmap copy = RoaringBitmap::Deserialize(static_cast<const uint8_t *>(addr), st.st_size);
+    std::cout << "Deserialized copy has " << copy.size() << " values\n";
+
+    munmap(addr, st.st_size);
+    unlink(path);
+}
+
+int main() {
+    // RoaringBitmap supports the std::set operations shown in sets.cpp.
+    // RoaringBitmap支持sets.cpp中展示的std::set操作。
+    RoaringBitmap int_set;
+    for (uint32_t i = 1; i <= 5; ++i) {
+        int_set.insert(i);
+    }
+    for (uint32_t i = 6; i <= 10; ++i) {
+        int_set.emplace(i);
+    }
+
+    if (int_set.find(2) != int_set.end()) {
+        std::cout << "Element 2 is in int_set.\n";
+    }
+    if (int_set.count(11) == 0) {
+        std::cout << "Element 11 is not in the set.\n";
+    }
+    int_set.erase(4);
+    if (int_set.count(4) == 0) {
+        std::cout << "Element 4 is not in the set.\n";
+    }
+    int_set.erase(int_set.begin());
+    if (int_set.count(1) == 0) {
+        std::cout << "Element 1 is not in the set.\n";
+    }
+    int_set.erase(int_set.find(9), int_set.end());
+    if (int_set.count(9) == 0 && int_set.count(10) == 0) {
+        std::cout << "Elements 9 and 10 are not in the set.\n";
+    }
+
+    std::cout << "Printing the elements of the bitmap:\n";
+    for (uint32_t elem: int_set) {
+        std::cout << elem << " ";
+    }
+    std::cout << "\n";
+
+    // Adding a dense run of values turns their container into a bitmap.
+    // 添加一段密集的值会把它们的容器变为位图。
+    RoaringBitmap dense;
+    for (uint32_t i = 65536; i < 65536 + 10000; ++i) {
+        dense.insert(i);
+    }
+    dense.insert(3);
+    std::cout << "Dense bitmap holds " << dense.size() << " values in " << dense.MemoryUsage() << " bytes\n";
+
+    RunMmapDemo(dense);
+    RunBenchmark();
+
+    return 0;
+}
@@ -0,0 +1,292 @@
+/**
+ * @file seqlock.cpp
+ * @brief Tutorial code for a sequence lock protecting a small value.
+ * @brief 保护一个小值的序列锁的教程代码。
+ */
+
+// read_value in rwlock.cpp takes a std::shared_lock just to read one int.
+// Taking a shared lock writes to the mutex's reader count, twice, so every
+// read is really two writes to a cache line that all readers share. For a
+// small value that is copied in a few nanoseconds, that bookkeeping costs more
+// than the read itself.
+// rwlock.cpp中的read_value只是为了读一个int就获取了std::shared_lock。获取共享锁
+// 要写两次互斥锁的读者计数，所以每次读取实际上都是对一个所有读者共享的缓存行的两次
+// 写入。对于一个几纳秒就能复制完的小值来说，这些记录工作的开销比读取本身还大。
+
+// A sequence lock ("seqlock", used by the Linux kernel for the system clock)
+// lets readers proceed without writing anything. The lock is a version
+// number that a writer makes odd before it changes the value and even again
+// afterwards. A reader reads the version, copies the value, and reads the
+// version again: if both reads returned the same even number, no writer ran
+// in between and the copy is consistent; otherwise the reader simply tries
+// again. Readers never block writers, and a writer never waits for readers.
+// 序列锁（"seqlock"，Linux内核用它来保护系统时钟）让读者不需要写任何东西就能继续。
+// 这个锁是一个版本号，写者在修改值之前把它变成奇数，修改之后再变回偶数。读者读取
+// 版本号、复制值，然后再次读取版本号：如果两次读到的是同一个偶数，说明期间没有写者
+// 运行，复制出来的值是一致的；否则读者只需要重试。读者从不阻塞写者，写者也从不等待
+// 读者。
+
+// Includes std::array.
+// 包含std::array。
+#include <array>
+// Includes std::atomic.
+// 包含std::atomic。
+#include <atomic>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as uint64_t.
+// 包含uint64_t等定宽整数类型。
+#include <cstdint>
+// Includes std::memcpy.
+// 包含std::memcpy。
+#include <cstring>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes the mutex library header.
+// 包含互斥锁库头文件。
+#include <mutex>
+// Includes std::launder.
+// 包含std::launder。
+#include <new>
+// Includes the random number library, used by the benchmark.
+// 包含随机数库，供基准测试使用。
+#include <random>
+// Includes the shared mutex library header.
+// 包含共享互斥锁库头文件。
+#include <shared_mutex>
+// Includes the C++ string library.
+// 包含C++字符串库。
+#include <string>
+// Includes the thread library header.
+// 包含线程库头文件。
+#include <thread>
+// Includes std::is_trivially_copyable.
+// 包含std::is_trivially_copyable。
+#include <type_traits>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+
+// T must be trivially copyable, since a reader copies its bytes while a
+// writer may be changing them, and throws the copy away if so. Copying a
+// std::string that way could follow a pointer that was just freed.
+// T必须是可平凡复制的，因为读者在复制它的字节时，写者可能正在修改它们，这时读者会
+// 丢弃这份拷贝。用这种方式复制std::string可能会沿着一个刚刚被释放的指针去访问。
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock needs a trivially copyable T");
+
+public:
+    explicit SeqLock(const T &value = T()) { StoreWords(value); }
+
+    SeqLock(const SeqLock &) = delete;
+    SeqLock &operator=(const SeqLock &) = delete;
+
+    // Returns a consistent copy of the value, retrying while a writer is
+    // active or ran during the copy.
+    // 返回值的一份一致的拷贝，当有写者正在运行或在复制期间运行过时会重试。
+    T Load() const {
+        while (true) {
+            uint64_t before = version_.load(std::memory_order_acquire);
+            if (before % 2 == 1) {
+                continue;
+            }
+            T value = LoadWords();
+            // The fence keeps the copy above from being reordered after the
+            // second read of the version.
+            // 这个栅栏防止上面的复制被重排到第二次读取版本号之后。
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version_.load(std::memory_order_relaxed) == before) {
+                return value;
+            }
+        }
+    }
+
+    void Store(const T &value) {
+        std::scoped_lock lock(writer_mutex_);
+        BeginWrite();
+        StoreWords(value);
+        EndWrite();
+    }
+
+    // Reads, modifies and writes the value as one atomic step. Writers are
+    // serialized by writer_mutex_, so no update is lost.
+    // 把读取、修改和写入作为一个原子步骤完成。写者由writer_mutex_串行化，所以不会丢失
+    // 任何更新。
+    template<typename Fn>
+    void Update(Fn update) {
+        std::scoped_lock lock(writer_mutex_);
+        T value = LoadWords();
+        update(value);
+        BeginWrite();
+        StoreWords(value);
+        EndWrite();
+    }
+
+private:
+    // A reader may copy the value while a writer changes it. If the value were
+    // a plain T that would be a data race, which C++ leaves undefined, even
+    // though the reader then throws the copy away. So the value is kept as an
+    // array of atomic words that both sides access with relaxed operations,
+    // which compile to ordinary loads and stores.
+    // 读者可能在写者修改值的同时复制它。如果值是一个普通的T，这就是数据竞争，C++对此
+    // 没有定义行为，即使读者随后会丢弃这份拷贝。所以值被保存为一个原子字的数组，双方都
+    // 用relaxed操作访问它，这些操作会被编译成普通的读取和写入。
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    T LoadWords() const {
+        std::array<uint64_t, kWords> words;
+        for (size_t i = 0; i < kWords; i++) {
+            words[i] = words_[i].load(std::memory_order_relaxed);
+        }
+        // The bytes are copied into a suitably aligned buffer rather than
+        // into a T, so T does not need a default constructor.
+        // 字节被复制到一个适当对齐的缓冲区中，而不是复制到一个T中，所以T不需要默认
+        // 构造函数。
+        alignas(T) unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, words.data(), sizeof(T));
+        return *std::launder(reinterpret_cast<T *>(bytes));
+    }
+
+    void StoreWords(const T &value) {
+        std::array<uint64_t, kWords> words{};
+        std::memcpy(words.data(), static_cast<const void *>(&value), sizeof(T));
+        for (size_t i = 0; i < kWords; i++) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    // Makes the version odd. The fence keeps the word stores that follow
+    // from being reordered before it.
+    // 把版本号变成奇数。这个栅栏防止后面对字的写入被重排到它之前。
+    void BeginWrite() {
+        version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void EndWrite() { version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    std::atomic<uint64_t> version_{0};
+    std::array<std::atomic<uint64_t>, kWords> words_;
+    std::mutex writer_mutex_;
+};
+
+// The program of rwlock.cpp with count kept in a SeqLock. read_value takes
+// no lock at all, and write_value updates count in one step.
+// rwlock.cpp中的程序，只是count保存在一个SeqLock中。read_value完全不加锁，
+// write_value在一步之内更新count。
+SeqLock<int> count(0);
+
+void read_value() { std::cout << "Reading value " + std::to_string(count.Load()) + "\n" << std::flush; }
+
+void write_value() {
+    count.Update([](int &value) { value += 3; });
+}
+
+// A value whose fields must change together. A torn read, half before and
+// half after a write, would break sum == a + b + c.
+// 一个各字段必须一起改变的值。撕裂的读取（一半在写入之前，一半在写入之后）会破坏
+// sum == a + b + c。
+struct Position {
+    int64_t a = 0;
+    int64_t b = 0;
+    int64_t c = 0;
+    int64_t sum = 0;
+};
+
+// A std::shared_mutex with the same Load and Update interface, for comparison.
+// 一个具有相同Load和Update接口的std::shared_mutex，用于对比。
+class SharedMutexValue {
+public:
+    Position Load() const {
+        std::shared_lock lock(m_);
+        return value_;
+    }
+
+    template<typename Fn>
+    void Update(Fn update) {
+        std::unique_lock lock(m_);
+        update(value_);
+    }
+
+private:
+    mutable std::shared_mutex m_;
+    Position value_;
+};
+
+// Runs num_threads threads that together perform total_ops operations, 99%
+// of them reads and 1% updates, and checks every read for tearing. Returns
+// Mops/s.
+// 运行num_threads个线程，它们一共执行total_ops次操作，其中99%是读取、1%是更新，并
+// 检查每次读取是否被撕裂。返回Mops/s。
+template<typename Value>
+double RunMix(int num_threads, int total_ops) {
+    Value value;
+    std::atomic<int64_t> torn{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&value, &torn, t, num_threads, total_ops] {
+            std::mt19937 rng(t);
+            for (int i = 0; i < total_ops / num_threads; i++) {
+                if (rng() % 100 == 0) {
+                    value.Update([](Position &p) {
+                        p.a++;
+                        p.b += 2;
+                        p.c += 3;
+                        p.sum = p.a + p.b + p.c;
+                    });
+                } else {
+                    Position p = value.Load();
+                    if (p.sum != p.a + p.b + p.c) {
+                        torn++;
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    if (torn != 0) {
+        std::cout << "    " << torn << " torn reads!\n";
+    }
+    return total_ops / std::chrono::duration<double, std::micro>(stop - start).count();
+}
+
+void RunBenchmark() {
+    const int total_ops = 1 << 21;
+    std::cout << "Throughput in Mops/s with 99% reads (" << std::thread::hardware_concurrency()
+              << " hardware threads):\n";
+    for (int num_threads = 1; num_threads <= 64; num_threads *= 4) {
+        double shared_mops = RunMix<SharedMutexValue>(num_threads, total_ops);
+        double seqlock_mops = RunMix<SeqLock<Position>>(num_threads, total_ops);
+        std::cout << "  " << num_threads << " threads: std::shared_mutex " << shared_mops << ", SeqLock "
+                  << seqlock_mops << "\n";
+    }
+}
+
+// The main method is the one from rwlock.cpp, followed by the benchmark.
+// main方法就是rwlock.cpp中的那个，之后运行基准测试。
+int main() {
+    std::thread t1(read_value);
+    std::thread t2(write_value);
+    std::thread t3(read_value);
+    std::thread t4(read_value);
+    std::thread t5(write_value);
+    std::thread t6(read_value);
+
+    t1.join();
+    t2.join();
+    t3.join();
+    t4.join();
+    t5.join();
+    t6.join();
+
+    RunBenchmark();
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file sharded_counter.cpp
+ * @brief Tutorial code for a counter split into per-thread cache line slots.
+ * @brief 划分为每线程缓存行槽的计数器的教程代码。
+ */
+
+// mutex.cpp and scoped_lock.cpp increment a global int count under a
+// std::mutex. That is correct, but every increment from every thread locks
+// the same mutex and writes the same cache line. With many threads that cache
+// line moves from core to core on every increment, and the threads spend
+// their time waiting for it. A std::atomic<int> with fetch_add removes the
+// lock, but not the shared cache line.
+// mutex.cpp和scoped_lock.cpp在std::mutex的保护下增加一个全局的int count。这是正确
+// 的，但每个线程的每次增加都要锁住同一个互斥锁并写同一个缓存行。线程很多时，这个
+// 缓存行在每次增加时都要从一个核心移动到另一个核心，线程的时间都花在了等待它上。
+// 使用带fetch_add的std::atomic<int>去掉了锁，但没有去掉共享的缓存行。
+
+// ShardedCounter gives each thread its own slot, and each slot sits on its own
+// cache line. An increment only touches the calling thread's slot, so threads
+// never contend and the cache line stays in that core's cache. Reading the
+// counter adds up all slots, which is slower, so a sharded counter pays off
+// when increments are much more frequent than reads, such as statistics.
+// ShardedCounter给每个线程一个自己的槽，并且每个槽位于自己的缓存行上。一次增加只会
+// 访问调用线程自己的槽，所以线程之间永远不会竞争，缓存行也一直留在该核心的缓存中。
+// 读取计数器要把所有槽加起来，这要慢一些，所以当增加比读取频繁得多时（例如统计信息），
+// 分片计数器才划算。
+
+// Includes std::array.
+// 包含std::array。
+#include <array>
+// Includes std::atomic.
+// 包含std::atomic。
+#include <atomic>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as int64_t.
+// 包含int64_t等定宽整数类型。
+#include <cstdint>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes the mutex library header.
+// 包含互斥锁库头文件。
+#include <mutex>
+// Includes the thread library header.
+// 包含线程库头文件。
+#include <thread>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+
+// The size of a cache line on x86 and most ARM cores. C++17 has
+// std::hardware_destructive_interference_size for this, but not every
+// compiler provides it yet.
+// x86和大多数ARM核心上缓存行的大小。C++17为此提供了
+// std::hardware_destructive_interference_size，但并不是每个编译器都已经支持它。
+constexpr size_t kCacheLineSize = 64;
+
+// Every thread gets a small index the first time it asks, in the order
+// threads first ask. A thread_local variable has one copy per thread, so the
+// index is computed once per thread and later calls just read it.
+// 每个线程在第一次请求时按先后顺序得到一个小的下标。thread_local变量每个线程有一份
+// 拷贝，所以下标每个线程只计算一次，之后的调用只是读取它。
+size_t ThreadIndex() {
+    static std::atomic<size_t> next_index{0};
+    thread_local size_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+// kNumSlots must be a power of two. If more than kNumSlots threads increment
+// the counter, some threads share a slot. That is still correct, because a
+// slot is updated with an atomic fetch_add, but those threads contend again.
+// An alternative is one slot per core (sched_getcpu on Linux), which bounds
+// the number of slots by the number of cores instead of threads, but a thread
+// can move to another core between looking up its core and incrementing.
+// kNumSlots必须是2的幂。如果超过kNumSlots个线程增加计数器，一些线程会共享同一个
+// 槽。这仍然是正确的，因为槽是用原子的fetch_add更新的，但这些线程又会相互竞争。
+// 另一种做法是每个核心一个槽（Linux上的sched_getcpu），这样槽的数量受核心数而不是
+// 线程数的限制，但线程可能在查询自己所在核心和执行增加之间被移动到另一个核心上。
+template<size_t kNumSlots = 64>
+class ShardedCounter {
+    static_assert(kNumSlots > 0 && (kNumSlots & (kNumSlots - 1)) == 0, "kNumSlots must be a power of two");
+
+public:
+    // Adds delta to the calling thread's slot. memory_order_relaxed only
+    // promises that the addition itself is atomic, not that it is ordered
+    // with other memory accesses, which is all a counter needs and is the
+    // cheapest ordering.
+    // 把delta加到调用线程的槽上。memory_order_relaxed只保证加法本身是原子的，不保证
+    // 它与其他内存访问之间的顺序，这正是计数器所需要的，也是开销最小的内存序。
+    void Add(int64_t delta) { slots_[ThreadIndex() & (kNumSlots - 1)].value.fetch_add(delta, std::memory_order_relaxed); }
+
+    void Increment() { Add(1); }
+
+    // Returns the sum of all slots. While other threads are still adding, the
+    // result is some value the counter passed through recently, not an exact
+    // snapshot. Once they have finished (for example after join), it is
+    // exact.
+    // 返回所有槽的和。当其他线程仍在增加时，结果是计数器最近经过的某个值，而不是一个
+    // 精确的快照。一旦它们结束（例如在join之后），结果就是精确的。
+    int64_t Read() const {
+        int64_t sum = 0;
+        for (const Slot &slot: slots_) {
+            sum += slot.value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    static constexpr size_t slot_count() { return kNumSlots; }
+
+private:
+    // alignas pads every slot to a full cache line, so that two threads
+    // incrementing neighbouring slots never invalidate each other's cache
+    // line ("false sharing").
+    // alignas把每个槽填充到一整个缓存行，这样两个增加相邻槽的线程永远不会使对方的
+    // 缓存行失效（"伪共享"）。
+    struct alignas(kCacheLineSize) Slot {
+        std::atomic<int64_t> value{0};
+    };
+
+    std::array<Slot, kNumSlots> slots_;
+};
+
+// The global counter from mutex.cpp, now sharded and without a mutex.
+// mutex.cpp中的全局计数器，现在是分片的，并且不需要互斥锁。
+ShardedCounter<> count;
+
+// The add_count function increments the count variable by 1, atomically.
+// add_count函数以原子方式将计数变量增加1。
+void add_count() { count.Increment(); }
+
+// Runs num_threads threads that together increment a counter total_ops times,
+// and returns the throughput in million increments per second.
+// 运行num_threads个线程，它们一共增加计数器total_ops次，返回以每秒百万次增加计的
+// 吞吐量。
+template<typename IncrementFn>
+double RunIncrements(int num_threads, int total_ops, IncrementFn increment) {
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&increment, num_threads, total_ops] {
+            for (int i = 0; i < total_ops / num_threads; i++) {
+                increment();
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return total_ops / std::chrono::duration<double, std::micro>(stop - start).count();
+}
+
+// Compares an int under a std::mutex, a std::atomic<int64_t> with fetch_add
+// and a ShardedCounter from 1 to 64 threads. The sharded counter only pulls
+// ahead once threads run on different cores at the same time; on a single
+// core there is no cache line to bounce, and the three mostly measure the
+// cost of one increment.
+// 在1到64个线程下比较std::mutex保护的int、使用fetch_add的std::atomic<int64_t>和
+// ShardedCounter。只有当线程同时运行在不同的核心上时，分片计数器才会领先；在单个
+// 核心上没有来回传递的缓存行，三者测量的主要是一次增加的开销。
+void RunBenchmark() {
+    const int total_ops = 1 << 22;
+    std::cout << "Throughput in Mops/s (" << std::thread::hardware_concurrency() << " hardware threads):\n";
+    for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+        int64_t mutex_count = 0;
+        std::mutex m;
+        std::atomic<int64_t> atomic_count{0};
+        ShardedCounter<> sharded_count;
+
+        double mutex_mops = RunIncrements(num_threads, total_ops, [&mutex_count, &m] {
+            std::scoped_lock lock(m);
+            mutex_count++;
+        });
+        double atomic_mops = RunIncrements(num_threads, total_ops, [&atomic_count] {
+            atomic_count.fetch_add(1, std::memory_order_relaxed);
+        });
+        double sharded_mops = RunIncrements(num_threads, total_ops, [&sharded_count] { sharded_count.Increment(); });
+
+        // All three must have counted every increment.
+        // 三者都必须计入每一次增加。
+        int64_t expected = static_cast<int64_t>(total_ops / num_threads) * num_threads;
+        if (mutex_count != expected || atomic_count.load() != expected || sharded_count.Read() != expected) {
+            std::cout << "    Lost increments with " << num_threads << " threads!\n";
+        }
+        std::cout << "  " << num_threads << " threads: mutex " << mutex_mops << ", atomic fetch_add " << atomic_mops
+                  << ", sharded " << sharded_mops << "\n";
+    }
+}
+
+// The main method runs the same two add_count threads as mutex.cpp, then
+// reads the counter and runs the benchmark.
+// main方法运行与mutex.cpp中相同的两个add_count线程，然后读取计数器并运行基准测试。
+int main() {
+    std::thread t1(add_count);
+    std::thread t2(add_count);
+    t1.join();
+    t2.join();
+
+    std::cout << "Printing count: " << count.Read() << " (" << count.slot_count() << " slots of " << sizeof(int64_t)
+              << " bytes, each padded to " << kCacheLineSize << " bytes)" << std::endl;
+
+    RunBenchmark();
+
+    return 0;
+}
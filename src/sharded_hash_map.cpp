@@ -0,0 +1,381 @@
+/**
+ * @file sharded_hash_map.cpp
+ * @brief Tutorial code for a concurrent hash map split into locked shards.
+ * @brief 划分为多个带锁分片的并发哈希映射的教程代码。
+ */
+
+// The simplest way to share a std::unordered_map (unordered_maps.cpp) between
+// threads is to protect it with one std::mutex (mutex.cpp). Every lookup and
+// every update then waits for the same lock, so adding threads adds waiting,
+// not throughput. Even a std::shared_mutex (rwlock.cpp) does not help much:
+// readers no longer wait for each other, but they all still write the same
+// reader count inside the lock, and that cache line bounces between cores.
+// 在线程之间共享一个std::unordered_map（unordered_maps.cpp）最简单的方法是用一个
+// std::mutex（mutex.cpp）保护它。这样每次查找和每次更新都在等待同一把锁，所以增加
+// 线程增加的是等待，而不是吞吐量。即使换成std::shared_mutex（rwlock.cpp）也帮助
+// 不大：读者之间不再互相等待，但它们仍然都要写锁内部的同一个读者计数，这个缓存行
+// 会在核心之间来回传递。
+
+// ShardedHashMap splits the keys into kNumShards independent std::unordered_maps
+// ("shards"), each with its own std::shared_mutex. A key's hash picks its
+// shard, so two threads only contend when they touch keys in the same shard.
+// Each shard is aligned to its own cache line, so that locking one shard never
+// invalidates the cache line of a neighbouring shard's lock ("false sharing").
+// ShardedHashMap把键划分到kNumShards个独立的std::unordered_map（"分片"）中，每个
+// 分片都有自己的std::shared_mutex。键的哈希值选择它所在的分片，所以只有当两个线程
+// 访问同一个分片中的键时才会竞争。每个分片都对齐到自己的缓存行，这样锁住一个分片
+// 永远不会使相邻分片的锁所在的缓存行失效（"伪共享"）。
+
+// Because other threads may change the map at any time, the interface differs
+// from std::unordered_map: there are no iterators and no references into the
+// map. find returns a copy, and read-modify-write operations such as upsert
+// and compute_if_absent run entirely under the shard's lock, so they are
+// atomic.
+// 因为其他线程可能随时修改映射，所以接口与std::unordered_map不同：没有迭代器，
+// 也没有指向映射内部的引用。find返回一个副本，而upsert和compute_if_absent这类
+// 读-改-写操作完全在分片的锁下运行，所以它们是原子的。
+
+// Includes std::array.
+// 包含std::array。
+#include <array>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as uint64_t.
+// 包含uint64_t等定宽整数类型。
+#include <cstdint>
+// Includes std::hash.
+// 包含std::hash。
+#include <functional>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes the mutex library header.
+// 包含互斥锁库头文件。
+#include <mutex>
+// Includes std::optional, the return type of find.
+// 包含std::optional，find的返回类型。
+#include <optional>
+// Includes the random number library, used by the benchmark.
+// 包含随机数库，供基准测试使用。
+#include <random>
+// Includes the shared mutex library header.
+// 包含共享互斥锁库头文件。
+#include <shared_mutex>
+// Includes the C++ string library.
+// 包含C++字符串库。
+#include <string>
+// Includes the thread library header.
+// 包含线程库头文件。
+#include <thread>
+// Includes the unordered_map container library header.
+// 包含unordered_map容器库头文件。
+#include <unordered_map>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+
+// The size of a cache line on x86 and most ARM cores. C++17 has
+// std::hardware_destructive_interference_size for this, but not every
+// compiler provides it yet.
+// x86和大多数ARM核心上缓存行的大小。C++17为此提供了
+// std::hardware_destructive_interference_size，但并不是每个编译器都已经支持它。
+constexpr size_t kCacheLineSize = 64;
+
+// kNumShards must be a power of two. More shards means less contention but a
+// bit more memory and a slower size() and for_each(). A few times the number
+// of cores is a good choice.
+// kNumShards必须是2的幂。更多的分片意味着更少的竞争，但会多占一点内存，size()和
+// for_each()也会慢一些。选择核心数的几倍是一个不错的选择。
+template<typename Key, typename Value, typename Hash = std::hash<Key>, size_t kNumShards = 64>
+class ShardedHashMap {
+    static_assert(kNumShards > 0 && (kNumShards & (kNumShards - 1)) == 0, "kNumShards must be a power of two");
+
+public:
+    static constexpr size_t shard_count() { return kNumShards; }
+
+    // Returns a copy of the value for key, or std::nullopt if key is absent.
+    // A reference would not be safe: another thread could erase the pair as
+    // soon as the lock is released.
+    // 返回key对应值的副本，如果key不存在则返回std::nullopt。返回引用是不安全的：
+    // 锁一释放，另一个线程就可能删除这个键值对。
+    std::optional<Value> find(const Key &key) const {
+        const Shard &shard = ShardFor(key);
+        std::shared_lock lk(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    size_t count(const Key &key) const {
+        const Shard &shard = ShardFor(key);
+        std::shared_lock lk(shard.mutex);
+        return shard.map.count(key);
+    }
+
+    // Inserts the pair if key is absent. Returns true if it was inserted.
+    // 如果key不存在则插入键值对。如果插入了则返回true。
+    bool insert(const Key &key, const Value &value) {
+        Shard &shard = ShardFor(key);
+        std::unique_lock lk(shard.mutex);
+        return shard.map.emplace(key, value).second;
+    }
+
+    // If key is absent, inserts (key, value). Otherwise calls update(Value &)
+    // on the stored value. Both happen under the shard's exclusive lock, so
+    // concurrent upserts of the same key never lose an update. Returns true
+    // if the pair was inserted.
+    // 如果key不存在，插入(key, value)。否则对存储的值调用update(Value &)。两者都
+    // 在分片的独占锁下进行，所以对同一个键的并发upsert永远不会丢失更新。如果插入
+    // 了键值对则返回true。
+    template<typename Update>
+    bool upsert(const Key &key, const Value &value, Update update) {
+        Shard &shard = ShardFor(key);
+        std::unique_lock lk(shard.mutex);
+        auto [it, inserted] = shard.map.try_emplace(key, value);
+        if (!inserted) {
+            update(it->second);
+        }
+        return inserted;
+    }
+
+    // Returns the value for key. If key is absent, first stores make() for it.
+    // make runs at most once per key even when many threads ask for the same
+    // missing key at once, which makes this a safe way to build a cache. The
+    // common hit case only takes the shared lock.
+    // 返回key对应的值。如果key不存在，先为它存入make()的结果。即使许多线程同时请求
+    // 同一个缺失的键，make对每个键也最多运行一次，这使它成为构建缓存的安全方式。
+    // 常见的命中情况只需要共享锁。
+    template<typename Make>
+    Value compute_if_absent(const Key &key, Make make) {
+        Shard &shard = ShardFor(key);
+        {
+            std::shared_lock lk(shard.mutex);
+            auto it = shard.map.find(key);
+            if (it != shard.map.end()) {
+                return it->second;
+            }
+        }
+        // Another thread may have inserted the key between the two locks, so
+        // we look again before calling make.
+        // 在两次加锁之间另一个线程可能已经插入了这个键，所以我们在调用make之前
+        // 再查找一次。
+        std::unique_lock lk(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) {
+            it = shard.map.emplace(key, make()).first;
+        }
+        return it->second;
+    }
+
+    size_t erase(const Key &key) {
+        Shard &shard = ShardFor(key);
+        std::unique_lock lk(shard.mutex);
+        return shard.map.erase(key);
+    }
+
+    // Sums the shard sizes. Other threads may change the map while we count,
+    // so the result is only exact if there are no concurrent writers.
+    // 对各分片的大小求和。在我们计数时其他线程可能修改映射，所以只有在没有并发
+    // 写者时结果才是精确的。
+    size_t size() const {
+        size_t total = 0;
+        for (const Shard &shard: shards_) {
+            std::shared_lock lk(shard.mutex);
+            total += shard.map.size();
+        }
+        return total;
+    }
+
+    // Calls func(const Key &, const Value &) on every pair of one shard while
+    // holding that shard's shared lock. func must not call back into the map,
+    // since a write to the same shard would deadlock.
+    // 在持有某个分片的共享锁时，对该分片的每个键值对调用
+    // func(const Key &, const Value &)。func不能回调这个映射，因为对同一个分片的
+    // 写入会导致死锁。
+    template<typename Func>
+    void ForEachInShard(size_t shard_index, Func func) const {
+        const Shard &shard = shards_[shard_index];
+        std::shared_lock lk(shard.mutex);
+        for (const auto &[key, value]: shard.map) {
+            func(key, value);
+        }
+    }
+
+    // Visits every pair, one shard at a time. Each shard is a consistent
+    // snapshot, but the map as a whole is not: a pair moved between shards
+    // (erased from one and inserted in another) may be seen twice or not at
+    // all. Threads can split the work by calling ForEachInShard on disjoint
+    // shard ranges.
+    // 访问每个键值对，一次一个分片。每个分片都是一个一致的快照，但整个映射不是：在
+    // 分片之间移动的键值对（从一个中删除并插入另一个）可能被看到两次或者根本看不到。
+    // 多个线程可以通过在不相交的分片范围上调用ForEachInShard来分担工作。
+    template<typename Func>
+    void for_each(Func func) const {
+        for (size_t i = 0; i < kNumShards; i++) {
+            ForEachInShard(i, func);
+        }
+    }
+
+private:
+    // alignas rounds sizeof(Shard) up to a whole number of cache lines, so
+    // no two shards' mutexes share a cache line.
+    // alignas把sizeof(Shard)向上取整到整数个缓存行，所以任何两个分片的互斥锁都
+    // 不会共享一个缓存行。
+    struct alignas(kCacheLineSize) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<Key, Value, Hash> map;
+    };
+
+    // std::unordered_map picks a bucket from the low bits of the hash, and
+    // std::hash for integers is often the identity. Picking the shard from the
+    // same low bits would leave every key in a shard with the same low bits,
+    // so we pick it from the top bits of a multiplicative (Fibonacci) hash.
+    // std::unordered_map用哈希值的低位选择桶，而整数的std::hash通常是恒等函数。
+    // 如果用同样的低位选择分片，那么一个分片中所有键的低位都会相同，所以我们用
+    // 乘法（斐波那契）哈希的高位来选择分片。
+    static size_t ShardIndex(size_t hash) {
+        if constexpr (kNumShards == 1) {
+            return 0;
+        } else {
+            constexpr int kShardBits = __builtin_ctzll(kNumShards);
+            return static_cast<size_t>((static_cast<uint64_t>(hash) * 0x9e3779b97f4a7c15ULL) >> (64 - kShardBits));
+        }
+    }
+
+    Shard &ShardFor(const Key &key) { return shards_[ShardIndex(Hash()(key))]; }
+    const Shard &ShardFor(const Key &key) const { return shards_[ShardIndex(Hash()(key))]; }
+
+    std::array<Shard, kNumShards> shards_;
+};
+
+// The baseline we are replacing: one std::unordered_map behind one std::mutex.
+// 我们要替换的基线：一个std::mutex后面的一个std::unordered_map。
+class MutexMap {
+public:
+    size_t count(const std::string &key) {
+        std::scoped_lock lk(m_);
+        return map_.count(key);
+    }
+    template<typename Update>
+    bool upsert(const std::string &key, int value, Update update) {
+        std::scoped_lock lk(m_);
+        auto [it, inserted] = map_.try_emplace(key, value);
+        if (!inserted) {
+            update(it->second);
+        }
+        return inserted;
+    }
+
+private:
+    std::mutex m_;
+    std::unordered_map<std::string, int> map_;
+};
+
+// Runs total_ops operations split across num_threads threads. read_percent
+// of them are count calls and the rest are upserts that increment the value.
+// Returns throughput in million operations per second.
+// 运行total_ops次操作，分摊到num_threads个线程上。其中read_percent是count调用，
+// 其余是把值加一的upsert。返回以每秒百万次操作计的吞吐量。
+template<typename Map>
+double RunMix(Map &map, const std::vector<std::string> &keys, int num_threads, int read_percent, int total_ops) {
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&map, &keys, t, num_threads, read_percent, total_ops] {
+            std::mt19937 rng(t);
+            for (int i = 0; i < total_ops / num_threads; i++) {
+                const std::string &key = keys[rng() % keys.size()];
+                if (static_cast<int>(rng() % 100) < read_percent) {
+                    map.count(key);
+                } else {
+                    map.upsert(key, 1, [](int &value) { value++; });
+                }
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return total_ops / std::chrono::duration<double, std::micro>(stop - start).count();
+}
+
+// Compares the sharded map with the single-mutex map from 1 to 64 threads.
+// The sharded map can only scale with threads up to the number of hardware
+// threads; past that, extra threads just take turns on the same cores.
+// 在1到64个线程下比较分片映射与单互斥锁映射。分片映射的吞吐量最多只能随线程数
+// 扩展到硬件线程数；超过之后，多出来的线程只是在相同的核心上轮流运行。
+void RunBenchmark() {
+    const int key_range = 1 << 14;
+    const int total_ops = 1 << 19;
+    std::vector<std::string> keys;
+    for (int i = 0; i < key_range; i++) {
+        keys.push_back("key" + std::to_string(i));
+    }
+    std::cout << "Throughput in Mops/s (" << std::thread::hardware_concurrency() << " hardware threads):\n";
+    for (int read_percent: {95, 50}) {
+        std::cout << "  " << read_percent << "% reads:\n";
+        for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+            ShardedHashMap<std::string, int> sharded_map;
+            MutexMap mutex_map;
+            for (int i = 0; i < key_range; i += 2) {
+                sharded_map.insert(keys[i], 0);
+                mutex_map.upsert(keys[i], 0, [](int &) {});
+            }
+            double sharded_mops = RunMix(sharded_map, keys, num_threads, read_percent, total_ops);
+            double mutex_mops = RunMix(mutex_map, keys, num_threads, read_percent, total_ops);
+            std::cout << "    " << num_threads << " threads: sharded " << sharded_mops
+                      << ", std::unordered_map + mutex " << mutex_mops << "\n";
+        }
+    }
+}
+
+int main() {
+    // Four threads count words into the same map. upsert inserts a count of
+    // 1 for a new word and increments the count of a word already present,
+    // atomically, so no increment is lost.
+    // 四个线程把单词计数到同一个映射中。upsert为新单词插入计数1，并原子地增加已有
+    // 单词的计数，所以不会丢失任何一次增加。
+    ShardedHashMap<std::string, int> word_counts;
+    std::vector<std::string> words = {"spam", "eggs", "spam", "bacon", "spam", "eggs"};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&word_counts, &words] {
+            for (const std::string &word: words) {
+                word_counts.upsert(word, 1, [](int &count) { count++; });
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+
+    std::optional<int> spam = word_counts.find("spam");
+    if (spam.has_value()) {
+        std::cout << "Word spam was counted " << *spam << " times.\n";
+    }
+    if (word_counts.count("garlic rice") == 0) {
+        std::cout << "Word garlic rice was never counted.\n";
+    }
+
+    // compute_if_absent only calls the lambda for a missing key.
+    // compute_if_absent只对缺失的键调用lambda。
+    int computed = word_counts.compute_if_absent("garlic rice", [] { return 42; });
+    int existing = word_counts.compute_if_absent("eggs", [] { return -1; });
+    std::cout << "compute_if_absent returned " << computed << " for garlic rice and " << existing << " for eggs.\n";
+
+    word_counts.erase("bacon");
+
+    // Iteration visits one shard at a time, under that shard's shared lock.
+    // 遍历一次访问一个分片，并持有该分片的共享锁。
+    std::cout << "Printing the " << word_counts.size() << " words in " << word_counts.shard_count() << " shards:\n";
+    word_counts.for_each([](const std::string &word, int count) { std::cout << "(" << word << ", " << count << "), "; });
+    std::cout << "\n";
+
+    RunBenchmark();
+
+    return 0;
+}
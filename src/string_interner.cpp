@@ -0,0 +1,476 @@
+/**
+ * @file string_interner.cpp
+ * @brief Tutorial code for an arena-backed string interner and a map keyed by
+ * interned IDs.
+ * @brief 基于内存池（arena）的字符串驻留器以及以驻留ID为键的映射的教程代码。
+ */
+
+// Every std::string key in unordered_maps.cpp that is too long for the
+// small-string buffer (15 bytes with libstdc++) owns a separate heap buffer.
+// A std::unordered_map<std::string, int> therefore makes two allocations per
+// key: one for the node and one for the string. With millions of short keys,
+// the malloc headers and rounding cost more than the keys themselves, and
+// every equality check has to compare the bytes.
+// unordered_maps.cpp中每个对小字符串缓冲区（libstdc++中为15字节）来说太长的
+// std::string键都拥有一个单独的堆缓冲区。因此std::unordered_map<std::string, int>
+// 每个键要进行两次分配：一次给节点，一次给字符串。当有几百万个短键时，malloc头部
+// 和取整的开销比键本身还大，而且每次相等性检查都要比较字节。
+
+// Interning stores each distinct string once and names it by a small integer
+// ID. StringArena copies the bytes into large contiguous blocks, so a million
+// keys take a few dozen allocations. StringInterner hands out dense 32-bit IDs
+// (0, 1, 2, ...) and turns an ID back into a std::string_view that stays valid
+// for the lifetime of the interner. Once keys are IDs, InternedMap can hash
+// and compare them as plain integers.
+// 驻留（interning）把每个不同的字符串只存储一次，并用一个小整数ID来命名它。
+// StringArena把字节复制到大的连续块中，所以一百万个键只需要几十次分配。
+// StringInterner分发稠密的32位ID（0、1、2……），并能把ID变回一个在驻留器生命期内
+// 一直有效的std::string_view。一旦键变成了ID，InternedMap就可以把它们当作普通整数
+// 来哈希和比较。
+
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes fixed width integer types such as uint32_t.
+// 包含uint32_t等定宽整数类型。
+#include <cstdint>
+// Includes std::malloc and std::free, used by the counting operator new.
+// 包含std::malloc和std::free，供计数的operator new使用。
+#include <cstdlib>
+// Includes std::memcpy.
+// 包含std::memcpy。
+#include <cstring>
+// Includes std::hash.
+// 包含std::hash。
+#include <functional>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes std::unique_ptr.
+// 包含std::unique_ptr。
+#include <memory>
+// Includes std::bad_alloc.
+// 包含std::bad_alloc。
+#include <new>
+// Includes the C++ string library.
+// 包含C++字符串库。
+#include <string>
+// Includes std::string_view.
+// 包含std::string_view。
+#include <string_view>
+// Includes the unordered_map container library header, for comparison.
+// 包含unordered_map容器库头文件，用于对比。
+#include <unordered_map>
+// Includes std::swap.
+// 包含std::swap。
+#include <utility>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+
+// StringArena copies strings into 64 KB blocks and never moves or frees them
+// until the arena is destroyed, so the returned views stay valid. Strings
+// larger than a quarter of a block get a block of their own, so that they do
+// not waste the rest of the current block.
+// StringArena把字符串复制到64 KB的块中，并且在arena销毁之前从不移动或释放它们，
+// 所以返回的视图一直有效。大于块大小四分之一的字符串会得到一个单独的块，这样它们
+// 就不会浪费当前块的剩余空间。
+class StringArena {
+public:
+    static constexpr size_t kBlockSize = 64 * 1024;
+
+    std::string_view Store(std::string_view s) {
+        if (s.empty()) {
+            return {};
+        }
+        char *dest;
+        if (s.size() > kBlockSize / 4) {
+            dest = Allocate(s.size());
+        } else {
+            if (static_cast<size_t>(end_ - pos_) < s.size()) {
+                pos_ = Allocate(kBlockSize);
+                end_ = pos_ + kBlockSize;
+            }
+            dest = pos_;
+            pos_ += s.size();
+        }
+        std::memcpy(dest, s.data(), s.size());
+        return std::string_view(dest, s.size());
+    }
+
+    size_t MemoryUsage() const { return reserved_bytes_; }
+
+private:
+    char *Allocate(size_t size) {
+        blocks_.emplace_back(new char[size]);
+        reserved_bytes_ += size;
+        return blocks_.back().get();
+    }
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char *pos_ = nullptr;
+    char *end_ = nullptr;
+    size_t reserved_bytes_ = 0;
+};
+
+// Returns a well mixed 32-bit hash of s.
+// 返回s的一个混合良好的32位哈希值。
+uint32_t HashString(std::string_view s) {
+    uint64_t h = std::hash<std::string_view>()(s);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return static_cast<uint32_t>(h);
+}
+
+constexpr uint32_t kInvalidId = UINT32_MAX;
+
+// StringInterner maps strings to dense IDs and back. The index from string to
+// ID is an open-addressing table (linear probing, at most half full) whose
+// 8-byte slots hold the ID and the string's hash. The hash filters out almost
+// every non-matching slot without touching the string bytes, and it also lets
+// the table grow without rehashing any string.
+// StringInterner把字符串映射到稠密的ID并能反向映射。从字符串到ID的索引是一个开放
+// 寻址表（线性探测，最多半满），它的8字节槽保存ID和字符串的哈希值。哈希值能在不
+// 访问字符串字节的情况下过滤掉几乎所有不匹配的槽，还使表在增长时不需要对任何字符串
+// 重新求哈希。
+class StringInterner {
+public:
+    StringInterner() : slots_(16) {}
+
+    // Returns the ID of s, adding s if it is new.
+    // 返回s的ID，如果s是新的就添加它。
+    uint32_t Intern(std::string_view s) {
+        uint32_t hash = HashString(s);
+        size_t index = Probe(s, hash);
+        if (slots_[index].id != kInvalidId) {
+            return slots_[index].id;
+        }
+        uint32_t id = static_cast<uint32_t>(strings_.size());
+        strings_.push_back(arena_.Store(s));
+        slots_[index] = Slot{hash, id};
+        if (strings_.size() * 2 > slots_.size()) {
+            Grow();
+        }
+        return id;
+    }
+
+    // Returns the ID of s, or kInvalidId if s was never interned.
+    // 返回s的ID，如果s从未被驻留过则返回kInvalidId。
+    uint32_t Find(std::string_view s) const { return slots_[Probe(s, HashString(s))].id; }
+
+    // The string for id. The view stays valid as long as the interner does.
+    // id对应的字符串。只要驻留器存在，这个视图就一直有效。
+    std::string_view Lookup(uint32_t id) const { return strings_[id]; }
+
+    size_t size() const { return strings_.size(); }
+
+    size_t MemoryUsage() const {
+        return arena_.MemoryUsage() + strings_.capacity() * sizeof(std::string_view) + slots_.size() * sizeof(Slot);
+    }
+
+private:
+    struct Slot {
+        uint32_t hash = 0;
+        uint32_t id = kInvalidId;
+    };
+
+    // Returns the slot that holds s, or the empty slot where it would go.
+    // 返回保存s的槽，或者s应该放入的那个空槽。
+    size_t Probe(std::string_view s, uint32_t hash) const {
+        size_t mask = slots_.size() - 1;
+        for (size_t index = hash & mask;; index = (index + 1) & mask) {
+            const Slot &slot = slots_[index];
+            if (slot.id == kInvalidId || (slot.hash == hash && strings_[slot.id] == s)) {
+                return index;
+            }
+        }
+    }
+
+    void Grow() {
+        std::vector<Slot> old_slots(slots_.size() * 2);
+        std::swap(old_slots, slots_);
+        size_t mask = slots_.size() - 1;
+        for (const Slot &slot: old_slots) {
+            if (slot.id == kInvalidId) {
+                continue;
+            }
+            size_t index = slot.hash & mask;
+            while (slots_[index].id != kInvalidId) {
+                index = (index + 1) & mask;
+            }
+            slots_[index] = slot;
+        }
+    }
+
+    StringArena arena_;
+    std::vector<std::string_view> strings_;
+    std::vector<Slot> slots_;
+};
+
+// InternedMap is a hash map from interned IDs to values. Hashing an ID is one
+// multiplication, and comparing two keys is one integer comparison, no matter
+// how long the strings are. It uses linear probing with backward-shift
+// deletion, so erase leaves no tombstones behind.
+// InternedMap是一个从驻留ID到值的哈希映射。对ID求哈希只是一次乘法，比较两个键只是
+// 一次整数比较，不管字符串有多长。它使用线性探测和向后移位删除，所以erase不会留下
+// 墓碑。
+template<typename Value>
+class InternedMap {
+public:
+    InternedMap() : slots_(16) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Returns a pointer to the value for id, or nullptr if it is absent. The
+    // pointer is invalidated by the next insert.
+    // 返回指向id对应值的指针，如果不存在则返回nullptr。下一次插入会使该指针失效。
+    Value *find(uint32_t id) {
+        Slot &slot = slots_[Probe(id)];
+        return slot.id == kInvalidId ? nullptr : &slot.value;
+    }
+    const Value *find(uint32_t id) const { return const_cast<InternedMap *>(this)->find(id); }
+
+    size_t count(uint32_t id) const { return find(id) == nullptr ? 0 : 1; }
+
+    // Inserts (id, value) if id is absent. Returns true if it was inserted.
+    // 如果id不存在则插入(id, value)。如果插入了则返回true。
+    bool insert(uint32_t id, const Value &value) {
+        size_t index = Probe(id);
+        if (slots_[index].id != kInvalidId) {
+            return false;
+        }
+        slots_[index].id = id;
+        slots_[index].value = value;
+        if (++size_ * 2 > slots_.size()) {
+            Grow();
+        }
+        return true;
+    }
+
+    Value &operator[](uint32_t id) {
+        insert(id, Value());
+        return *find(id);
+    }
+
+    size_t erase(uint32_t id) {
+        size_t mask = slots_.size() - 1;
+        size_t hole = Probe(id);
+        if (slots_[hole].id == kInvalidId) {
+            return 0;
+        }
+        // Move later members of the probe run back into the hole, as long as
+        // that does not move them before their home slot.
+        // 把探测序列中后面的成员移回到空洞中，只要这不会把它们移到它们的初始槽之前。
+        for (size_t next = (hole + 1) & mask; slots_[next].id != kInvalidId; next = (next + 1) & mask) {
+            size_t home = Home(slots_[next].id);
+            if (((next - home) & mask) >= ((next - hole) & mask)) {
+                slots_[hole] = std::move(slots_[next]);
+                hole = next;
+            }
+        }
+        slots_[hole].id = kInvalidId;
+        size_--;
+        return 1;
+    }
+
+    // Calls func(uint32_t id, const Value &) on every pair.
+    // 对每个键值对调用func(uint32_t id, const Value &)。
+    template<typename Func>
+    void for_each(Func func) const {
+        for (const Slot &slot: slots_) {
+            if (slot.id != kInvalidId) {
+                func(slot.id, slot.value);
+            }
+        }
+    }
+
+    size_t MemoryUsage() const { return slots_.size() * sizeof(Slot); }
+
+private:
+    struct Slot {
+        uint32_t id = kInvalidId;
+        Value value = Value();
+    };
+
+    // IDs are dense, so we spread them with a multiplicative (Fibonacci) hash
+    // and use the top bits.
+    // ID是稠密的，所以我们用乘法（斐波那契）哈希把它们打散，并使用最高的几位。
+    size_t Home(uint32_t id) const { return (static_cast<uint64_t>(id) * 0x9e3779b97f4a7c15ULL) >> shift_; }
+
+    size_t Probe(uint32_t id) const {
+        size_t mask = slots_.size() - 1;
+        size_t index = Home(id);
+        while (slots_[index].id != kInvalidId && slots_[index].id != id) {
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    void Grow() {
+        std::vector<Slot> old_slots(slots_.size() * 2);
+        std::swap(old_slots, slots_);
+        shift_--;
+        for (Slot &slot: old_slots) {
+            if (slot.id != kInvalidId) {
+                slots_[Probe(slot.id)] = std::move(slot);
+            }
+        }
+    }
+
+    std::vector<Slot> slots_;
+    int shift_ = 64 - 4;
+    size_t size_ = 0;
+};
+
+// To compare the real cost of each design, including the std::string buffers
+// that no container allocator sees, we replace the global operator new. Each
+// block records its size in a 16-byte header, so we can track the live bytes
+// and the number of live blocks.
+// 为了比较每种设计的真实开销（包括任何容器分配器都看不到的std::string缓冲区），
+// 我们替换了全局的operator new。每个块在一个16字节的头部中记录它的大小，这样我们
+// 就能跟踪存活的字节数和存活的块数。
+size_t live_bytes = 0;
+size_t live_blocks = 0;
+
+void *operator new(size_t size) {
+    void *base = std::malloc(size + 16);
+    if (base == nullptr) {
+        throw std::bad_alloc();
+    }
+    *static_cast<size_t *>(base) = size;
+    live_bytes += size;
+    live_blocks++;
+    return static_cast<char *>(base) + 16;
+}
+
+void operator delete(void *p) noexcept {
+    if (p == nullptr) {
+        return;
+    }
+    void *base = static_cast<char *>(p) - 16;
+    live_bytes -= *static_cast<size_t *>(base);
+    live_blocks--;
+    std::free(base);
+}
+
+void operator delete(void *p, size_t) noexcept { operator delete(p); }
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete[](void *p) noexcept { operator delete(p); }
+void operator delete[](void *p, size_t) noexcept { operator delete(p); }
+
+// Builds a 1M-key std::unordered_map<std::string, int> and the interner plus
+// InternedMap equivalent from keys that are too long for the small-string
+// buffer, and compares their memory and lookup speed. malloc also adds about
+// 16 bytes of its own header to every block, which the block counts show.
+// 用对小字符串缓冲区来说太长的键，构建一个1M个键的std::unordered_map<std::string, int>
+// 以及等价的驻留器加InternedMap，并比较它们的内存和查找速度。malloc还会给每个块加上
+// 大约16字节它自己的头部，块的数量反映了这一点。
+void RunBenchmark() {
+    constexpr size_t kNumKeys = 1'000'000;
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < kNumKeys; i++) {
+        keys.push_back("user_" + std::to_string(i * 7919) + "_session");
+    }
+
+    size_t bytes_before = live_bytes;
+    size_t blocks_before = live_blocks;
+    std::unordered_map<std::string, int> std_map;
+    for (size_t i = 0; i < kNumKeys; i++) {
+        std_map[keys[i]] = static_cast<int>(i);
+    }
+    size_t std_bytes = live_bytes - bytes_before;
+    size_t std_blocks = live_blocks - blocks_before;
+
+    std::vector<uint32_t> ids;
+    ids.reserve(kNumKeys);
+    bytes_before = live_bytes;
+    blocks_before = live_blocks;
+    StringInterner interner;
+    InternedMap<int> interned_map;
+    for (size_t i = 0; i < kNumKeys; i++) {
+        ids.push_back(interner.Intern(keys[i]));
+        interned_map.insert(ids.back(), static_cast<int>(i));
+    }
+    size_t interned_bytes = live_bytes - bytes_before;
+    size_t interned_blocks = live_blocks - blocks_before;
+
+    std::cout << "Memory for " << kNumKeys << " keys (bytes/key, heap blocks):\n";
+    std::cout << "  std::unordered_map<std::string, int>: " << static_cast<double>(std_bytes) / kNumKeys << ", "
+              << std_blocks << "\n";
+    std::cout << "  StringInterner + InternedMap<int>:    " << static_cast<double>(interned_bytes) / kNumKeys
+              << ", " << interned_blocks << "\n";
+
+    // Lookups by string go through the interner once, for example when a
+    // query is parsed. After that, the hot path only handles IDs.
+    // 按字符串的查找只需要经过驻留器一次，例如在解析查询时。之后，热路径只处理ID。
+    size_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kNumKeys; i++) {
+        sum += std_map.find(keys[(i * 31) % kNumKeys])->second;
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kNumKeys; i++) {
+        sum -= *interned_map.find(ids[(i * 31) % kNumKeys]);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kNumKeys; i++) {
+        sum += interner.Find(keys[i]) == ids[i] ? 0 : 1;
+    }
+    std::cout << "Lookup ns/op: std::unordered_map by string "
+              << std::chrono::duration<double, std::nano>(middle - start).count() / kNumKeys
+              << ", InternedMap by ID " << std::chrono::duration<double, std::nano>(stop - middle).count() / kNumKeys
+              << "\n";
+    if (sum != 0) {
+        std::cout << "The interned map disagrees with std::unordered_map!\n";
+    }
+}
+
+int main() {
+    StringInterner interner;
+
+    // Interning the same string twice gives the same ID, so two keys are
+    // equal exactly when their IDs are equal.
+    // 两次驻留同一个字符串会得到相同的ID，所以两个键相等当且仅当它们的ID相等。
+    uint32_t jignesh = interner.Intern("jignesh");
+    uint32_t garlic_rice = interner.Intern("garlic rice");
+    std::string copy = "jignesh";
+    if (interner.Intern(copy) == jignesh) {
+        std::cout << "jignesh was interned once, with ID " << jignesh << ".\n";
+    }
+    std::cout << "ID " << garlic_rice << " is " << interner.Lookup(garlic_rice) << ".\n";
+    if (interner.Find("bacon") == kInvalidId) {
+        std::cout << "bacon was never interned.\n";
+    }
+
+    // InternedMap is used like the std::unordered_map in unordered_maps.cpp,
+    // with IDs in place of strings.
+    // InternedMap的用法类似于unordered_maps.cpp中的std::unordered_map，只是用ID代替
+    // 了字符串。
+    InternedMap<int> map;
+    map.insert(interner.Intern("foo"), 2);
+    map.insert(jignesh, 445);
+    map.insert(interner.Intern("spam"), 1);
+    map.insert(garlic_rice, 3);
+    map[interner.Intern("spam")] = 15;
+
+    if (int *value = map.find(jignesh)) {
+        std::cout << "Found key jignesh with value " << *value << std::endl;
+    }
+    map.erase(garlic_rice);
+    if (map.count(garlic_rice) == 0) {
+        std::cout << "Key garlic rice does not exist in the map.\n";
+    }
+
+    std::cout << "Printing the elements of the map:\n";
+    map.for_each([&interner](uint32_t id, int value) {
+        std::cout << "(" << interner.Lookup(id) << ", " << value << "), ";
+    });
+    std::cout << "\n";
+
+    RunBenchmark();
+
+    return 0;
+}
@@ -0,0 +1,592 @@
+/**
+ * @file thread_pool.cpp
+ * @brief Tutorial code for a work-stealing thread pool.
+ * @brief 工作窃取线程池的教程代码。
+ */
+
+// mutex.cpp, condition_variable.cpp and rwlock.cpp start a new std::thread
+// for every piece of work and join it afterwards. That is fine for a demo,
+// but creating and joining a thread asks the operating system to set up and
+// tear down a stack and a kernel thread, which takes tens of microseconds.
+// When the work itself takes a microsecond, almost all of the time goes into
+// thread creation. std::async does not help much, since common implementations
+// also start a new thread for every call.
+// mutex.cpp、condition_variable.cpp和rwlock.cpp为每一项工作启动一个新的
+// std::thread，之后再join它。这对演示来说没有问题，但创建和join一个线程需要操作
+// 系统建立和拆除一个栈以及一个内核线程，这需要几十微秒。当工作本身只需要一微秒时，
+// 几乎所有的时间都花在了创建线程上。std::async帮助不大，因为常见的实现也会为每次
+// 调用启动一个新线程。
+
+// A thread pool starts a fixed number of worker threads once and hands them
+// tasks. The simplest pool has one task queue protected by a std::mutex, but
+// then every submit and every worker contends on that one mutex. This pool is
+// "work-stealing": every worker has its own double-ended queue (deque). A
+// worker pushes the tasks it creates onto the bottom of its own deque and
+// takes tasks from the bottom too, so it mostly works alone on its own tasks,
+// newest first, while they are still in its cache. Only a worker that has run
+// out of work looks at the other deques, and it steals from the top, the
+// oldest task, which for divide-and-conquer work such as ParallelFor is also
+// the biggest one. Tasks submitted by threads outside the pool go into a
+// shared queue protected by a mutex.
+// 线程池一次性启动固定数量的工作线程，然后把任务交给它们。最简单的线程池有一个由
+// std::mutex保护的任务队列，但那样的话每次提交和每个工作线程都要争用这一个互斥锁。
+// 本线程池是"工作窃取"式的：每个工作线程都有自己的双端队列（deque）。工作线程把它
+// 创建的任务压入自己deque的底部，也从底部取任务，所以它大多数时候独自处理自己的任务，
+// 最新的优先，这时它们还在它的缓存中。只有工作用完的工作线程才会去看其他的deque，
+// 并从顶部窃取，也就是最老的任务，对于ParallelFor这样的分治工作来说，它也是最大的
+// 任务。池外的线程提交的任务进入一个由互斥锁保护的共享队列。
+
+// Includes std::max.
+// 包含std::max。
+#include <algorithm>
+// Includes std::atomic.
+// 包含std::atomic。
+#include <atomic>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes the condition variable library header.
+// 包含条件变量库头文件。
+#include <condition_variable>
+// Includes fixed width integer types such as int64_t.
+// 包含int64_t等定宽整数类型。
+#include <cstdint>
+// Includes the deque container library header.
+// 包含deque容器库头文件。
+#include <deque>
+// Includes std::exception_ptr.
+// 包含std::exception_ptr。
+#include <exception>
+// Includes std::future and std::packaged_task.
+// 包含std::future和std::packaged_task。
+#include <future>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes std::unique_ptr.
+// 包含std::unique_ptr。
+#include <memory>
+// Includes the mutex library header.
+// 包含互斥锁库头文件。
+#include <mutex>
+// Includes std::accumulate.
+// 包含std::accumulate。
+#include <numeric>
+// Includes the random number library, used to pick steal victims.
+// 包含随机数库，用于选择窃取的对象。
+#include <random>
+// Includes std::runtime_error.
+// 包含std::runtime_error。
+#include <stdexcept>
+// Includes the thread library header.
+// 包含线程库头文件。
+#include <thread>
+// Includes std::apply.
+// 包含std::apply。
+#include <tuple>
+// Includes std::invoke_result_t.
+// 包含std::invoke_result_t。
+#include <type_traits>
+// Includes std::move and std::forward.
+// 包含std::move和std::forward。
+#include <utility>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+
+// The size of a cache line on x86 and most ARM cores. C++17 has
+// std::hardware_destructive_interference_size for this, but not every
+// compiler provides it yet.
+// x86和大多数ARM核心上缓存行的大小。C++17为此提供了
+// std::hardware_destructive_interference_size，但并不是每个编译器都已经支持它。
+constexpr size_t kCacheLineSize = 64;
+
+// The Chase-Lev deque ("Dynamic Circular Work-Stealing Deque" by Chase and Lev,
+// with the C++ memory orderings from "Correct and Efficient Work-Stealing for
+// Weak Memory Models" by Lê et al.). Only the owner calls Push and Pop, which
+// work on the bottom end; any thread may call Steal, which works on the top
+// end. Push and Pop take no lock, and only need a compare-and-swap when the
+// deque is down to its last element and a thief might take it at the same
+// time. T must be a pointer, and Pop and Steal return nullptr when they come
+// back empty handed.
+// Chase-Lev双端队列（Chase和Lev的"Dynamic Circular Work-Stealing Deque"，使用
+// Lê等人的"Correct and Efficient Work-Stealing for Weak Memory Models"中的C++内存
+// 顺序）。只有所有者调用Push和Pop，它们操作底端；任何线程都可以调用Steal，它操作
+// 顶端。Push和Pop不加锁，只有当deque只剩最后一个元素、而窃取者可能同时拿走它时，
+// 才需要一次比较并交换。T必须是指针，Pop和Steal空手而归时返回nullptr。
+template<typename T>
+class WorkStealingDeque {
+    static_assert(std::is_pointer_v<T>, "WorkStealingDeque holds pointers");
+
+    // A circular array whose capacity is a power of two. Indices grow forever
+    // and are wrapped with a mask.
+    // 一个容量为2的幂的循环数组。下标一直增长，用掩码进行回绕。
+    struct Array {
+        explicit Array(int64_t capacity) : capacity_(capacity), slots_(new std::atomic<T>[capacity]) {}
+
+        T Get(int64_t index) const { return slots_[index & (capacity_ - 1)].load(std::memory_order_relaxed); }
+        void Put(int64_t index, T value) { slots_[index & (capacity_ - 1)].store(value, std::memory_order_relaxed); }
+
+        Array *Grow(int64_t top, int64_t bottom) const {
+            Array *bigger = new Array(capacity_ * 2);
+            for (int64_t i = top; i < bottom; i++) {
+                bigger->Put(i, Get(i));
+            }
+            return bigger;
+        }
+
+        const int64_t capacity_;
+        std::unique_ptr<std::atomic<T>[]> slots_;
+    };
+
+public:
+    explicit WorkStealingDeque(int64_t capacity = 64) : array_(new Array(capacity)) {
+        arrays_.emplace_back(array_.load());
+    }
+
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    void Push(T value) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Array *array = array_.load(std::memory_order_relaxed);
+        if (bottom - top > array->capacity_ - 1) {
+            // A thief may still be reading the old array, so it is kept in
+            // arrays_ until the deque is destroyed instead of being freed.
+            // 窃取者可能仍在读取旧数组，所以它被保存在arrays_中直到deque被销毁，
+            // 而不是立即释放。
+            array = array->Grow(top, bottom);
+            arrays_.emplace_back(array);
+            array_.store(array, std::memory_order_release);
+        }
+        array->Put(bottom, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    // The owner first claims the bottom element by decrementing bottom_ and
+    // then looks at top_. The sequentially consistent fence makes sure that a
+    // concurrent thief either sees the smaller bottom_ or has already moved
+    // top_ where the owner can see it.
+    // 所有者首先通过减小bottom_来占有底部元素，然后再查看top_。顺序一致的栅栏确保
+    // 并发的窃取者要么看到了变小的bottom_，要么已经移动了top_并且所有者能看到它。
+    T Pop() {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Array *array = array_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T value = array->Get(bottom);
+        if (top == bottom) {
+            // The last element: race the thieves for it.
+            // 最后一个元素：和窃取者们抢它。
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                value = nullptr;
+            }
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    T Steal() {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return nullptr;
+        }
+        T value = array_.load(std::memory_order_acquire)->Get(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return value;
+    }
+
+private:
+    // top_ is written by thieves and bottom_ by the owner, so they live on
+    // separate cache lines.
+    // top_由窃取者写入，bottom_由所有者写入，所以它们位于不同的缓存行上。
+    alignas(kCacheLineSize) std::atomic<int64_t> top_{0};
+    alignas(kCacheLineSize) std::atomic<int64_t> bottom_{0};
+    std::atomic<Array *> array_;
+    std::vector<std::unique_ptr<Array>> arrays_;
+};
+
+// ThreadPool runs tasks on a fixed number of worker threads. Submit returns a
+// std::future for the task's result, and ParallelFor splits a loop into
+// tasks. Waiting on a future from inside a task ties up that worker, and can
+// deadlock once every worker waits; ParallelFor instead runs other tasks while
+// it waits, so it can be nested.
+// ThreadPool在固定数量的工作线程上运行任务。Submit返回任务结果的std::future，
+// ParallelFor把一个循环拆分成任务。在任务内部等待一个future会占住这个工作线程，
+// 一旦所有工作线程都在等待就会死锁；而ParallelFor在等待时会运行其他任务，所以它
+// 可以嵌套使用。
+class ThreadPool {
+    struct Task {
+        virtual ~Task() = default;
+        virtual void Run() = 0;
+    };
+
+    template<typename Fn>
+    struct FnTask : Task {
+        explicit FnTask(Fn fn) : fn_(std::move(fn)) {}
+        void Run() override { fn_(); }
+        Fn fn_;
+    };
+
+    struct alignas(kCacheLineSize) Worker {
+        WorkStealingDeque<Task *> deque_;
+        std::thread thread_;
+    };
+
+    // Shared by the tasks of one ParallelFor call.
+    // 由一次ParallelFor调用的所有任务共享。
+    struct ForState {
+        std::atomic<size_t> remaining_;
+        std::mutex error_mutex_;
+        std::exception_ptr error_;
+    };
+
+public:
+    explicit ThreadPool(size_t num_workers = std::max(1u, std::thread::hardware_concurrency())) {
+        for (size_t i = 0; i < num_workers; i++) {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+        for (size_t i = 0; i < num_workers; i++) {
+            workers_[i]->thread_ = std::thread([this, i] { WorkerLoop(i); });
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Runs the tasks that are still queued, then stops the workers.
+    // 运行仍在队列中的任务，然后停止工作线程。
+    ~ThreadPool() {
+        {
+            std::scoped_lock lock(sleep_mutex_);
+            stop_ = true;
+        }
+        wake_cv_.notify_all();
+        for (std::unique_ptr<Worker> &worker: workers_) {
+            worker->thread_.join();
+        }
+    }
+
+    size_t num_workers() const { return workers_.size(); }
+
+    // Runs fn(args...) on a worker. Exceptions are stored in the future, as
+    // with std::async.
+    // 在一个工作线程上运行fn(args...)。与std::async一样，异常被保存在future中。
+    template<typename Fn, typename... Args>
+    std::future<std::invoke_result_t<std::decay_t<Fn>, std::decay_t<Args>...>> Submit(Fn &&fn, Args &&...args) {
+        using Result = std::invoke_result_t<std::decay_t<Fn>, std::decay_t<Args>...>;
+        std::packaged_task<Result()> task(
+                [fn = std::forward<Fn>(fn), args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                    return std::apply(std::move(fn), std::move(args));
+                });
+        std::future<Result> future = task.get_future();
+        Push(new FnTask<std::packaged_task<Result()>>(std::move(task)));
+        return future;
+    }
+
+    // Calls fn(i) for every i in [begin, end) and returns when all calls are
+    // done. The range is halved until pieces have at most grain elements; one
+    // half is pushed for a thief and the other is split further. If a call
+    // throws, the first exception is rethrown here.
+    // 对[begin, end)中的每个i调用fn(i)，并在所有调用完成后返回。范围被不断对半
+    // 拆分，直到每一块最多有grain个元素；一半被压入队列等待窃取者，另一半继续拆分。
+    // 如果某次调用抛出异常，第一个异常会在这里被重新抛出。
+    template<typename Fn>
+    void ParallelFor(size_t begin, size_t end, size_t grain, const Fn &fn) {
+        if (begin >= end) {
+            return;
+        }
+        ForState state;
+        state.remaining_.store(end - begin);
+        RunRange(begin, end, std::max<size_t>(grain, 1), fn, state);
+        while (state.remaining_.load(std::memory_order_acquire) != 0) {
+            if (!RunOneTask()) {
+                std::this_thread::yield();
+            }
+        }
+        if (state.error_) {
+            std::rethrow_exception(state.error_);
+        }
+    }
+
+private:
+    template<typename Fn>
+    void RunRange(size_t begin, size_t end, size_t grain, const Fn &fn, ForState &state) {
+        while (end - begin > grain) {
+            size_t mid = begin + (end - begin) / 2;
+            Push(new FnTask([this, mid, end, grain, &fn, &state] { RunRange(mid, end, grain, fn, state); }));
+            end = mid;
+        }
+        try {
+            for (size_t i = begin; i < end; i++) {
+                fn(i);
+            }
+        } catch (...) {
+            std::scoped_lock lock(state.error_mutex_);
+            if (!state.error_) {
+                state.error_ = std::current_exception();
+            }
+        }
+        state.remaining_.fetch_sub(end - begin, std::memory_order_release);
+    }
+
+    // Returns the index of the calling thread's worker in this pool, or
+    // num_workers() if the caller is not one of its workers.
+    // 返回调用线程在本池中的工作线程下标；如果调用者不是本池的工作线程，则返回
+    // num_workers()。
+    size_t MyIndex() const { return current_pool_ == this ? current_index_ : workers_.size(); }
+
+    // queued_ is incremented before sleepers_ is read, and a worker increments
+    // sleepers_ before it checks queued_, so either the worker sees the new
+    // task or the submitter sees the sleeping worker and wakes it.
+    // queued_在读取sleepers_之前增加，而工作线程在检查queued_之前增加sleepers_，
+    // 所以要么工作线程看到新任务，要么提交者看到正在睡眠的工作线程并唤醒它。
+    void Push(Task *task) {
+        size_t index = MyIndex();
+        if (index < workers_.size()) {
+            workers_[index]->deque_.Push(task);
+        } else {
+            std::scoped_lock lock(injection_mutex_);
+            injection_queue_.push_back(task);
+        }
+        queued_.fetch_add(1);
+        if (sleepers_.load() > 0) {
+            std::scoped_lock lock(sleep_mutex_);
+            wake_cv_.notify_one();
+        }
+    }
+
+    // Looks for a task in the caller's own deque, then in the shared queue,
+    // then in the other deques starting from a random victim.
+    // 依次在调用者自己的deque、共享队列以及从一个随机对象开始的其他deque中寻找任务。
+    Task *FindTask() {
+        size_t index = MyIndex();
+        Task *task = nullptr;
+        if (index < workers_.size()) {
+            task = workers_[index]->deque_.Pop();
+        }
+        if (task == nullptr) {
+            std::scoped_lock lock(injection_mutex_);
+            if (!injection_queue_.empty()) {
+                task = injection_queue_.front();
+                injection_queue_.pop_front();
+            }
+        }
+        if (task == nullptr) {
+            thread_local std::minstd_rand rng(std::random_device{}());
+            size_t start = rng() % workers_.size();
+            for (size_t i = 0; i < workers_.size() && task == nullptr; i++) {
+                size_t victim = (start + i) % workers_.size();
+                if (victim != index) {
+                    task = workers_[victim]->deque_.Steal();
+                }
+            }
+        }
+        if (task != nullptr) {
+            queued_.fetch_sub(1);
+        }
+        return task;
+    }
+
+    bool RunOneTask() {
+        Task *task = FindTask();
+        if (task == nullptr) {
+            return false;
+        }
+        task->Run();
+        delete task;
+        return true;
+    }
+
+    // A worker that finds no task tries a few more times, yielding in
+    // between, before it goes to sleep on wake_cv_. Sleeping and waking take
+    // system calls, so the short spin keeps back-to-back tasks cheap.
+    // 找不到任务的工作线程会再尝试几次（中间让出CPU），然后才在wake_cv_上睡眠。
+    // 睡眠和唤醒需要系统调用，所以短暂的自旋让连续到来的任务保持低开销。
+    void WorkerLoop(size_t index) {
+        current_pool_ = this;
+        current_index_ = index;
+        const int spin_rounds = 64;
+        while (true) {
+            bool ran = false;
+            for (int i = 0; i < spin_rounds && !ran; i++) {
+                ran = RunOneTask();
+                if (!ran) {
+                    std::this_thread::yield();
+                }
+            }
+            if (ran) {
+                continue;
+            }
+            std::unique_lock lock(sleep_mutex_);
+            sleepers_.fetch_add(1);
+            wake_cv_.wait(lock, [this] { return queued_.load() > 0 || stop_; });
+            sleepers_.fetch_sub(1);
+            if (stop_ && queued_.load() == 0) {
+                return;
+            }
+        }
+    }
+
+    inline static thread_local const ThreadPool *current_pool_ = nullptr;
+    inline static thread_local size_t current_index_ = 0;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex injection_mutex_;
+    std::deque<Task *> injection_queue_;
+    alignas(kCacheLineSize) std::atomic<int64_t> queued_{0};
+    std::atomic<int> sleepers_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_cv_;
+    bool stop_ = false;
+};
+
+// The program of mutex.cpp, with add_count submitted to a pool instead of
+// run on new threads.
+// mutex.cpp中的程序，只是add_count被提交给线程池，而不是在新线程上运行。
+int count = 0;
+std::mutex m;
+
+void add_count() {
+    m.lock();
+    count += 1;
+    m.unlock();
+}
+
+// Returns the average time in microseconds to start one empty task and wait
+// for it, one task at a time, which is the pattern of the tutorial files.
+// 返回启动一个空任务并等待它完成的平均时间（微秒），每次一个任务，这就是教程文件
+// 中的模式。
+template<typename Func>
+double MeasureLatencyUs(int num_tasks, Func spawn_and_join) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_tasks; i++) {
+        spawn_and_join();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(stop - start).count() / num_tasks;
+}
+
+// Compares starting and joining tasks with std::thread, std::async and the
+// pool, first one at a time and then a batch of tasks at once, and compares
+// ParallelFor with one std::thread per chunk on a small loop.
+// 比较用std::thread、std::async和线程池启动并join任务的开销，先是每次一个，然后是
+// 一次一批，并在一个小循环上比较ParallelFor与每块一个std::thread的做法。
+void RunBenchmark() {
+    const int num_tasks = 2000;
+    ThreadPool pool;
+    std::atomic<int64_t> sink{0};
+    auto task = [&sink] { sink.fetch_add(1, std::memory_order_relaxed); };
+
+    std::cout << "Spawn and join latency in us per task (" << pool.num_workers() << " workers):\n";
+    double thread_us = MeasureLatencyUs(num_tasks, [&] { std::thread(task).join(); });
+    double async_us = MeasureLatencyUs(num_tasks, [&] { std::async(std::launch::async, task).get(); });
+    double pool_us = MeasureLatencyUs(num_tasks, [&] { pool.Submit(task).get(); });
+    std::cout << "  one at a time: std::thread " << thread_us << ", std::async " << async_us << ", ThreadPool "
+              << pool_us << "\n";
+
+    const int batch = 100;
+    thread_us = MeasureLatencyUs(num_tasks / batch, [&] {
+                    std::vector<std::thread> threads;
+                    for (int i = 0; i < batch; i++) {
+                        threads.emplace_back(task);
+                    }
+                    for (std::thread &thread: threads) {
+                        thread.join();
+                    }
+                }) / batch;
+    async_us = MeasureLatencyUs(num_tasks / batch, [&] {
+                   std::vector<std::future<void>> futures;
+                   for (int i = 0; i < batch; i++) {
+                       futures.push_back(std::async(std::launch::async, task));
+                   }
+                   for (std::future<void> &future: futures) {
+                       future.get();
+                   }
+               }) / batch;
+    pool_us = MeasureLatencyUs(num_tasks / batch, [&] {
+                  std::vector<std::future<void>> futures;
+                  for (int i = 0; i < batch; i++) {
+                      futures.push_back(pool.Submit(task));
+                  }
+                  for (std::future<void> &future: futures) {
+                      future.get();
+                  }
+              }) / batch;
+    std::cout << "  batches of " << batch << ": std::thread " << thread_us << ", std::async " << async_us
+              << ", ThreadPool " << pool_us << "\n";
+
+    // Sums the squares of 0..n-1 in chunks of grain elements.
+    // 以每块grain个元素的方式计算0..n-1的平方和。
+    const size_t n = 1 << 20;
+    const size_t grain = 1 << 12;
+    std::vector<int64_t> partial(n / grain);
+    auto sum_chunk = [&partial, grain](size_t chunk) {
+        int64_t sum = 0;
+        for (size_t i = chunk * grain; i < (chunk + 1) * grain; i++) {
+            sum += static_cast<int64_t>(i) * static_cast<int64_t>(i);
+        }
+        partial[chunk] = sum;
+    };
+    double threads_ms = MeasureLatencyUs(1, [&] {
+                            std::vector<std::thread> threads;
+                            for (size_t chunk = 0; chunk < partial.size(); chunk++) {
+                                threads.emplace_back(sum_chunk, chunk);
+                            }
+                            for (std::thread &thread: threads) {
+                                thread.join();
+                            }
+                        }) / 1000;
+    int64_t threads_sum = std::accumulate(partial.begin(), partial.end(), int64_t{0});
+    double pool_ms = MeasureLatencyUs(1, [&] { pool.ParallelFor(0, partial.size(), 1, sum_chunk); }) / 1000;
+    int64_t pool_sum = std::accumulate(partial.begin(), partial.end(), int64_t{0});
+    std::cout << "Sum of squares in " << partial.size() << " chunks: one std::thread per chunk " << threads_ms
+              << " ms, ParallelFor " << pool_ms << " ms" << (threads_sum == pool_sum ? "" : " (sums differ!)")
+              << "\n";
+}
+
+int main() {
+    // The pool size is chosen when it is constructed, the default is one
+    // worker per hardware thread.
+    // 线程池的大小在构造时确定，默认是每个硬件线程一个工作线程。
+    ThreadPool pool(4);
+
+    std::future<void> f1 = pool.Submit(add_count);
+    std::future<void> f2 = pool.Submit(add_count);
+    f1.get();
+    f2.get();
+    std::cout << "Printing count: " << count << std::endl;
+
+    // Submit forwards arguments and returns the result through the future.
+    // Submit会转发参数，并通过future返回结果。
+    std::future<int> square = pool.Submit([](int x) { return x * x; }, 12);
+    std::cout << "12 squared is " << square.get() << std::endl;
+
+    // Exceptions thrown by a task come out of future::get.
+    // 任务抛出的异常会从future::get中出来。
+    std::future<void> failing = pool.Submit([] { throw std::runtime_error("task failed"); });
+    try {
+        failing.get();
+    } catch (const std::runtime_error &e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+
+    std::vector<int> values(1000);
+    pool.ParallelFor(0, values.size(), 64, [&values](size_t i) { values[i] = static_cast<int>(i); });
+    std::cout << "ParallelFor filled values, sum " << std::accumulate(values.begin(), values.end(), 0) << std::endl;
+
+    RunBenchmark();
+
+    return 0;
+}
@@ -0,0 +1,414 @@
+/**
+ * @file upgradeable_shared_mutex.cpp
+ * @brief Tutorial code for a reader-writer lock with a choice of preference,
+ * upgrades and downgrades.
+ * @brief 可选择优先策略、支持升级和降级的读写锁的教程代码。
+ */
+
+// std::shared_mutex (rwlock.cpp) leaves two things open. First, it does not
+// promise whether a waiting writer goes before readers that arrive later.
+// If readers win, a steady stream of readers can keep a writer waiting
+// forever ("writer starvation"). Second, a thread that holds a shared lock
+// and decides it needs to write must unlock and lock exclusively, and another
+// writer may get in between, so it has to check again what it read before.
+// std::shared_mutex（rwlock.cpp）留下了两个问题没有解决。首先，它不保证一个等待中的
+// 写者是否排在之后到达的读者前面。如果读者获胜，源源不断的读者可能让一个写者永远
+// 等待下去（"写者饥饿"）。其次，一个持有共享锁的线程如果决定需要写入，就必须先解锁
+// 再独占加锁，而另一个写者可能在这期间插进来，所以它必须重新检查之前读到的内容。
+
+// UpgradeableSharedMutex lets the user choose the policy:
+//   kReaderPreferring: readers enter whenever no writer holds the lock.
+//   kWriterPreferring: readers wait while any writer is waiting.
+//   kPhaseFair: readers wait behind a waiting writer, but when that writer
+//               finishes, every reader that waited enters before the next
+//               writer, so neither side starves.
+// UpgradeableSharedMutex让用户选择策略：
+//   kReaderPreferring：只要没有写者持有锁，读者就可以进入。
+//   kWriterPreferring：只要有写者在等待，读者就要等待。
+//   kPhaseFair：读者排在等待中的写者后面，但当那个写者完成时，所有等待过的读者都会
+//               在下一个写者之前进入，所以双方都不会饿死。
+
+// It also has a third mode, "upgrade", as in Boost.Thread. An upgrade lock is
+// compatible with shared locks but not with another upgrade lock or an
+// exclusive lock. Because at most one thread holds it, that thread can turn it
+// into an exclusive lock atomically, with no other writer in between, and an
+// exclusive lock can be turned back into an upgrade or shared lock.
+// 它还有第三种模式"升级"，和Boost.Thread中一样。升级锁与共享锁兼容，但与另一个升级锁
+// 或独占锁不兼容。因为最多只有一个线程持有它，这个线程可以原子地把它变成独占锁，期间
+// 不会有其他写者插进来，而独占锁也可以变回升级锁或共享锁。
+
+// Includes std::sort.
+// 包含std::sort。
+#include <algorithm>
+// Includes std::atomic.
+// 包含std::atomic。
+#include <atomic>
+// Includes std::chrono for timing the benchmarks.
+// 包含std::chrono，用于对基准测试计时。
+#include <chrono>
+// Includes std::condition_variable, which waiting threads block on.
+// 包含std::condition_variable，等待中的线程阻塞在它上面。
+#include <condition_variable>
+// Includes fixed width integer types such as uint64_t.
+// 包含uint64_t等定宽整数类型。
+#include <cstdint>
+// Includes std::cout (printing) for demo purposes.
+// 包含std::cout（打印）用于演示目的。
+#include <iostream>
+// Includes the mutex library header.
+// 包含互斥锁库头文件。
+#include <mutex>
+// Includes the shared mutex library header.
+// 包含共享互斥锁库头文件。
+#include <shared_mutex>
+// Includes the C++ string library.
+// 包含C++字符串库。
+#include <string>
+// Includes the thread library header.
+// 包含线程库头文件。
+#include <thread>
+// Includes the vector container library header.
+// 包含vector容器库头文件。
+#include <vector>
+
+enum class Preference { kReaderPreferring, kWriterPreferring, kPhaseFair };
+
+// The lock's state is kept under an internal std::mutex, and threads wait on
+// two condition variables: one for threads that want to enter alongside
+// readers (shared and upgrade) and one for threads that need the lock to
+// themselves (writers and upgrading threads). That is slower than an atomic
+// lock word but keeps every policy easy to read.
+// 锁的状态保存在一个内部的std::mutex之下，线程在两个条件变量上等待：一个给想和读者
+// 一起进入的线程（共享和升级），一个给需要独占锁的线程（写者和正在升级的线程）。这比
+// 原子锁字要慢，但让每种策略都容易阅读。
+class UpgradeableSharedMutex {
+public:
+    explicit UpgradeableSharedMutex(Preference preference = Preference::kWriterPreferring)
+        : preference_(preference) {}
+
+    UpgradeableSharedMutex(const UpgradeableSharedMutex &) = delete;
+    UpgradeableSharedMutex &operator=(const UpgradeableSharedMutex &) = delete;
+
+    void lock_shared() {
+        std::unique_lock lock(m_);
+        WaitToRead(lock);
+        readers_++;
+    }
+
+    void unlock_shared() {
+        std::unique_lock lock(m_);
+        readers_--;
+        if (readers_ == 0) {
+            writer_cv_.notify_all();
+        }
+    }
+
+    void lock() {
+        std::unique_lock lock(m_);
+        waiting_writers_++;
+        writer_cv_.wait(lock, [this] {
+            return !writer_ && !upgrader_ && readers_ == 0 && admitted_readers_ == 0;
+        });
+        waiting_writers_--;
+        writer_ = true;
+    }
+
+    void unlock() {
+        std::unique_lock lock(m_);
+        writer_ = false;
+        AdmitWaitingReaders();
+        reader_cv_.notify_all();
+        writer_cv_.notify_all();
+    }
+
+    // An upgrade lock waits like a reader and also for the current upgrade
+    // lock holder, if any.
+    // 升级锁像读者一样等待，如果当前有升级锁的持有者，它还要等待那个持有者。
+    void lock_upgrade() {
+        std::unique_lock lock(m_);
+        WaitToRead(lock, true);
+        upgrader_ = true;
+    }
+
+    void unlock_upgrade() {
+        std::unique_lock lock(m_);
+        upgrader_ = false;
+        reader_cv_.notify_all();
+        writer_cv_.notify_all();
+    }
+
+    // Turns the caller's upgrade lock into an exclusive lock, waiting for the
+    // current readers to leave. No writer can get in first, since writers wait
+    // for the upgrade lock to be released. While it waits, the caller counts
+    // as a waiting writer, so under kWriterPreferring and kPhaseFair no new
+    // readers enter.
+    // 把调用者的升级锁变成独占锁，等待当前的读者离开。没有写者能抢先进入，因为写者要
+    // 等待升级锁被释放。在等待期间，调用者被视为一个等待中的写者，所以在
+    // kWriterPreferring和kPhaseFair下不会有新的读者进入。
+    void unlock_upgrade_and_lock() {
+        std::unique_lock lock(m_);
+        waiting_writers_++;
+        writer_cv_.wait(lock, [this] { return readers_ == 0 && admitted_readers_ == 0; });
+        waiting_writers_--;
+        upgrader_ = false;
+        writer_ = true;
+    }
+
+    // Downgrades an exclusive lock to an upgrade lock or a shared lock without
+    // ever releasing it, so no writer can change the data in between.
+    // 把独占锁降级为升级锁或共享锁，期间从不释放它，所以没有写者能在这期间修改数据。
+    void unlock_and_lock_upgrade() {
+        std::unique_lock lock(m_);
+        writer_ = false;
+        upgrader_ = true;
+        AdmitWaitingReaders();
+        reader_cv_.notify_all();
+    }
+
+    void unlock_and_lock_shared() {
+        std::unique_lock lock(m_);
+        writer_ = false;
+        readers_++;
+        AdmitWaitingReaders();
+        reader_cv_.notify_all();
+        writer_cv_.notify_all();
+    }
+
+private:
+    // Blocks until a reader (or, with upgrade, an upgrade locker) may enter
+    // under the chosen preference. Upgrade lockers are not admitted in
+    // batches under kPhaseFair: one of them could still be waiting for the
+    // current upgrade lock holder, and that holder's upgrade waits for the
+    // admitted batch, so neither would ever move.
+    // 阻塞直到读者（或者当upgrade为true时，升级锁的获取者）在所选的优先策略下可以进入。
+    // 在kPhaseFair下，升级锁的获取者不会被成批地准许进入：它们中的一个可能仍在等待当前
+    // 升级锁的持有者，而那个持有者的升级又在等待这批被准许的线程，这样双方都永远无法
+    // 前进。
+    void WaitToRead(std::unique_lock<std::mutex> &lock, bool upgrade = false) {
+        uint64_t arrival_phase = phase_;
+        if (!upgrade) {
+            waiting_readers_++;
+        }
+        reader_cv_.wait(lock, [this, upgrade, arrival_phase] {
+            if (writer_ || (upgrade && upgrader_)) {
+                return false;
+            }
+            switch (preference_) {
+                case Preference::kReaderPreferring:
+                    return true;
+                case Preference::kWriterPreferring:
+                    return waiting_writers_ == 0;
+                case Preference::kPhaseFair:
+                    return waiting_writers_ == 0 || (!upgrade && arrival_phase != phase_);
+            }
+            return true;
+        });
+        if (upgrade) {
+            return;
+        }
+        waiting_readers_--;
+        if (arrival_phase != phase_ && admitted_readers_ > 0) {
+            admitted_readers_--;
+            if (admitted_readers_ == 0) {
+                writer_cv_.notify_all();
+            }
+        }
+    }
+
+    // Under kPhaseFair, a writer leaving starts a new phase: every reader that
+    // is waiting now may enter, and writers wait until all of them have.
+    // 在kPhaseFair下，写者离开时会开始一个新的阶段：此刻正在等待的每个读者都可以进入，
+    // 而写者要等到它们全部进入之后。
+    void AdmitWaitingReaders() {
+        if (preference_ == Preference::kPhaseFair && waiting_readers_ > 0) {
+            phase_++;
+            admitted_readers_ = waiting_readers_;
+        }
+    }
+
+    const Preference preference_;
+    std::mutex m_;
+    std::condition_variable reader_cv_;
+    std::condition_variable writer_cv_;
+    int readers_ = 0;
+    bool writer_ = false;
+    bool upgrader_ = false;
+    int waiting_readers_ = 0;
+    int waiting_writers_ = 0;
+    uint64_t phase_ = 0;
+    int admitted_readers_ = 0;
+};
+
+// UpgradeLock is the RAII guard for upgrade mode, like std::shared_lock is for
+// shared mode. Upgrade and Downgrade switch between upgrade and exclusive
+// mode, and the destructor releases whichever mode is held.
+// UpgradeLock是升级模式的RAII守卫，就像std::shared_lock之于共享模式。Upgrade和
+// Downgrade在升级模式和独占模式之间切换，析构函数释放当前持有的模式。
+class UpgradeLock {
+public:
+    explicit UpgradeLock(UpgradeableSharedMutex &mutex) : mutex_(mutex) { mutex_.lock_upgrade(); }
+
+    ~UpgradeLock() {
+        if (exclusive_) {
+            mutex_.unlock();
+        } else {
+            mutex_.unlock_upgrade();
+        }
+    }
+
+    UpgradeLock(const UpgradeLock &) = delete;
+    UpgradeLock &operator=(const UpgradeLock &) = delete;
+
+    void Upgrade() {
+        if (!exclusive_) {
+            mutex_.unlock_upgrade_and_lock();
+            exclusive_ = true;
+        }
+    }
+
+    void Downgrade() {
+        if (exclusive_) {
+            mutex_.unlock_and_lock_upgrade();
+            exclusive_ = false;
+        }
+    }
+
+private:
+    UpgradeableSharedMutex &mutex_;
+    bool exclusive_ = false;
+};
+
+// The program of rwlock.cpp, with m now an UpgradeableSharedMutex.
+// rwlock.cpp中的程序，只是m现在是一个UpgradeableSharedMutex。
+int count = 0;
+UpgradeableSharedMutex m;
+
+void read_value() {
+    std::shared_lock lk(m);
+    std::cout << "Reading value " + std::to_string(count) + "\n" << std::flush;
+}
+
+void write_value() {
+    std::unique_lock lk(m);
+    count += 3;
+}
+
+// Makes count even if it is odd. The check and the write happen under one
+// lock, so no other writer can make count even in between, and readers keep
+// running while the check is done.
+// 如果count是奇数就把它变成偶数。检查和写入在同一个锁下进行，所以其他写者不能在期间
+// 把count变成偶数，并且在检查期间读者可以继续运行。
+void make_even() {
+    UpgradeLock lk(m);
+    if (count % 2 == 1) {
+        lk.Upgrade();
+        count += 1;
+    }
+}
+
+// Runs num_readers threads that hold the shared lock back to back for
+// duration_ms, and one writer that takes the exclusive lock every 100
+// microseconds. Prints percentiles of the writer's wait to acquire the lock,
+// and the readers' throughput.
+// 运行num_readers个线程，它们在duration_ms时间内一个接一个地持有共享锁，还有一个写者
+// 每100微秒获取一次独占锁。打印写者获取锁的等待时间的百分位数，以及读者的吞吐量。
+template<typename Mutex>
+void RunReadFlood(const std::string &name, Mutex &mutex, int num_readers, int duration_ms) {
+    std::atomic<bool> stop{false};
+    std::atomic<int64_t> reads{0};
+    int64_t value = 0;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < num_readers; t++) {
+        readers.emplace_back([&mutex, &stop, &reads, &value] {
+            int64_t local_reads = 0;
+            int64_t sum = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::shared_lock lock(mutex);
+                for (int i = 0; i < 100; i++) {
+                    sum += value;
+                }
+                local_reads++;
+            }
+            reads += local_reads + (sum < 0 ? 1 : 0);
+        });
+    }
+
+    // The writer runs until the main thread says stop, not until a deadline
+    // it checks itself: under reader preference it may be stuck in lock()
+    // until the readers stop.
+    // 写者一直运行到主线程叫它停止，而不是运行到它自己检查的截止时间：在读者优先策略下，
+    // 它可能一直卡在lock()中，直到读者停止。
+    std::vector<double> waits_us;
+    std::thread writer([&mutex, &stop, &value, &waits_us] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            auto start = std::chrono::steady_clock::now();
+            {
+                std::unique_lock lock(mutex);
+                waits_us.push_back(
+                        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+                value++;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    stop = true;
+    writer.join();
+    for (std::thread &reader: readers) {
+        reader.join();
+    }
+
+    std::sort(waits_us.begin(), waits_us.end());
+    auto percentile = [&waits_us](double p) { return waits_us[static_cast<size_t>(p * (waits_us.size() - 1))]; };
+    std::cout << "    " << name << ": writer wait p50 " << percentile(0.5) << " us, p99 " << percentile(0.99)
+              << " us, max " << waits_us.back() << " us over " << waits_us.size() << " writes; "
+              << reads * 1000 / duration_ms << " reads/s\n";
+}
+
+void RunBenchmark() {
+    const int duration_ms = 300;
+    std::cout << "Writer latency under a read flood (" << std::thread::hardware_concurrency()
+              << " hardware threads):\n";
+    for (int num_readers: {4, 16}) {
+        std::cout << "  " << num_readers << " readers:\n";
+        std::shared_mutex shared_mutex;
+        RunReadFlood("std::shared_mutex", shared_mutex, num_readers, duration_ms);
+        UpgradeableSharedMutex reader_preferring(Preference::kReaderPreferring);
+        RunReadFlood("kReaderPreferring", reader_preferring, num_readers, duration_ms);
+        UpgradeableSharedMutex writer_preferring(Preference::kWriterPreferring);
+        RunReadFlood("kWriterPreferring", writer_preferring, num_readers, duration_ms);
+        UpgradeableSharedMutex phase_fair(Preference::kPhaseFair);
+        RunReadFlood("kPhaseFair", phase_fair, num_readers, duration_ms);
+    }
+}
+
+int main() {
+    // The threads of rwlock.cpp, plus one that makes count even.
+    // rwlock.cpp中的线程，再加上一个把count变成偶数的线程。
+    std::thread t1(read_value);
+    std::thread t2(write_value);
+    std::thread t3(read_value);
+    std::thread t4(make_even);
+    std::thread t5(write_value);
+    std::thread t6(read_value);
+
+    t1.join();
+    t2.join();
+    t3.join();
+    t4.join();
+    t5.join();
+    t6.join();
+
+    // An exclusive lock downgraded to shared: the value written is still
+    // there when it is read back, since no writer could run in between.
+    // 一个被降级为共享锁的独占锁：读回时写入的值仍然在那里，因为期间没有写者可以运行。
+    m.lock();
+    count = 100;
+    m.unlock_and_lock_shared();
+    std::cout << "After downgrading, count is " << count << std::endl;
+    m.unlock_shared();
+
+    RunBenchmark();
+
+    return 0;
+}